@@ -1,9 +1,10 @@
 #pragma once
+#include "EntityHandle.h"
 #include "Global.h"
 
 /*
 * Base class for all entities that are spawned to do work during the Simulation.
-* Houses basic functions to change the location and set Ids of the Entities etc.
+* Houses basic functions to change the location of the Entities etc.
 */
 class BaseEntity
 {
@@ -28,17 +29,27 @@ public:
 		Location = newLocation;
 	}
 
-	void SetUniqueId(int id)
+private:
+	Vector Location;
+};
+
+/*
+* Base class for entities owned by an EntityPool. Each entity knows its own typed handle, so it can identify itself in callbacks.
+*/
+template<typename T>
+class TypedEntity : public BaseEntity
+{
+public:
+	EntityHandle<T> GetHandle() const
 	{
-		UniqueId = id;
+		return Handle;
 	}
 
-	int GetUniqueId()
+	void SetHandle(EntityHandle<T> handle)
 	{
-		return UniqueId;
+		Handle = handle;
 	}
 
 private:
-	int UniqueId = -1;
-	Vector Location;
+	EntityHandle<T> Handle;
 };
@@ -0,0 +1,59 @@
+#include "BatchMeansEstimator.h"
+
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	// Two sided 95% Student's t critical values for 1 to 30 degrees of freedom. Beyond that the normal value is close enough.
+	const double StudentT95[] = {
+		12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+		2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+		2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+	};
+	constexpr double Normal95 = 1.960;
+}
+
+/*
+* Adds the mean of one finished batch.
+*/
+void BatchMeansEstimator::AddBatch(double batchMean)
+{
+	++NumBatches;
+	double deviation = batchMean - Mean;
+	Mean += deviation / NumBatches;
+	SumSquaredDeviations += deviation * (batchMean - Mean);
+}
+
+void BatchMeansEstimator::Reset()
+{
+	NumBatches = 0;
+	Mean = 0.0;
+	SumSquaredDeviations = 0.0;
+}
+
+unsigned int BatchMeansEstimator::GetNumBatches() const
+{
+	return NumBatches;
+}
+
+double BatchMeansEstimator::GetMean() const
+{
+	return Mean;
+}
+
+/*
+* t * s / sqrt(n), with s the sample standard deviation of the batch means.
+*/
+double BatchMeansEstimator::GetConfidenceHalfWidth() const
+{
+	if (NumBatches < 2)
+	{
+		return std::numeric_limits<double>::infinity();
+	}
+
+	unsigned int degreesOfFreedom = NumBatches - 1;
+	double criticalValue = degreesOfFreedom <= 30 ? StudentT95[degreesOfFreedom - 1] : Normal95;
+	double variance = SumSquaredDeviations / degreesOfFreedom;
+	return criticalValue * sqrt(variance / NumBatches);
+}
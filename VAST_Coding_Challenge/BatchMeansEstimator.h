@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+
+/*
+* Batch means estimate of a steady state rate, with a 95% confidence interval.
+* The run is cut into consecutive batches of equal length, and the mean rate of each batch is treated as one (roughly independent) sample.
+* Batches have to be long compared to a truck's mine-and-unload cycle for that to hold.
+*/
+class BatchMeansEstimator
+{
+public:
+	BatchMeansEstimator() = default;
+	~BatchMeansEstimator() = default;
+
+	void AddBatch(double batchMean);
+	void Reset();
+
+	unsigned int GetNumBatches() const;
+	double GetMean() const;
+
+	// Half width of the 95% confidence interval of the mean. Infinite until there are at least two batches.
+	double GetConfidenceHalfWidth() const;
+
+private:
+	// Running mean and sum of squared deviations (Welford), so no batch has to be stored.
+	unsigned int NumBatches = 0;
+	double Mean = 0.0;
+	double SumSquaredDeviations = 0.0;
+};
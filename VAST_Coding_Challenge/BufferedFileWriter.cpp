@@ -0,0 +1,130 @@
+#include "BufferedFileWriter.h"
+
+#include <cstdarg>
+#include <cstring>
+
+BufferedFileWriter::BufferedFileWriter(size_t bufferSize /* = 1 << 20 */)
+	: Buffer(bufferSize)
+{
+}
+
+BufferedFileWriter::~BufferedFileWriter()
+{
+	Close();
+}
+
+/*
+* Opens (and truncates) the output file. Pass "-" to write to stdout.
+*/
+bool BufferedFileWriter::Open(const std::string& path, bool binary /* = false */)
+{
+	Close();
+	WriteFailed = false;
+
+	if (path == "-")
+	{
+		File = stdout;
+		return true;
+	}
+
+#ifdef _WIN32
+	if (fopen_s(&File, path.c_str(), binary ? "wb" : "w") != 0)
+	{
+		File = nullptr;
+	}
+#else
+	File = fopen(path.c_str(), binary ? "wb" : "w");
+#endif
+	return File != nullptr;
+}
+
+/*
+* Flushes anything still buffered and closes the file. fclose() writes out the C runtime's own buffer, so it can fail too.
+*/
+bool BufferedFileWriter::Close()
+{
+	if (!File)
+	{
+		return !WriteFailed;
+	}
+
+	Flush();
+	int result = File != stdout ? fclose(File) : fflush(File);
+	if (result != 0)
+	{
+		WriteFailed = true;
+	}
+	File = nullptr;
+	return !WriteFailed;
+}
+
+bool BufferedFileWriter::IsOpen() const
+{
+	return File != nullptr;
+}
+
+void BufferedFileWriter::Write(const void* data, size_t size)
+{
+	if (BufferUsed + size > Buffer.size())
+	{
+		Flush();
+
+		// Larger than the whole buffer, no point copying it.
+		if (size > Buffer.size())
+		{
+			if (File && fwrite(data, 1, size, File) != size)
+			{
+				WriteFailed = true;
+			}
+			return;
+		}
+	}
+
+	memcpy(Buffer.data() + BufferUsed, data, size);
+	BufferUsed += size;
+}
+
+void BufferedFileWriter::Write(const std::string& text)
+{
+	Write(text.data(), text.size());
+}
+
+void BufferedFileWriter::WriteFormatted(const char* format, ...)
+{
+	va_list arguments;
+	va_start(arguments, format);
+	int length = vsnprintf(Buffer.data() + BufferUsed, Buffer.size() - BufferUsed, format, arguments);
+	va_end(arguments);
+
+	if (length < 0)
+	{
+		return;
+	}
+
+	if (BufferUsed + static_cast<size_t>(length) < Buffer.size())
+	{
+		BufferUsed += static_cast<size_t>(length);
+		return;
+	}
+
+	// Didn't fit in what was left of the buffer. Flush and format again, either into the buffer or a temporary if it's huge.
+	Flush();
+	std::vector<char> text(static_cast<size_t>(length) + 1);
+	va_start(arguments, format);
+	vsnprintf(text.data(), text.size(), format, arguments);
+	va_end(arguments);
+	Write(text.data(), static_cast<size_t>(length));
+}
+
+/*
+* Writes the buffered bytes to the file.
+*/
+bool BufferedFileWriter::Flush()
+{
+	if (File && BufferUsed > 0 && fwrite(Buffer.data(), 1, BufferUsed, File) != BufferUsed)
+	{
+		WriteFailed = true;
+	}
+	BufferUsed = 0;
+	return !WriteFailed;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/*
+* Output file with a large in-memory buffer. Small writes are appended to the buffer and reach the file in big blocks.
+*/
+class BufferedFileWriter
+{
+public:
+	explicit BufferedFileWriter(size_t bufferSize = 1 << 20);
+	~BufferedFileWriter();
+
+	BufferedFileWriter(const BufferedFileWriter&) = delete;
+	BufferedFileWriter& operator=(const BufferedFileWriter&) = delete;
+
+	bool Open(const std::string& path, bool binary = false);
+	// Returns false if anything written since Open() failed to reach the file (e.g. the disk is full), or the file failed to close.
+	bool Close();
+	bool IsOpen() const;
+
+	void Write(const void* data, size_t size);
+	void Write(const std::string& text);
+
+	// Writes printf style formatted text straight into the buffer.
+	void WriteFormatted(const char* format, ...);
+
+	// Returns false if any write since Open() has failed.
+	bool Flush();
+
+private:
+	FILE* File = nullptr;
+	std::vector<char> Buffer;
+	size_t BufferUsed = 0;
+
+	// Set by the first failed write and kept until the next Open(), so an error part way through isn't hidden by the writes after it.
+	bool WriteFailed = false;
+};
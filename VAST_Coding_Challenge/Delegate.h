@@ -1,5 +1,9 @@
 #pragma once
+#include "MemoryAccounting.h"
+
 #include <functional>
+#include <type_traits>
+#include <utility>
 
 // Define a Delegate class with a variable number of template arguments. 
 // With this definition we can bind callback functions (lambdas) that can invoke the callbacks with a variable number of arguments (0 or more).
@@ -8,12 +12,28 @@ class Delegate
 {
 public:
 	Delegate() = default;
-	~Delegate() = default;
+
+	~Delegate()
+	{
+		Unbind();
+	}
+
+	// A bound delegate is owned by one object. Copying it would count its callable twice in the memory accounting.
+	Delegate(const Delegate&) = delete;
+	Delegate& operator=(const Delegate&) = delete;
 
 	// Bind a callback function (lambda) that can accept a variable number of arguments.
-	void Bind(std::function<void(Args...)> function)
+	// The callable is counted against the Delegates memory subsystem while it is bound.
+	template<typename Function>
+	void Bind(Function&& function)
 	{
-		Callback = std::move(function);
+		Unbind();
+		Callback = std::forward<Function>(function);
+		if (Callback)
+		{
+			BoundBytes = sizeof(typename std::decay<Function>::type);
+			MemoryAccounting::RecordAllocation(EMemorySubsystem::Delegates, BoundBytes);
+		}
 	}
 
 	bool IsBound() const
@@ -26,6 +46,8 @@ public:
 		if (Callback)
 		{
 			Callback = nullptr;
+			MemoryAccounting::RecordDeallocation(EMemorySubsystem::Delegates, BoundBytes);
+			BoundBytes = 0;
 		}
 	}
 
@@ -40,4 +62,7 @@ public:
 private:
 	// Callback with return type void, and a variable number of arguments.
 	std::function<void(Args...)> Callback;
-};
\ No newline at end of file
+
+	// Size of the bound callable. std::function keeps small callables inline, so this is what the binding costs rather than a heap allocation.
+	size_t BoundBytes = 0;
+};
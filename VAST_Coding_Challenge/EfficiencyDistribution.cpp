@@ -0,0 +1,159 @@
+#include "EfficiencyDistribution.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+constexpr double EfficiencyDistribution::BinGrowth;
+constexpr double EfficiencyDistribution::MinTrackedEfficiency;
+constexpr size_t EfficiencyDistribution::NumBins;
+constexpr size_t EfficiencyDistribution::NumHistogramRows;
+
+namespace
+{
+	// Width of the longest histogram bar, in characters.
+	constexpr size_t HistogramBarWidth = 40;
+}
+
+EfficiencyDistribution EfficiencyDistribution::Build(const std::vector<float>& efficiencies)
+{
+	EfficiencyDistribution distribution;
+	for (float efficiency : efficiencies)
+	{
+		distribution.Add(efficiency);
+	}
+
+	return distribution;
+}
+
+void EfficiencyDistribution::Add(float efficiency)
+{
+	Min = Count == 0 ? efficiency : std::min(Min, efficiency);
+	Max = Count == 0 ? efficiency : std::max(Max, efficiency);
+	Sum += efficiency;
+	++Count;
+	++Bins[GetBin(efficiency)];
+}
+
+uint64_t EfficiencyDistribution::GetCount() const
+{
+	return Count;
+}
+
+float EfficiencyDistribution::GetMin() const
+{
+	return Min;
+}
+
+float EfficiencyDistribution::GetMax() const
+{
+	return Max;
+}
+
+double EfficiencyDistribution::GetMean() const
+{
+	return Count > 0 ? Sum / static_cast<double>(Count) : 0.0;
+}
+
+/*
+* Interpolates between the values either side of the percentile's rank, as most tools do.
+*/
+float EfficiencyDistribution::GetPercentile(double percentile) const
+{
+	if (Count == 0)
+	{
+		return 0.0f;
+	}
+
+	double rank = std::min(std::max(percentile, 0.0), 100.0) / 100.0 * static_cast<double>(Count - 1);
+	uint64_t lowerRank = static_cast<uint64_t>(rank);
+	uint64_t upperRank = std::min(lowerRank + 1, Count - 1);
+	double fraction = rank - static_cast<double>(lowerRank);
+	return static_cast<float>(GetValueAtRank(lowerRank) * (1.0 - fraction) + GetValueAtRank(upperRank) * fraction);
+}
+
+void EfficiencyDistribution::Print(const char* label) const
+{
+	if (Count == 0)
+	{
+		std::cout << label << " efficiency: none.\n";
+		return;
+	}
+
+	char line[256];
+	snprintf(line, sizeof(line), "%s efficiency (%llu): min %.4g, p1 %.4g, p50 %.4g, p99 %.4g, max %.4g, mean %.4g\n", label,
+			 static_cast<unsigned long long>(Count), Min, GetPercentile(1.0), GetPercentile(50.0), GetPercentile(99.0), Max, GetMean());
+	std::cout << line;
+
+	// Regroup the bins into evenly spaced rows between min and max. All the values in one bin go to the row holding the bin's middle.
+	// No more rows than bins, the bins can't tell apart values any closer than that.
+	size_t numRows = std::min(NumHistogramRows, GetBin(Max) - GetBin(Min) + 1);
+	double rowWidth = (static_cast<double>(Max) - Min) / numRows;
+	std::array<uint64_t, NumHistogramRows> rows{};
+	for (size_t bin = GetBin(Min); bin <= GetBin(Max); ++bin)
+	{
+		double binMiddle = std::min(std::max(0.5 * (GetBinStart(bin) + GetBinStart(bin + 1)), static_cast<double>(Min)), static_cast<double>(Max));
+		size_t row = rowWidth > 0.0 ? static_cast<size_t>((binMiddle - Min) / rowWidth) : 0;
+		rows[std::min(row, numRows - 1)] += Bins[bin];
+	}
+
+	uint64_t largestRow = *std::max_element(rows.begin(), rows.begin() + numRows);
+	for (size_t row = 0; row < numRows; ++row)
+	{
+		size_t barLength = static_cast<size_t>((rows[row] * HistogramBarWidth + largestRow - 1) / largestRow);
+		char range[64];
+		snprintf(range, sizeof(range), "[%.4g, %.4g%c", Min + row * rowWidth, Min + (row + 1) * rowWidth, row + 1 < numRows ? ')' : ']');
+		snprintf(line, sizeof(line), "  %-22s %10llu ", range, static_cast<unsigned long long>(rows[row]));
+		std::cout << line << std::string(barLength, '#') << '\n';
+	}
+}
+
+/*
+* Finds the bin holding the rank'th smallest value, and assumes the values in that bin are spread evenly across it.
+*/
+double EfficiencyDistribution::GetValueAtRank(uint64_t rank) const
+{
+	if (rank == 0)
+	{
+		return Min;
+	}
+	if (rank + 1 >= Count)
+	{
+		return Max;
+	}
+
+	uint64_t numBelow = 0;
+	for (size_t bin = 0; bin < NumBins; ++bin)
+	{
+		if (numBelow + Bins[bin] > rank)
+		{
+			double fraction = (static_cast<double>(rank - numBelow) + 0.5) / static_cast<double>(Bins[bin]);
+			double value = GetBinStart(bin) + fraction * (GetBinStart(bin + 1) - GetBinStart(bin));
+			return std::min(std::max(value, static_cast<double>(Min)), static_cast<double>(Max));
+		}
+		numBelow += Bins[bin];
+	}
+
+	return Max;
+}
+
+/*
+* Bin 0 holds everything below MinTrackedEfficiency, the last bin everything from its start up.
+*/
+size_t EfficiencyDistribution::GetBin(double efficiency)
+{
+	if (!(efficiency > MinTrackedEfficiency))
+	{
+		return 0;
+	}
+
+	size_t bin = 1 + static_cast<size_t>(log(efficiency / MinTrackedEfficiency) / log(BinGrowth));
+	return std::min(bin, NumBins - 1);
+}
+
+double EfficiencyDistribution::GetBinStart(size_t bin)
+{
+	return bin == 0 ? 0.0 : MinTrackedEfficiency * pow(BinGrowth, static_cast<double>(bin - 1));
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+* Summary of a set of per truck or per station efficiencies: min, max, mean, percentiles and a histogram, built in one streaming pass.
+* Values are counted into logarithmically spaced bins over [MinTrackedEfficiency, 1], so the summary of a million trucks takes no more memory
+* than the summary of ten, and nothing is sorted. Percentiles are interpolated within their bin, which keeps them within BinGrowth of the
+* true value whether efficiencies are near 1 (stations) or a few thousandths (trucks in a huge fleet). Min, max and mean are exact.
+*/
+class EfficiencyDistribution
+{
+public:
+	// Each bin is this much wider than the one before it, so percentiles are accurate to about 1%.
+	static constexpr double BinGrowth = 1.01;
+	static constexpr double MinTrackedEfficiency = 1e-6;
+	static constexpr size_t NumBins = 1400;
+
+	// Rows of the printed histogram, spread evenly over [min, max] so a tightly packed fleet still shows its shape.
+	static constexpr size_t NumHistogramRows = 10;
+
+	EfficiencyDistribution() = default;
+
+	static EfficiencyDistribution Build(const std::vector<float>& efficiencies);
+
+	void Add(float efficiency);
+
+	uint64_t GetCount() const;
+	float GetMin() const;
+	float GetMax() const;
+	double GetMean() const;
+
+	// percentile in [0, 100]. 0 with no values.
+	float GetPercentile(double percentile) const;
+
+	// One line of statistics and NumHistogramRows histogram lines, labelled e.g. "Truck".
+	void Print(const char* label) const;
+
+private:
+	double GetValueAtRank(uint64_t rank) const;
+	static size_t GetBin(double efficiency);
+	static double GetBinStart(size_t bin);
+
+	std::array<uint64_t, NumBins> Bins{};
+	uint64_t Count = 0;
+	float Min = 0.0f;
+	float Max = 0.0f;
+	double Sum = 0.0;
+};
@@ -0,0 +1,58 @@
+#include "EfficiencyResultsWriter.h"
+#include "BufferedFileWriter.h"
+
+namespace
+{
+	void WriteCsvColumn(BufferedFileWriter& writer, const char* entity, const std::vector<float>& efficiencies)
+	{
+		for (size_t i = 0; i < efficiencies.size(); ++i)
+		{
+			writer.WriteFormatted("%s,%zu,%.6f\n", entity, i, efficiencies[i]);
+		}
+	}
+}
+
+bool WriteEfficiencyResults(const OperationEfficiency& operationEfficiency, const std::string& path, EEfficiencyResultsFormat format, std::string& outError)
+{
+	BufferedFileWriter writer;
+	if (!writer.Open(path, format == EEfficiencyResultsFormat::Binary))
+	{
+		outError = "unable to open " + path;
+		return false;
+	}
+
+	const std::vector<float>& perTruck = operationEfficiency.PerTruckEfficiency;
+	const std::vector<float>& perStation = operationEfficiency.PerUnloadingLocationEfficiency;
+	if (format == EEfficiencyResultsFormat::Binary)
+	{
+		EfficiencyResultsHeader header;
+		header.NumMiningTrucks = perTruck.size();
+		header.NumUnloadingLocations = perStation.size();
+		header.SimulatedTimeSeconds = operationEfficiency.SimulatedTimeSeconds;
+		header.GlobalEfficiency = operationEfficiency.GlobalEfficiency;
+		writer.Write(&header, sizeof(header));
+		writer.Write(perTruck.data(), perTruck.size() * sizeof(float));
+		writer.Write(perStation.data(), perStation.size() * sizeof(float));
+	}
+	else
+	{
+		writer.Write(std::string("entity,index,efficiency\n"));
+		writer.WriteFormatted("global,0,%.6f\n", operationEfficiency.GlobalEfficiency);
+		WriteCsvColumn(writer, "truck", perTruck);
+		WriteCsvColumn(writer, "station", perStation);
+	}
+
+	if (!writer.Close())
+	{
+		outError = "unable to write " + path;
+		return false;
+	}
+	return true;
+}
+
+EEfficiencyResultsFormat GetEfficiencyResultsFormat(const std::string& path)
+{
+	const std::string binaryExtension = ".bin";
+	bool isBinary = path.size() >= binaryExtension.size() && path.compare(path.size() - binaryExtension.size(), binaryExtension.size(), binaryExtension) == 0;
+	return isBinary ? EEfficiencyResultsFormat::Binary : EEfficiencyResultsFormat::Csv;
+}
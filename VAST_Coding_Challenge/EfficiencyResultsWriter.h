@@ -0,0 +1,36 @@
+#pragma once
+#include "Global.h"
+
+#include <string>
+
+enum class EEfficiencyResultsFormat : size_t
+{
+	// entity,index,efficiency. One "global" row, then one row per truck, then one per station.
+	Csv,
+
+	// EfficiencyResultsHeader, then every truck's efficiency as a float, then every station's. Little endian, as written by this machine.
+	Binary
+};
+
+// Binary results header. Version is bumped whenever the layout changes.
+struct EfficiencyResultsHeader
+{
+	char Magic[8] = { 'V', 'A', 'S', 'T', 'E', 'F', 'F', '\0' };
+	uint32_t Version = 1;
+	uint32_t HeaderSize = sizeof(EfficiencyResultsHeader);
+	uint64_t NumMiningTrucks = 0;
+	uint64_t NumUnloadingLocations = 0;
+	double SimulatedTimeSeconds = 0.0;
+	float GlobalEfficiency = 0.0f;
+	uint32_t Reserved = 0;
+};
+
+/*
+* Writes the per truck and per station efficiencies of a run to a file, column after column, in one buffered pass.
+* Meant for fleets too large to print: a million trucks write in well under a second, and the binary format loads straight into an array.
+* Returns false and fills outError if the file can't be opened.
+*/
+bool WriteEfficiencyResults(const OperationEfficiency& operationEfficiency, const std::string& path, EEfficiencyResultsFormat format, std::string& outError);
+
+// Binary for paths ending in ".bin", CSV otherwise.
+EEfficiencyResultsFormat GetEfficiencyResultsFormat(const std::string& path);
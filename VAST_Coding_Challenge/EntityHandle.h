@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+
+/*
+* Typed, generational reference to an entity held in an EntityPool<T>.
+* Index is the entity's slot in the pool, so resolving a handle is an array lookup. Generation is bumped every time the slot is freed,
+* so a handle to a destroyed entity no longer resolves, even once its slot has been reused by a new entity.
+* The type parameter stops a handle to one entity type being used to look up another.
+*/
+template<typename T>
+struct EntityHandle
+{
+	static constexpr uint32_t InvalidIndex = 0xFFFFFFFFu;
+
+	EntityHandle() = default;
+	EntityHandle(uint32_t index, uint32_t generation) : Index(index), Generation(generation) {};
+
+	bool IsValid() const
+	{
+		return Index != InvalidIndex;
+	}
+
+	// Index and generation in a single word. Used for state signatures.
+	uint64_t Pack() const
+	{
+		return (static_cast<uint64_t>(Generation) << 32) | Index;
+	}
+
+	bool operator==(const EntityHandle& rhs) const
+	{
+		return Index == rhs.Index && Generation == rhs.Generation;
+	}
+
+	bool operator!=(const EntityHandle& rhs) const
+	{
+		return !(*this == rhs);
+	}
+
+	uint32_t Index = InvalidIndex;
+	uint32_t Generation = 0;
+};
@@ -0,0 +1,254 @@
+#pragma once
+#include "EntityHandle.h"
+#include "MemoryAccounting.h"
+#include "SimulationTrace.h"
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/*
+* Owns every entity of one type, one slot per entity.
+* Slots of destroyed entities are reused (most recently freed first), so slot indices stay dense and can key per-entity arrays.
+* Entities are individually allocated, so their addresses stay stable while the pool grows.
+* T must provide SetHandle(EntityHandle<T>), see TypedEntity, and name the memory subsystem its entities are counted in (T::MemorySubsystem).
+*/
+template<typename T>
+class EntityPool
+{
+	struct Slot
+	{
+		std::unique_ptr<T> Entity;
+		uint32_t Generation = 0;
+	};
+
+	using SlotArray = TrackedVector<Slot, EMemorySubsystem::EntityRegistries>;
+
+public:
+	using Handle = EntityHandle<T>;
+
+	// Iterates the live entities in slot order.
+	class Iterator
+	{
+	public:
+		Iterator(const SlotArray& slots, size_t index) : Slots(&slots), SlotIndex(index)
+		{
+			SkipEmptySlots();
+		}
+
+		T* operator*() const
+		{
+			return (*Slots)[SlotIndex].Entity.get();
+		}
+
+		Iterator& operator++()
+		{
+			++SlotIndex;
+			SkipEmptySlots();
+			return *this;
+		}
+
+		bool operator!=(const Iterator& rhs) const
+		{
+			return SlotIndex != rhs.SlotIndex;
+		}
+
+	private:
+		void SkipEmptySlots()
+		{
+			while (SlotIndex < Slots->size() && !(*Slots)[SlotIndex].Entity)
+			{
+				++SlotIndex;
+			}
+		}
+
+		const SlotArray* Slots;
+		size_t SlotIndex;
+	};
+
+	// Bulk spawns smaller than this per thread are constructed on the calling thread.
+	static constexpr size_t MinEntitiesPerSpawnThread = 16384;
+
+	EntityPool() = default;
+
+	~EntityPool()
+	{
+		Clear();
+	}
+
+	void Reserve(size_t numEntities)
+	{
+		Slots.reserve(numEntities);
+	}
+
+	/*
+	* Creates a new entity, reusing a free slot if there is one, and returns its handle.
+	*/
+	Handle Spawn()
+	{
+		uint32_t index = 0;
+		if (!FreeSlots.empty())
+		{
+			index = FreeSlots.back();
+			FreeSlots.pop_back();
+		}
+		else
+		{
+			index = static_cast<uint32_t>(Slots.size());
+			Slots.emplace_back();
+		}
+
+		Slot& slot = Slots[index];
+		slot.Entity.reset(new T());
+		MemoryAccounting::RecordAllocation(T::MemorySubsystem, sizeof(T));
+
+		Handle handle(index, slot.Generation);
+		slot.Entity->SetHandle(handle);
+		++NumEntities;
+		return handle;
+	}
+
+	/*
+	* Creates numEntities entities at once and writes their handles to outHandles, in the order repeated Spawn() calls would hand them out.
+	* Every slot is claimed and the slot array sized up front, then the entities are constructed in parallel chunks.
+	* initialize(entity, i) is called for the i-th new entity from those chunks, so it must only touch that entity.
+	*/
+	template<typename Initializer>
+	void SpawnMany(size_t numEntities, Handle* outHandles, Initializer initialize)
+	{
+		size_t numReusedSlots = std::min(numEntities, FreeSlots.size());
+		Slots.reserve(Slots.size() + (numEntities - numReusedSlots));
+		for (size_t i = 0; i < numEntities; ++i)
+		{
+			uint32_t index = 0;
+			if (i < numReusedSlots)
+			{
+				index = FreeSlots.back();
+				FreeSlots.pop_back();
+			}
+			else
+			{
+				index = static_cast<uint32_t>(Slots.size());
+				Slots.emplace_back();
+			}
+			outHandles[i] = Handle(index, Slots[index].Generation);
+		}
+
+		auto constructChunk = [this, outHandles, &initialize](size_t begin, size_t end) {
+			TRACE_SCOPE("SpawnChunk");
+			for (size_t i = begin; i < end; ++i)
+			{
+				Slot& slot = Slots[outHandles[i].Index];
+				slot.Entity.reset(new T());
+				slot.Entity->SetHandle(outHandles[i]);
+				initialize(*slot.Entity, i);
+			}
+		};
+
+		size_t numThreads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), numEntities / MinEntitiesPerSpawnThread);
+		if (numThreads <= 1)
+		{
+			constructChunk(0, numEntities);
+		}
+		else
+		{
+			// The calling thread constructs the last chunk itself.
+			size_t chunkSize = (numEntities + numThreads - 1) / numThreads;
+			std::vector<std::thread> spawnThreads;
+			for (size_t chunkStart = 0; chunkStart + chunkSize < numEntities; chunkStart += chunkSize)
+			{
+				spawnThreads.emplace_back(constructChunk, chunkStart, chunkStart + chunkSize);
+			}
+			constructChunk(spawnThreads.size() * chunkSize, numEntities);
+
+			for (std::thread& spawnThread : spawnThreads)
+			{
+				spawnThread.join();
+			}
+		}
+
+		// Every entity is an allocation of its own, and is recorded as deallocated on its own when destroyed.
+		MemoryAccounting::RecordAllocation(T::MemorySubsystem, numEntities * sizeof(T), numEntities);
+		NumEntities += static_cast<unsigned int>(numEntities);
+	}
+
+	/*
+	* Returns the entity a handle refers to, or nullptr if the handle is invalid or its entity has been destroyed.
+	*/
+	T* Resolve(Handle handle) const
+	{
+		if (handle.Index >= Slots.size())
+		{
+			return nullptr;
+		}
+
+		const Slot& slot = Slots[handle.Index];
+		return slot.Generation == handle.Generation ? slot.Entity.get() : nullptr;
+	}
+
+	/*
+	* Destroys the entity a handle refers to. Every handle to it becomes stale. Returns false if the handle was already stale.
+	*/
+	bool Destroy(Handle handle)
+	{
+		if (!Resolve(handle))
+		{
+			return false;
+		}
+
+		Slot& slot = Slots[handle.Index];
+		slot.Entity.reset();
+		MemoryAccounting::RecordDeallocation(T::MemorySubsystem, sizeof(T));
+		++slot.Generation;
+		FreeSlots.push_back(handle.Index);
+		--NumEntities;
+		return true;
+	}
+
+	/*
+	* Destroys every entity. Slots are kept (with bumped generations) and handed out again from index 0 upwards.
+	*/
+	void Clear()
+	{
+		FreeSlots.clear();
+		for (size_t i = Slots.size(); i-- > 0;)
+		{
+			if (Slots[i].Entity)
+			{
+				Slots[i].Entity.reset();
+				MemoryAccounting::RecordDeallocation(T::MemorySubsystem, sizeof(T));
+				++Slots[i].Generation;
+			}
+			FreeSlots.push_back(static_cast<uint32_t>(i));
+		}
+		NumEntities = 0;
+	}
+
+	// Number of live entities.
+	unsigned int Size() const
+	{
+		return NumEntities;
+	}
+
+	// Number of slots. Every handle index is below this.
+	unsigned int GetNumSlots() const
+	{
+		return static_cast<unsigned int>(Slots.size());
+	}
+
+	Iterator begin() const
+	{
+		return Iterator(Slots, 0);
+	}
+
+	Iterator end() const
+	{
+		return Iterator(Slots, Slots.size());
+	}
+
+private:
+	SlotArray Slots;
+	TrackedVector<uint32_t, EMemorySubsystem::EntityRegistries> FreeSlots;
+	unsigned int NumEntities = 0;
+};
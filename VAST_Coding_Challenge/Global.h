@@ -1,8 +1,36 @@
 #pragma once
+#include "EfficiencyDistribution.h"
+#include "MemoryAccounting.h"
+#include "SimulationPolicies.h"
+
+#include <cstdint>
 #include <iostream>
 #include <math.h>
 #include <random>
 
+// Simulation time is stored as a whole number of microseconds.
+// Integer time never drifts over hundreds of thousands of ticks, and timers can be compared exactly.
+// Seconds (float / double) are only used at the API boundary: configuration, Tick(), and reporting.
+using SimulationTime = int64_t;
+constexpr SimulationTime SimulationTimeTicksPerSecond = 1000000;
+
+inline SimulationTime SecondsToSimulationTime(double seconds)
+{
+	return static_cast<SimulationTime>(llround(seconds * static_cast<double>(SimulationTimeTicksPerSecond)));
+}
+
+inline double SimulationTimeToSeconds(SimulationTime time)
+{
+	return static_cast<double>(time) / static_cast<double>(SimulationTimeTicksPerSecond);
+}
+
+// State of the simulation flattened into words, used to detect when the simulation becomes periodic.
+using StateSignature = TrackedVector<uint64_t, EMemorySubsystem::SteadyStateDetection>;
+
+// Interactive playback speed: simulated seconds per wall clock second.
+constexpr float MinPlaybackSpeed = 1.0f;
+constexpr float MaxPlaybackSpeed = 10000.0f;
+
 struct MiningAndUnloadingTimes
 {
 	float MinMiningTimeHours = 1.0f;
@@ -12,6 +40,14 @@ struct MiningAndUnloadingTimes
 	float MaxUnloadingTimeMinutes = 5.0f;
 };
 
+// How a truck that has finished mining picks the Unloading Location to queue at.
+enum class EUnloadingDispatchStrategy : size_t
+{
+	ShortestQueue,		// The station with the least unloading work queued.
+	Nearest,			// The station closest to the mining location the truck is leaving.
+	EarliestUnloadStart	// The station where the truck can start unloading soonest: travel ETA plus the station's projected queue on arrival.
+};
+
 struct SimulationConfiguration
 {
 	int NumMiningTrucksToSpawn = 10;
@@ -19,6 +55,41 @@ struct SimulationConfiguration
 	MiningAndUnloadingTimes MiningAndUnloadingTimes;
 
 	float SimulationMaxTimeSeconds = 259200.0f;
+
+	// When mining and unloading times are constant, the fleet eventually repeats the same pattern over and over.
+	// Once that repeating pattern is detected the rest of the simulation is extrapolated instead of simulated.
+	bool EnableSteadyStateExtrapolation = true;
+
+	// Stops the run early once global efficiency is known precisely enough: when the 95% confidence interval of its batch means estimate
+	// is within +/- ConvergenceTolerance. The first batch is a warm-up and is not counted. 0 always runs the full SimulationMaxTimeSeconds.
+	float ConvergenceTolerance = 0.0f;
+	float ConvergenceBatchSeconds = 3600.0f;
+	unsigned int ConvergenceMinBatches = 10;
+
+	// Unloading Location selection. DispatchTravelSpeed (world units per second) is used to estimate travel ETAs;
+	// 0 treats travel as instant, as the truck movement currently is.
+	EUnloadingDispatchStrategy DispatchStrategy = EUnloadingDispatchStrategy::ShortestQueue;
+	float DispatchTravelSpeed = 0.0f;
+
+	// Seeds every random value of the run (locations, paths, mining times), so runs can be repeated exactly. 0 seeds from the clock.
+	unsigned int RandomSeed = 0;
+
+	// Records how efficiency, truck states and station queues evolve, sampled every TimeSeriesIntervalSeconds of simulation time into at most
+	// TimeSeriesMaxPoints points (see SimulationTimeSeries). 0 doesn't record.
+	float TimeSeriesIntervalSeconds = 0.0f;
+	unsigned int TimeSeriesMaxPoints = 512;
+
+	// Prints the remaining simulation time every tick. Turn off when running simulations in bulk or in parallel.
+	bool LogSimulationTime = true;
+};
+
+/*
+* A Mining Truck leaving one simulation to join another (e.g. moving between mining sites).
+* The truck keeps the Helium-3 it has unloaded so far, so its efficiency covers its whole run.
+*/
+struct MiningTruckTransfer
+{
+	SimulationTime TotalHeliumUnloaded = 0;
 };
 
 /*
@@ -30,18 +101,51 @@ struct OperationEfficiency
 	std::vector<float> PerTruckEfficiency;
 	std::vector<float> PerUnloadingLocationEfficiency;
 
+	// Simulation time the report covers. Less than SimulationMaxTimeSeconds if the run stopped early on convergence.
+	double SimulatedTimeSeconds = 0.0;
+
+	// Only filled in when convergence based stopping is enabled: the batch means estimate of global efficiency and its 95% confidence half width.
+	bool Converged = false;
+	unsigned int NumEfficiencyBatches = 0;
+	float EstimatedEfficiency = 0.0f;
+	float EfficiencyConfidenceHalfWidth = 0.0f;
+
+	// Memory accounting snapshot taken while the simulation's entities were still alive.
+	MemoryFootprint Memory;
+
+	// Above this many trucks (or stations), Print() only shows their distribution. Write the full columns out with WriteEfficiencyResults().
+	static constexpr size_t MaxPrintedEfficiencies = 32;
+
 	void Print()
 	{
-		std::cout << "Global Efficiency: " << GlobalEfficiency << std::endl;
-		for (unsigned int i = 0; i < PerTruckEfficiency.size(); ++i)
+		std::cout << "Global Efficiency: " << GlobalEfficiency << '\n';
+		std::cout << "Simulated Time: " << SimulatedTimeSeconds << " seconds." << '\n';
+		if (NumEfficiencyBatches > 1)
+		{
+			std::cout << "Estimated Efficiency: " << EstimatedEfficiency << " +/- " << EfficiencyConfidenceHalfWidth << " (95%, " << NumEfficiencyBatches
+					  << " batches)" << (Converged ? ", converged" : ", not converged") << '\n';
+		}
+
+		if (PerTruckEfficiency.size() <= MaxPrintedEfficiencies)
 		{
-			std::cout << "Truck: " << i << " efficiency: " << PerTruckEfficiency[i] << std::endl;
+			for (unsigned int i = 0; i < PerTruckEfficiency.size(); ++i)
+			{
+				std::cout << "Truck: " << i << " efficiency: " << PerTruckEfficiency[i] << '\n';
+			}
 		}
 
-		for (unsigned int i = 0; i < PerUnloadingLocationEfficiency.size(); ++i)
+		if (PerUnloadingLocationEfficiency.size() <= MaxPrintedEfficiencies)
 		{
-			std::cout << "Unloading Station: " << i << " efficiency: " << PerUnloadingLocationEfficiency[i] << std::endl;
+			for (unsigned int i = 0; i < PerUnloadingLocationEfficiency.size(); ++i)
+			{
+				std::cout << "Unloading Station: " << i << " efficiency: " << PerUnloadingLocationEfficiency[i] << '\n';
+			}
 		}
+
+		EfficiencyDistribution::Build(PerTruckEfficiency).Print("Truck");
+		EfficiencyDistribution::Build(PerUnloadingLocationEfficiency).Print("Unloading Station");
+
+		Memory.Print();
 	}
 };
 
@@ -70,11 +174,10 @@ public:
 
 	void Randomize()
 	{
-		srand(static_cast<unsigned>(time(0))); 
-
-		X = static_cast<float>(rand()) / RAND_MAX;
-		Y = static_cast<float>(rand()) / RAND_MAX;
-		Z = static_cast<float>(rand()) / RAND_MAX;
+		// Drawn from the simulation's random stream, which is seeded once per run. Reseeding here would give every call in the same second the same values.
+		X = SimulationPolicies::Random::NextUnitFloat();
+		Y = SimulationPolicies::Random::NextUnitFloat();
+		Z = SimulationPolicies::Random::NextUnitFloat();
 	}
 
 	float Size()
@@ -109,11 +212,10 @@ public:
 
 	void Randomize()
 	{
-		srand(static_cast<unsigned>(time(0)));
-
-		Yaw = static_cast<float>(rand()) / RAND_MAX;
-		Pitch = static_cast<float>(rand()) / RAND_MAX;
-		Roll = static_cast<float>(rand()) / RAND_MAX;
+		// Drawn from the simulation's random stream, which is seeded once per run. Reseeding here would give every call in the same second the same values.
+		Yaw = SimulationPolicies::Random::NextUnitFloat();
+		Pitch = SimulationPolicies::Random::NextUnitFloat();
+		Roll = SimulationPolicies::Random::NextUnitFloat();
 	}
 
 	float Yaw = 0.0f;
@@ -0,0 +1,161 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+/*
+* Maps the whole file for reading. An empty file opens successfully with no data.
+*/
+bool MappedFile::Open(const std::string& path)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize))
+	{
+		CloseHandle(fileHandle);
+		return false;
+	}
+
+	FileHandle = fileHandle;
+	Size = static_cast<size_t>(fileSize.QuadPart);
+	if (Size == 0)
+	{
+		return true;
+	}
+
+	MappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!MappingHandle)
+	{
+		Close();
+		return false;
+	}
+
+	Data = static_cast<const char*>(MapViewOfFile(MappingHandle, FILE_MAP_READ, 0, 0, 0));
+	if (!Data)
+	{
+		Close();
+		return false;
+	}
+#else
+	FileDescriptor = open(path.c_str(), O_RDONLY);
+	if (FileDescriptor < 0)
+	{
+		return false;
+	}
+
+	struct stat fileStatus;
+	if (fstat(FileDescriptor, &fileStatus) < 0)
+	{
+		Close();
+		return false;
+	}
+
+	Size = static_cast<size_t>(fileStatus.st_size);
+	if (Size == 0)
+	{
+		return true;
+	}
+
+	void* mapping = mmap(nullptr, Size, PROT_READ, MAP_PRIVATE, FileDescriptor, 0);
+	if (mapping == MAP_FAILED)
+	{
+		Close();
+		return false;
+	}
+
+	// The file is read front to back, so let the OS read ahead aggressively.
+	madvise(mapping, Size, MADV_SEQUENTIAL);
+	Data = static_cast<const char*>(mapping);
+#endif
+
+	return true;
+}
+
+/*
+* Unmaps the file and closes it.
+*/
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (Data)
+	{
+		UnmapViewOfFile(Data);
+	}
+	if (MappingHandle)
+	{
+		CloseHandle(MappingHandle);
+	}
+	if (FileHandle)
+	{
+		CloseHandle(FileHandle);
+	}
+	MappingHandle = nullptr;
+	FileHandle = nullptr;
+#else
+	if (Data)
+	{
+		munmap(const_cast<char*>(Data), Size);
+	}
+	if (FileDescriptor >= 0)
+	{
+		close(FileDescriptor);
+	}
+	FileDescriptor = -1;
+#endif
+
+	Data = nullptr;
+	Size = 0;
+	ReleasedSize = 0;
+}
+
+const char* MappedFile::GetData() const
+{
+	return Data;
+}
+
+size_t MappedFile::GetSize() const
+{
+	return Size;
+}
+
+/*
+* Drops the pages before offset from memory. They are re-read from the file if they are ever touched again.
+* Windows keeps unmapping decisions to its working set manager, so this only has an effect on POSIX systems.
+*/
+void MappedFile::ReleaseConsumed(size_t offset)
+{
+#ifndef _WIN32
+	if (!Data)
+	{
+		return;
+	}
+
+	size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	size_t releaseEnd = (offset / pageSize) * pageSize;
+	if (releaseEnd > ReleasedSize)
+	{
+		madvise(const_cast<char*>(Data) + ReleasedSize, releaseEnd - ReleasedSize, MADV_DONTNEED);
+		ReleasedSize = releaseEnd;
+	}
+#endif
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+/*
+* Read-only memory mapping of a whole file.
+* Pages are only loaded as they are touched, and pages that have already been read can be released again,
+* so a file much larger than memory can be streamed through front to back.
+*/
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const std::string& path);
+	void Close();
+
+	const char* GetData() const;
+	size_t GetSize() const;
+
+	// Tells the OS that everything before offset has been consumed and its pages can be dropped.
+	void ReleaseConsumed(size_t offset);
+
+private:
+	const char* Data = nullptr;
+	size_t Size = 0;
+	size_t ReleasedSize = 0;
+
+#ifdef _WIN32
+	void* FileHandle = nullptr;
+	void* MappingHandle = nullptr;
+#else
+	int FileDescriptor = -1;
+#endif
+};
@@ -0,0 +1,112 @@
+#include "MemoryAccounting.h"
+
+#include <atomic>
+#include <iostream>
+
+namespace
+{
+	struct SubsystemCounters
+	{
+		std::atomic<int64_t> Bytes{ 0 };
+		std::atomic<int64_t> PeakBytes{ 0 };
+		std::atomic<uint64_t> NumAllocations{ 0 };
+		std::atomic<int64_t> NumLiveAllocations{ 0 };
+	};
+
+	struct Counters
+	{
+		std::array<SubsystemCounters, NumMemorySubsystems> Subsystems;
+		std::atomic<int64_t> TotalBytes{ 0 };
+		std::atomic<int64_t> PeakTotalBytes{ 0 };
+	};
+
+	Counters& GetCounters()
+	{
+		static Counters counters;
+		return counters;
+	}
+
+	void UpdatePeak(std::atomic<int64_t>& peak, int64_t value)
+	{
+		int64_t currentPeak = peak.load(std::memory_order_relaxed);
+		while (value > currentPeak && !peak.compare_exchange_weak(currentPeak, value, std::memory_order_relaxed))
+		{
+		}
+	}
+}
+
+const char* GetMemorySubsystemName(EMemorySubsystem subsystem)
+{
+	switch (subsystem)
+	{
+	case EMemorySubsystem::MiningTrucks:			return "Mining Trucks";
+	case EMemorySubsystem::MiningLocations:			return "Mining Locations";
+	case EMemorySubsystem::UnloadingLocations:		return "Unloading Locations";
+	case EMemorySubsystem::EntityRegistries:		return "Entity Registries";
+	case EMemorySubsystem::TruckAssignments:		return "Truck Assignments";
+	case EMemorySubsystem::UnloadingQueues:			return "Unloading Queues";
+	case EMemorySubsystem::Delegates:				return "Delegates";
+	case EMemorySubsystem::CompletionEvents:		return "Completion Events";
+	case EMemorySubsystem::Dispatch:				return "Dispatch";
+	case EMemorySubsystem::Scheduling:				return "Scheduling";
+	case EMemorySubsystem::SteadyStateDetection:	return "Steady State Detection";
+	case EMemorySubsystem::EventBus:				return "Event Bus";
+	case EMemorySubsystem::TimeSeries:				return "Time Series";
+	default:										return "Unknown";
+	}
+}
+
+void MemoryAccounting::RecordAllocation(EMemorySubsystem subsystem, size_t bytes, size_t numAllocations /* = 1 */)
+{
+	Counters& counters = GetCounters();
+	SubsystemCounters& subsystemCounters = counters.Subsystems[static_cast<size_t>(subsystem)];
+
+	int64_t size = static_cast<int64_t>(bytes);
+	UpdatePeak(subsystemCounters.PeakBytes, subsystemCounters.Bytes.fetch_add(size, std::memory_order_relaxed) + size);
+	subsystemCounters.NumAllocations.fetch_add(numAllocations, std::memory_order_relaxed);
+	subsystemCounters.NumLiveAllocations.fetch_add(numAllocations, std::memory_order_relaxed);
+	UpdatePeak(counters.PeakTotalBytes, counters.TotalBytes.fetch_add(size, std::memory_order_relaxed) + size);
+}
+
+void MemoryAccounting::RecordDeallocation(EMemorySubsystem subsystem, size_t bytes)
+{
+	Counters& counters = GetCounters();
+	SubsystemCounters& subsystemCounters = counters.Subsystems[static_cast<size_t>(subsystem)];
+
+	int64_t size = static_cast<int64_t>(bytes);
+	subsystemCounters.Bytes.fetch_sub(size, std::memory_order_relaxed);
+	subsystemCounters.NumLiveAllocations.fetch_sub(1, std::memory_order_relaxed);
+	counters.TotalBytes.fetch_sub(size, std::memory_order_relaxed);
+}
+
+/*
+* Reads every counter. Other threads may be allocating meanwhile, so the snapshot is only exact when the process is quiet.
+*/
+MemoryFootprint MemoryAccounting::GetFootprint()
+{
+	Counters& counters = GetCounters();
+	MemoryFootprint footprint;
+	for (size_t i = 0; i < NumMemorySubsystems; ++i)
+	{
+		footprint.Subsystems[i].Bytes = counters.Subsystems[i].Bytes.load(std::memory_order_relaxed);
+		footprint.Subsystems[i].PeakBytes = counters.Subsystems[i].PeakBytes.load(std::memory_order_relaxed);
+		footprint.Subsystems[i].NumAllocations = counters.Subsystems[i].NumAllocations.load(std::memory_order_relaxed);
+		footprint.Subsystems[i].NumLiveAllocations = counters.Subsystems[i].NumLiveAllocations.load(std::memory_order_relaxed);
+	}
+
+	footprint.TotalBytes = counters.TotalBytes.load(std::memory_order_relaxed);
+	footprint.PeakTotalBytes = counters.PeakTotalBytes.load(std::memory_order_relaxed);
+	return footprint;
+}
+
+void MemoryFootprint::Print() const
+{
+	std::cout << "Memory: " << TotalBytes << " bytes (peak " << PeakTotalBytes << " bytes)." << std::endl;
+	std::cout << "Memory per Truck: " << BytesPerMiningTruck << " bytes. Memory per Unloading Station: " << BytesPerUnloadingLocation << " bytes." << std::endl;
+	for (size_t i = 0; i < NumMemorySubsystems; ++i)
+	{
+		const MemorySubsystemUsage& usage = Subsystems[i];
+		std::cout << "  " << GetMemorySubsystemName(static_cast<EMemorySubsystem>(i)) << ": " << usage.Bytes << " bytes (peak " << usage.PeakBytes
+				  << ") in " << usage.NumLiveAllocations << " allocations, " << usage.NumAllocations << " allocations in total." << std::endl;
+	}
+}
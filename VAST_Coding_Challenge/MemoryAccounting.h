@@ -0,0 +1,120 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/*
+* Memory accounting per simulation subsystem.
+* Containers owned by a subsystem allocate through TrackingAllocator, and entities and delegates record their own allocations,
+* so the report shows where the footprint of a simulation goes and what each truck and station costs.
+* Counters are shared by every simulation in the process (updated atomically), like the instrumentation counters in SimulationPolicies.h.
+*/
+enum class EMemorySubsystem : size_t
+{
+	MiningTrucks,			// Mining Truck entities.
+	MiningLocations,		// Mining Location entities.
+	UnloadingLocations,		// Unloading Location entities.
+	EntityRegistries,		// Registry slots and free lists.
+	TruckAssignments,		// The controller's per truck assignment (phase) table.
+	UnloadingQueues,		// Unloading Location queues and their duplicate tracking bits.
+	Delegates,				// Callables bound to delegates.
+	CompletionEvents,		// Completion event buffers.
+	Dispatch,				// The unloading dispatcher's station index.
+	Scheduling,				// Suspended mining trucks waiting to be resumed.
+	SteadyStateDetection,	// Period boundary samples and signatures.
+	EventBus,				// State change event rings, only allocated once something subscribes.
+	TimeSeries,				// Time series points, only allocated when recording is turned on.
+	Count
+};
+
+constexpr size_t NumMemorySubsystems = static_cast<size_t>(EMemorySubsystem::Count);
+
+const char* GetMemorySubsystemName(EMemorySubsystem subsystem);
+
+struct MemorySubsystemUsage
+{
+	int64_t Bytes = 0;
+	int64_t PeakBytes = 0;
+	uint64_t NumAllocations = 0;
+	int64_t NumLiveAllocations = 0;
+};
+
+/*
+* Snapshot of the memory accounting counters, printed as part of the Operation Efficiency report.
+*/
+struct MemoryFootprint
+{
+	std::array<MemorySubsystemUsage, NumMemorySubsystems> Subsystems;
+	int64_t TotalBytes = 0;
+	int64_t PeakTotalBytes = 0;
+
+	// Filled in by the simulation that took the snapshot. Only meaningful when one simulation runs in the process at a time.
+	double BytesPerMiningTruck = 0.0;
+	double BytesPerUnloadingLocation = 0.0;
+
+	const MemorySubsystemUsage& operator[](EMemorySubsystem subsystem) const
+	{
+		return Subsystems[static_cast<size_t>(subsystem)];
+	}
+
+	void Print() const;
+};
+
+namespace MemoryAccounting
+{
+	// numAllocations records several same sized allocations made together as one call, bytes being their total.
+	void RecordAllocation(EMemorySubsystem subsystem, size_t bytes, size_t numAllocations = 1);
+	void RecordDeallocation(EMemorySubsystem subsystem, size_t bytes);
+	MemoryFootprint GetFootprint();
+}
+
+/*
+* Standard allocator that records every allocation against a subsystem.
+*/
+template<typename T, EMemorySubsystem Subsystem>
+class TrackingAllocator
+{
+public:
+	using value_type = T;
+
+	template<typename U>
+	struct rebind
+	{
+		using other = TrackingAllocator<U, Subsystem>;
+	};
+
+	TrackingAllocator() = default;
+
+	template<typename U>
+	TrackingAllocator(const TrackingAllocator<U, Subsystem>&) {}
+
+	T* allocate(size_t count)
+	{
+		T* memory = std::allocator<T>().allocate(count);
+		MemoryAccounting::RecordAllocation(Subsystem, count * sizeof(T));
+		return memory;
+	}
+
+	void deallocate(T* memory, size_t count)
+	{
+		MemoryAccounting::RecordDeallocation(Subsystem, count * sizeof(T));
+		std::allocator<T>().deallocate(memory, count);
+	}
+
+	template<typename U>
+	bool operator==(const TrackingAllocator<U, Subsystem>&) const
+	{
+		return true;
+	}
+
+	template<typename U>
+	bool operator!=(const TrackingAllocator<U, Subsystem>&) const
+	{
+		return false;
+	}
+};
+
+template<typename T, EMemorySubsystem Subsystem>
+using TrackedVector = std::vector<T, TrackingAllocator<T, Subsystem>>;
@@ -0,0 +1,269 @@
+#include "MetricsExporter.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	// How often the exporter thread checks whether it has been asked to stop.
+	constexpr int StopCheckIntervalMilliseconds = 200;
+
+	// Rates are only recomputed once at least this much wall time has passed, so back to back scrapes don't report noise.
+	constexpr double MinRateIntervalSeconds = 1.0;
+
+	// Longest request read from a client before answering. Only the first few bytes matter.
+	constexpr size_t MaxRequestLength = 4096;
+
+#if !defined(_WIN32) && defined(MSG_NOSIGNAL)
+	// A client that hangs up early must not take the simulation down with SIGPIPE.
+	constexpr int SendFlags = MSG_NOSIGNAL;
+#else
+	constexpr int SendFlags = 0;
+#endif
+}
+
+MetricsExporter::~MetricsExporter()
+{
+	Stop();
+}
+
+bool MetricsExporter::Start(const SimulationMetrics& metrics, const MetricsExporterConfiguration& configuration, std::string& outError)
+{
+	Stop();
+	Metrics = &metrics;
+	Configuration = configuration;
+	PreviousRenderTime = Clock::now();
+	PreviousNumTicks = metrics.GetNumTicks();
+	PreviousSimulatedSeconds = metrics.GetSimulatedSeconds();
+	TicksPerSecond = 0.0;
+	SimulatedSecondsPerSecond = 0.0;
+
+	if (!Configuration.SocketPath.empty())
+	{
+#ifdef _WIN32
+		outError = "the metrics socket requires Unix domain sockets, which are not available on this platform";
+		return false;
+#else
+		sockaddr_un address;
+		memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+		if (Configuration.SocketPath.size() >= sizeof(address.sun_path))
+		{
+			outError = "metrics socket path is too long";
+			return false;
+		}
+		strncpy(address.sun_path, Configuration.SocketPath.c_str(), sizeof(address.sun_path) - 1);
+
+		ListenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+		unlink(Configuration.SocketPath.c_str());
+		if (ListenSocket < 0 || bind(ListenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(ListenSocket, 16) < 0)
+		{
+			outError = std::string("unable to listen on ") + Configuration.SocketPath + ": " + strerror(errno);
+			if (ListenSocket >= 0)
+			{
+				close(ListenSocket);
+				ListenSocket = -1;
+			}
+			return false;
+		}
+#endif
+	}
+
+	StopRequested.store(false);
+	Thread = std::thread([this]() {
+		Run();
+	});
+	return true;
+}
+
+/*
+* Writes the file one last time, so it ends up showing the final state of the run.
+*/
+void MetricsExporter::Stop()
+{
+	if (!Thread.joinable())
+	{
+		return;
+	}
+
+	StopRequested.store(true);
+	Thread.join();
+
+	if (!Configuration.FilePath.empty())
+	{
+		WriteFile();
+	}
+
+#ifndef _WIN32
+	if (ListenSocket >= 0)
+	{
+		close(ListenSocket);
+		ListenSocket = -1;
+		unlink(Configuration.SocketPath.c_str());
+	}
+#endif
+}
+
+std::string MetricsExporter::Render()
+{
+	std::string text;
+	text.reserve(4096);
+	Metrics->WritePrometheusText(text);
+
+	double ticksPerSecond = 0.0;
+	double simulatedSecondsPerSecond = 0.0;
+	{
+		std::lock_guard<std::mutex> lock(RatesMutex);
+		Clock::time_point now = Clock::now();
+		double wallSeconds = std::chrono::duration<double>(now - PreviousRenderTime).count();
+		if (wallSeconds >= MinRateIntervalSeconds)
+		{
+			uint64_t numTicks = Metrics->GetNumTicks();
+			double simulatedSeconds = Metrics->GetSimulatedSeconds();
+
+			// A new simulation starts the counters again from zero.
+			TicksPerSecond = numTicks >= PreviousNumTicks ? (numTicks - PreviousNumTicks) / wallSeconds : 0.0;
+			SimulatedSecondsPerSecond = simulatedSeconds >= PreviousSimulatedSeconds ? (simulatedSeconds - PreviousSimulatedSeconds) / wallSeconds : 0.0;
+
+			PreviousRenderTime = now;
+			PreviousNumTicks = numTicks;
+			PreviousSimulatedSeconds = simulatedSeconds;
+		}
+
+		ticksPerSecond = TicksPerSecond;
+		simulatedSecondsPerSecond = SimulatedSecondsPerSecond;
+	}
+
+	char line[256];
+	snprintf(line, sizeof(line), "# HELP vast_ticks_per_second Ticks run per wall clock second, since the previous export.\n"
+								 "# TYPE vast_ticks_per_second gauge\nvast_ticks_per_second %.3f\n", ticksPerSecond);
+	text += line;
+	snprintf(line, sizeof(line), "# HELP vast_simulated_seconds_per_second Simulation time run per wall clock second, since the previous export.\n"
+								 "# TYPE vast_simulated_seconds_per_second gauge\nvast_simulated_seconds_per_second %.3f\n", simulatedSecondsPerSecond);
+	text += line;
+	return text;
+}
+
+void MetricsExporter::Run()
+{
+	Clock::time_point nextFileWrite = Clock::now();
+	Clock::duration fileInterval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(std::max(Configuration.FileIntervalSeconds, 0.1f)));
+
+	while (!StopRequested.load())
+	{
+		if (!Configuration.FilePath.empty() && Clock::now() >= nextFileWrite)
+		{
+			WriteFile();
+			nextFileWrite += fileInterval;
+		}
+
+#ifdef _WIN32
+		std::this_thread::sleep_for(std::chrono::milliseconds(StopCheckIntervalMilliseconds));
+#else
+		if (ListenSocket < 0)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(StopCheckIntervalMilliseconds));
+			continue;
+		}
+
+		pollfd listenPoll;
+		listenPoll.fd = ListenSocket;
+		listenPoll.events = POLLIN;
+		listenPoll.revents = 0;
+		if (poll(&listenPoll, 1, StopCheckIntervalMilliseconds) > 0 && (listenPoll.revents & POLLIN))
+		{
+			int clientSocket = accept(ListenSocket, nullptr, nullptr);
+			if (clientSocket >= 0)
+			{
+				ServeClient(clientSocket);
+				close(clientSocket);
+			}
+		}
+#endif
+	}
+}
+
+/*
+* Written next to the target and renamed over it, which replaces the file in one step.
+*/
+void MetricsExporter::WriteFile()
+{
+	std::string text = Render();
+	std::string temporaryPath = Configuration.FilePath + ".tmp";
+	FILE* file = fopen(temporaryPath.c_str(), "wb");
+	if (!file)
+	{
+		return;
+	}
+
+	bool written = fwrite(text.data(), 1, text.size(), file) == text.size();
+	written = fclose(file) == 0 && written;
+	if (written)
+	{
+#ifdef _WIN32
+		remove(Configuration.FilePath.c_str());
+#endif
+		rename(temporaryPath.c_str(), Configuration.FilePath.c_str());
+	}
+}
+
+/*
+* Reads whatever the client sent up front (without waiting for more than a moment), then answers it.
+*/
+void MetricsExporter::ServeClient(int clientSocket)
+{
+#ifndef _WIN32
+	std::string request;
+	pollfd clientPoll;
+	clientPoll.fd = clientSocket;
+	clientPoll.events = POLLIN;
+	while (request.size() < MaxRequestLength && request.find("\r\n\r\n") == std::string::npos)
+	{
+		clientPoll.revents = 0;
+		if (poll(&clientPoll, 1, request.empty() ? 50 : 200) <= 0)
+		{
+			break;
+		}
+
+		char buffer[1024];
+		ssize_t numRead = read(clientSocket, buffer, sizeof(buffer));
+		if (numRead <= 0)
+		{
+			break;
+		}
+		request.append(buffer, static_cast<size_t>(numRead));
+	}
+
+	std::string response = Render();
+	if (request.compare(0, 4, "GET ") == 0)
+	{
+		char header[256];
+		snprintf(header, sizeof(header), "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n", response.size());
+		response.insert(0, header);
+	}
+
+	size_t written = 0;
+	while (written < response.size())
+	{
+		ssize_t result = send(clientSocket, response.data() + written, response.size() - written, SendFlags);
+		if (result < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (result <= 0)
+		{
+			break;
+		}
+		written += static_cast<size_t>(result);
+	}
+#endif
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "SimulationMetrics.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+
+struct MetricsExporterConfiguration
+{
+	// Serves the metrics to anything that connects to this Unix domain socket. Empty doesn't listen.
+	std::string SocketPath;
+
+	// Rewrites this file with the metrics every FileIntervalSeconds (for textfile collectors). Empty doesn't write a file.
+	std::string FilePath;
+	float FileIntervalSeconds = 5.0f;
+};
+
+/*
+* Exposes a running simulation's SimulationMetrics in the Prometheus text format, from a thread of its own.
+*
+* A client connecting to the socket is sent the current metrics, then the connection is closed. A request starting with "GET " (an HTTP
+* scrape forwarded to the socket) gets an HTTP response around the same text. The file is written to a temporary name and renamed over the
+* old one, so a collector never reads half a file.
+*
+* Besides the metrics themselves, the exporter adds the rates since the previous export (ticks and simulated seconds per wall clock second),
+* for tools that only show the latest value.
+*
+* The socket is POSIX only. On Windows Start() fails if a socket path is given; the file endpoint works everywhere.
+*/
+class MetricsExporter
+{
+public:
+	MetricsExporter() = default;
+	~MetricsExporter();
+
+	MetricsExporter(const MetricsExporter&) = delete;
+	MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+	// The metrics must outlive the exporter, or at least Stop(). Returns false and fills outError if an endpoint couldn't be opened.
+	bool Start(const SimulationMetrics& metrics, const MetricsExporterConfiguration& configuration, std::string& outError);
+	void Stop();
+
+	// The full exposition, as served on either endpoint.
+	std::string Render();
+
+private:
+	void Run();
+	void WriteFile();
+	void ServeClient(int clientSocket);
+
+	const SimulationMetrics* Metrics = nullptr;
+	MetricsExporterConfiguration Configuration;
+
+	std::thread Thread;
+	std::atomic<bool> StopRequested{ false };
+	int ListenSocket = -1;
+
+	// Counter values at the previous Render(), for the rates.
+	using Clock = std::chrono::steady_clock;
+	std::mutex RatesMutex;
+	Clock::time_point PreviousRenderTime;
+	uint64_t PreviousNumTicks = 0;
+	double PreviousSimulatedSeconds = 0.0;
+	double TicksPerSecond = 0.0;
+	double SimulatedSecondsPerSecond = 0.0;
+};
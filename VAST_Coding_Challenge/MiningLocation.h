@@ -8,11 +8,17 @@ enum class EMiningLocationState : size_t
 	ActivelyBeingMined, // The mining location is actively being mined
 };
 
-class MiningLocation : public BaseEntity
+class MiningLocation;
+using MiningLocationHandle = EntityHandle<MiningLocation>;
+
+class MiningLocation final : public TypedEntity<MiningLocation>
 {
-	using Base = BaseEntity;
+	using Base = TypedEntity<MiningLocation>;
 
 public:	
+	// Memory accounting bucket the entity is counted in while it is owned by an EntityPool.
+	static constexpr EMemorySubsystem MemorySubsystem = EMemorySubsystem::MiningLocations;
+
 	MiningLocation() = default;
 	~MiningLocation() override = default;
 
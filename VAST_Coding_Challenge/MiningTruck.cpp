@@ -1,15 +1,13 @@
 #include "MiningTruck.h"
+#include "VectorMath.h"
 
 /*
 * Update function to update the Mining and Unloading states.
 */
-void MiningTruck::Tick(float deltaTime)
+void MiningTruck::Tick(SimulationTime deltaTime)
 {
-	if (State == EMiningTruckState::Mining)
-	{
-		MineLocation(deltaTime);
-	}
-	else if (State == EMiningTruckState::Unloading)
+	// Mining trucks aren't ticked. They wait on simulation time instead, see StartMiningWait().
+	if (State == EMiningTruckState::Unloading)
 	{
 		UnloadHelium(deltaTime);
 	}
@@ -26,15 +24,27 @@ EMiningTruckState MiningTruck::GetState() const
 /*
 * Returns how much time is left to Mine a Location.
 */
-float MiningTruck::GetRemainingMiningTime() const
+SimulationTime MiningTruck::GetRemainingMiningTime(SimulationTime now) const
 {
+	if (State == EMiningTruckState::Mining && MiningTimeLeft > 0)
+	{
+		return MiningCompletesAt > now ? MiningCompletesAt - now : 0;
+	}
+
 	return MiningTimeLeft;
 }
 
+/*
+* Returns the simulation time the current mining wait ends at.
+*/
+SimulationTime MiningTruck::GetMiningCompletesAt() const
+{
+	return MiningCompletesAt;
+}
 /*
 * Returns how much time is left to Unload Helim 3 at a Location.
 */
-float MiningTruck::GetRemainingUnloadingTime() const
+SimulationTime MiningTruck::GetRemainingUnloadingTime() const
 {
 	return UnloadingTimeLeft;
 }
@@ -46,7 +56,7 @@ float MiningTruck::GetRemainingUnloadingTime() const
 * The Calculation is: TotalHeliumUnloaded / TotalSimRunTime.
 * This gives an efficiency rating per truck that will slowly diminish while the truck is traveling between mining locations and unloading stations, and while waiting in queue.
 */
-float MiningTruck::GetTotalHeliumUnloaded() const
+SimulationTime MiningTruck::GetTotalHeliumUnloaded() const
 {
 	return TotalHeliumUnloaded;
 }
@@ -85,32 +95,26 @@ void MiningTruck::SetMiningTruckSpeed(float miningTruckSpeed)
 */
 float MiningTruck::CalculateDistanceToFinalLocation() const
 {
-	float pathLength = 0.0f;
-	std::vector<Vector> pathPoints;
+	constexpr unsigned int NumPathPoints = 20;
+	Vector4 pathPoints[NumPathPoints];
 
 	// Pseudo-code. Fill the path poitns with a random set of points.
-	for (unsigned int i = 0; i < 20; ++i)
+	for (unsigned int i = 0; i < NumPathPoints; ++i)
 	{
 		Vector randomVector;
 		randomVector.Randomize();
-		pathPoints.push_back(randomVector);
+		pathPoints[i] = Vector4(randomVector);
 	}
 
-	for (unsigned int i = 1; i < pathPoints.size(); ++i)
-	{
-		const Vector& pathSegmentEnd = pathPoints[i];
-		const Vector& pathSegmentStart = pathPoints[i - 1];
-
-		// The length of the path to the end point is sum of the lengths of each segement in the path.
-		Vector segment = pathSegmentEnd - pathSegmentStart;
-		pathLength += segment.Size();
-	}
-	return pathLength;
+	// The length of the path to the end point is sum of the lengths of each segement in the path.
+	return VectorMath::PolylineLength(pathPoints, NumPathPoints);
 }
 
 /*
 * Given a path length from the function above, we calculate a travel speed to ensure the travel time takes 30 minutes along the path.
 * The formula used is: Speed = Distance / Time
+* Walking the path draws 60 random numbers, so it is only done once the speed is actually read (see GetMiningTruckTravelSpeed()).
+* Moving only marks the speed as out of date.
 */
 void MiningTruck::CalculateMiningTruckSpeed(EMiningTruckMovementTarget movementTarget)
 {
@@ -120,13 +124,26 @@ void MiningTruck::CalculateMiningTruckSpeed(EMiningTruckMovementTarget movementT
 		return;
 	}
 
-	// Use the distance to travel to the end point to calculate the speed required to get there in exactly 30 min.
-	float distanceToTravel = CalculateDistanceToFinalLocation();
-	float thirtyMinutesAsSeconds = 1800.0f;
+	MiningTruckTravelSpeedOutOfDate = true;
+}
+
+/*
+* Returns the travel speed for the truck's current path, working it out if the truck has started a new move since it was last read.
+*/
+float MiningTruck::GetMiningTruckTravelSpeed()
+{
+	if (MiningTruckTravelSpeedOutOfDate)
+	{
+		// Use the distance to travel to the end point to calculate the speed required to get there in exactly 30 min.
+		float distanceToTravel = CalculateDistanceToFinalLocation();
+		float thirtyMinutesAsSeconds = 1800.0f;
+
+		// Speed = Distance / Time.
+		MiningTruckTravelSpeed = distanceToTravel / thirtyMinutesAsSeconds;
+		MiningTruckTravelSpeedOutOfDate = false;
+	}
 
-	// Speed = Distance / Time.
-	float travelSpeed = distanceToTravel / thirtyMinutesAsSeconds;
-	MiningTruckTravelSpeed = travelSpeed;
+	return MiningTruckTravelSpeed;
 }
 
 /*
@@ -183,7 +200,7 @@ bool MiningTruck::MoveToLocation(BaseEntity* location, EMiningTruckMovementTarge
 void MiningTruck::OnArrivedAtMiningLocation()
 {
 	MoveCompleted.Unbind();
-	OnMoveToMiningLocationComplete.ExecuteIfBound(GetUniqueId());
+	OnMoveToMiningLocationComplete.ExecuteIfBound(GetHandle());
 }
 
 /*
@@ -192,7 +209,7 @@ void MiningTruck::OnArrivedAtMiningLocation()
 void MiningTruck::OnArrivedAtUnloadingQueue()
 {
 	MoveCompleted.Unbind();
-	OnMoveToUnloadingQueueComplete.ExecuteIfBound(GetUniqueId());
+	OnMoveToUnloadingQueueComplete.ExecuteIfBound(GetHandle());
 }
 
 /*
@@ -201,7 +218,7 @@ void MiningTruck::OnArrivedAtUnloadingQueue()
 void MiningTruck::OnArrivedAtUnloadingLocation()
 {
 	MoveCompleted.Unbind();
-	OnMoveToUnloadingLocationComplete.ExecuteIfBound(GetUniqueId());
+	OnMoveToUnloadingLocationComplete.ExecuteIfBound(GetHandle());
 }
 
 /*
@@ -216,17 +233,68 @@ void MiningTruck::SetMiningAndUnloadingTimes(const MiningAndUnloadingTimes& mini
 	MaxUnloadingTimeMinutes = miningAndUnloadingTimes.MaxUnloadingTimeMinutes;
 }
 
+/*
+* Returns the dense index of this truck within the fleet. Slots of trucks that left the simulation are reused, so the index space stays dense.
+*/
+unsigned int MiningTruck::GetFleetIndex() const
+{
+	return GetHandle().Index;
+}
+
+/*
+* Appends the truck state and remaining timers to a state signature. The mining time is appended relative to now.
+*/
+void MiningTruck::AppendStateSignature(StateSignature& signature, SimulationTime now) const
+{
+	signature.push_back(static_cast<uint64_t>(State));
+	signature.push_back(static_cast<uint64_t>(GetRemainingMiningTime(now)));
+	signature.push_back(static_cast<uint64_t>(UnloadingTimeLeft));
+}
+
+/*
+* Adds Helium-3 that was unloaded during extrapolated simulation time to the truck's total.
+*/
+void MiningTruck::AddExtrapolatedHelium(SimulationTime heliumUnloaded)
+{
+	TotalHeliumUnloaded += heliumUnloaded;
+}
+
+/*
+* Sets the total Helium-3 unloaded. Used when a truck is transferred in from another simulation and keeps its history.
+*/
+void MiningTruck::SetTotalHeliumUnloaded(SimulationTime totalHeliumUnloaded)
+{
+	TotalHeliumUnloaded = totalHeliumUnloaded;
+}
+
+/*
+* Returns the station whose queue the truck is in, or that it is unloading at.
+*/
+EntityHandle<UnloadingLocation> MiningTruck::GetQueuedUnloadingLocation() const
+{
+	return QueuedUnloadingLocation;
+}
+
+/*
+* Set by the station when the truck joins its queue, and cleared once the truck has finished unloading there.
+*/
+void MiningTruck::SetQueuedUnloadingLocation(EntityHandle<UnloadingLocation> unloadingLocationHandle)
+{
+	QueuedUnloadingLocation = unloadingLocationHandle;
+}
+
 /*
 * Calculates how long to take to Mine a Location.
 */
 void MiningTruck::CalculateMiningTimer()
 {
 	// The calculations here could all have been on one line, but I felt like splitting hours, minutes, and seconds out made the code clearer.
-	float lambda = static_cast<float>(rand()) / RAND_MAX;
-	float hours = (1.0f - lambda) * MinMiningTimeHours + lambda * MaxMiningTimeHours;
+	float lambda = SimulationPolicies::Random::NextUnitFloat();
+	// Offset from the minimum, so equal min and max times give exactly that time whatever lambda is. Durations that vary by rounding never repeat.
+	float hours = MinMiningTimeHours + lambda * (MaxMiningTimeHours - MinMiningTimeHours);
 	float minutes = hours * 60.0f;
 	float seconds = minutes * 60.0f;
-	MiningTimeLeft = seconds;
+	MiningTimeLeft = SecondsToSimulationTime(seconds);
 }
 /*
 * Calculates how long to take to Unlaod Helium-3 at a Unloading Location.
@@ -234,30 +302,47 @@ void MiningTruck::CalculateMiningTimer()
 void MiningTruck::CalculateUnloadTimer()
 {
 	// The calculations here could all have been on one line, but I felt like splitting hours, minutes, and seconds out made the code clearer.
-	float lambda = static_cast<float>(rand()) / RAND_MAX;
-	float minutes = (1.0f - lambda) * MinUnloadingTimeMinutes + lambda * MaxUnloadingTimeMinutes;
+	float lambda = SimulationPolicies::Random::NextUnitFloat();
+	float minutes = MinUnloadingTimeMinutes + lambda * (MaxUnloadingTimeMinutes - MinUnloadingTimeMinutes);
 	float seconds = minutes * 60.0f;
-	UnloadingTimeLeft = seconds;
+	UnloadingTimeLeft = SecondsToSimulationTime(seconds);
 }
 
 /*
-* Performs minining of Helium-3.
+* Starts waiting out the mining time calculated when the truck started mining.
 * Mining 1 unit of Helium-3 is equivalent to 1 second of time.
 * 1 Helium-3 = 1 Second. In this case, Time is our currency / commodity.
+* Nothing happens during the wait, so rather than counting the time down every tick the truck records when it is done,
+* and the controller's scheduler resumes it with FinishMining() on the first tick at or after that time.
 */
-void MiningTruck::MineLocation(float deltaTime)
+void MiningTruck::StartMiningWait(SimulationTime now)
 {
-	if (MiningTimeLeft > 0.0f)
+	MiningCompletesAt = now + MiningTimeLeft;
+}
+
+/*
+* Called by the scheduler once the mining wait is over.
+*/
+void MiningTruck::FinishMining()
+{
+	if (MiningTimeLeft > 0)
 	{
-		MiningTimeLeft -= deltaTime;
-		if (MiningTimeLeft <= 0.0f)
-		{
-			// To keep things neat and tidy, ensure we reset the remaining mining time to the default value.
-			MiningTimeLeft = 0.0f;
+		// To keep things neat and tidy, ensure we reset the remaining mining time to the default value.
+		MiningTimeLeft = 0;
 
-			// Mining has completed.
-			OnMiningCompleted.ExecuteIfBound(GetUniqueId());
-		}
+		// Mining has completed.
+		OnMiningCompleted.ExecuteIfBound(GetHandle());
+	}
+}
+
+/*
+* Moves the end of the mining wait forward after simulation time was skipped by steady state extrapolation.
+*/
+void MiningTruck::AdvanceMiningWait(SimulationTime time)
+{
+	if (State == EMiningTruckState::Mining)
+	{
+		MiningCompletesAt += time;
 	}
 }
 
@@ -266,22 +351,22 @@ void MiningTruck::MineLocation(float deltaTime)
 * Unloading 1 unit of Helium-3 is equivalent to 1 second of time.
 * 1 Helium-3 = 1 Second. In this case, Time is our currency / commodity. :)
 */
-void MiningTruck::UnloadHelium(float deltaTime)
+void MiningTruck::UnloadHelium(SimulationTime deltaTime)
 {
-	if (UnloadingTimeLeft > 0.0f)
+	if (UnloadingTimeLeft > 0)
 	{
 		UnloadingTimeLeft -= deltaTime;
-		if (UnloadingTimeLeft <= 0.0f)
+		if (UnloadingTimeLeft <= 0)
 		{
 			// To keep things neat and tidy, ensure we reset the remaining mining time to the default value.
-			UnloadingTimeLeft = 0.0f;
+			UnloadingTimeLeft = 0;
 
 			// Mining has completed.
-			OnUnloadingCompleted.ExecuteIfBound(GetUniqueId());
+			OnUnloadingCompleted.ExecuteIfBound(GetHandle());
 		}
 
 		// Notify Observers (Unloading Locations) that the amount of helium has changed.
-		OnUnloadHelium.ExecuteIfBound(GetUniqueId(), deltaTime);
+		OnUnloadHelium.ExecuteIfBound(GetHandle(), deltaTime);
 		TotalHeliumUnloaded += deltaTime;
 	}
 }
\ No newline at end of file
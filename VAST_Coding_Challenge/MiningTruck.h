@@ -1,6 +1,10 @@
 #pragma once
 #include "BaseEntity.h"
 #include "Delegate.h"
+#include "SimulationPolicies.h"
+
+#include <cstdint>
+#include <vector>
 
 enum class EMiningTruckState : size_t
 {
@@ -13,6 +17,8 @@ enum class EMiningTruckState : size_t
 	Unloading                   // The truck is unloading Helium-3.
 };
 
+constexpr size_t NumMiningTruckStates = static_cast<size_t>(EMiningTruckState::Unloading) + 1;
+
 enum class EMiningTruckMovementTarget : size_t
 {
 	MiningLocation,				// The truck is moving to a Mining Location.
@@ -20,62 +26,93 @@ enum class EMiningTruckMovementTarget : size_t
 	UnloadingLocation			// The truck is moving into the unloading station.
 };
 
-class MiningTruck : public BaseEntity
+class MiningTruck;
+using MiningTruckHandle = EntityHandle<MiningTruck>;
+
+class UnloadingLocation;
+
+class MiningTruck final : public TypedEntity<MiningTruck>
 {
 public:	
+	// Memory accounting bucket the entity is counted in while it is owned by an EntityPool.
+	static constexpr EMemorySubsystem MemorySubsystem = EMemorySubsystem::MiningTrucks;
+
 	MiningTruck() = default;
 	~MiningTruck() override = default;
 
-	virtual void Tick(float deltaTime);
+	void Tick(SimulationTime deltaTime);
 
 	EMiningTruckState GetState() const;
-	float GetRemainingMiningTime() const;
-	float GetRemainingUnloadingTime() const;
-	float GetTotalHeliumUnloaded() const;
+	SimulationTime GetRemainingMiningTime(SimulationTime now) const;
+	SimulationTime GetMiningCompletesAt() const;
+	SimulationTime GetRemainingUnloadingTime() const;
+	SimulationTime GetTotalHeliumUnloaded() const;
 	void SetState(EMiningTruckState newState);
 	void SetMiningTruckSpeed(float miningTruckSpeed);
 	float CalculateDistanceToFinalLocation() const;
 	void CalculateMiningTruckSpeed(EMiningTruckMovementTarget movementTarget);
+	float GetMiningTruckTravelSpeed();
 	bool MoveToLocation(BaseEntity* location, EMiningTruckMovementTarget movementTarget);
 	void OnArrivedAtMiningLocation();
 	void OnArrivedAtUnloadingQueue();
 	void OnArrivedAtUnloadingLocation();
 	void SetMiningAndUnloadingTimes(const MiningAndUnloadingTimes& miningAndUnloadinTimes);
 
+	// Dense index of the truck within the fleet (its slot in the controller's truck pool). Used to key per-truck arrays and bitmaps.
+	unsigned int GetFleetIndex() const;
+
+	// Appends the values that determine how this truck will behave from now on. Used to detect when the simulation becomes periodic.
+	void AppendStateSignature(StateSignature& signature, SimulationTime now) const;
+
+	// Credits Helium-3 unloaded during simulation time that was extrapolated rather than simulated.
+	void AddExtrapolatedHelium(SimulationTime heliumUnloaded);
+
+	// Restores the Helium-3 total of a truck transferred in from another simulation.
+	void SetTotalHeliumUnloaded(SimulationTime totalHeliumUnloaded);
+
+	// The station the truck is queued or unloading at, invalid if none. Kept by the station, so a truck is never queued twice.
+	EntityHandle<UnloadingLocation> GetQueuedUnloadingLocation() const;
+	void SetQueuedUnloadingLocation(EntityHandle<UnloadingLocation> unloadingLocationHandle);
+
 	// Calculates a time between 1 and 5 hours, in seconds. Time will be used in combination with delta time (from tick) to countdown remaining mining time.
 	void CalculateMiningTimer();
 
 	// Calculates a time that is exactly 5 minuntes (in seconds).
 	void CalculateUnloadTimer();
 
+	// Mining is a wait on simulation time. The truck isn't ticked while it mines: the controller's scheduler calls FinishMining() once it is up.
+	void StartMiningWait(SimulationTime now);
+	void FinishMining();
+	void AdvanceMiningWait(SimulationTime time);
+
 	// Callback Delegate instances.
 	Delegate<> MoveCompleted;									// No args required for this callback delegate.
-	Delegate<unsigned int> OnMoveToMiningLocationComplete;
-	Delegate<unsigned int> OnMiningCompleted;
-	Delegate<unsigned int> OnMoveToUnloadingQueueComplete;
-	Delegate<unsigned int> OnMoveToUnloadingLocationComplete;
-	Delegate<unsigned int> OnUnloadingCompleted;
-	Delegate<unsigned int, float> OnUnloadHelium;
+	Delegate<MiningTruckHandle> OnMoveToMiningLocationComplete;
+	Delegate<MiningTruckHandle> OnMiningCompleted;
+	Delegate<MiningTruckHandle> OnMoveToUnloadingQueueComplete;
+	Delegate<MiningTruckHandle> OnMoveToUnloadingLocationComplete;
+	Delegate<MiningTruckHandle> OnUnloadingCompleted;
+	Delegate<MiningTruckHandle, SimulationTime> OnUnloadHelium;
 
 private:
 
-	// Perform mining truck action of actually mining a location.
-	void MineLocation(float deltaTime);
-
 	// Perform mining truck action of unloading Helium-3.
-	void UnloadHelium(float deltaTime);
+	void UnloadHelium(SimulationTime deltaTime);
 
 	// Mining Truck State.
 	EMiningTruckState State = EMiningTruckState::Idle;
 
-	// Time values are measured in seconds.
-	float MiningTimeLeft = 0.0f;
-	float UnloadingTimeLeft = 0.0f;
+	// Time values are measured in SimulationTime (microseconds).
+	SimulationTime MiningTimeLeft = 0;
+	SimulationTime MiningCompletesAt = 0;
+	SimulationTime UnloadingTimeLeft = 0;
 	float MiningTruckSpeedMultiplier = 1.0f;
-	float TotalHeliumUnloaded = 0.0f;
+	SimulationTime TotalHeliumUnloaded = 0;
+	EntityHandle<UnloadingLocation> QueuedUnloadingLocation;
 
 	// Calculated speed on the Mining Truck given the distance to the target location.
 	float MiningTruckTravelSpeed = 1.0f;
+	bool MiningTruckTravelSpeedOutOfDate = false;
 
 	// Times to spend Mining.
 	float MinMiningTimeHours = 1.0f;
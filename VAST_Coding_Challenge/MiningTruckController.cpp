@@ -2,20 +2,84 @@
 
 #include "MiningTruck.h"
 #include "MiningLocation.h"
+#include "SimulationTrace.h"
 #include "UnloadingLocation.h"
+#include "VectorMath.h"
 
+#include <algorithm>
 #include <cmath>
+#include <ctime>
+#include <limits>
 
 constexpr double PI = 3.141592653589793;
 
+// Bound on the number of period boundary hashes kept in memory while looking for a repeating state. Each is a hash and a time, whatever the fleet size.
+constexpr size_t MaxSteadyStateSamples = 4096;
+
+// Signature words hashed per run before detection gives up. Building a signature visits every truck, so with a large fleet it can cost far more
+// than the ticks it would skip; without a period found by then, the rest of the run is simply simulated.
+constexpr uint64_t MaxSteadyStateSignatureWords = uint64_t(1) << 24;
+
+// Circular spawn positions are stepped by a rotation, and recomputed exactly with cos / sin this often so rounding can't build up.
+constexpr unsigned int SpawnRotationResyncInterval = 4096;
+
+// Longest step a tick simulates at once. A truck that finishes mining or unloading part way through a step only moves on at the next one,
+// so results depend on the step length. Longer deltas (e.g. the pacer catching up at high playback speed) are split into steps of this.
+constexpr SimulationTime MaxTickStep = SimulationTimeTicksPerSecond;
+
+// Registry lookups by entity type, used by the templated spawn functions. Specialized before anything can instantiate them.
+template<>
+EntityPool<MiningTruck>& MiningTruckController::GetRegistry<MiningTruck>()
+{
+	return MiningTruckRegistry;
+}
+
+template<>
+EntityPool<MiningLocation>& MiningTruckController::GetRegistry<MiningLocation>()
+{
+	return MiningLocationRegistry;
+}
+
+template<>
+EntityPool<UnloadingLocation>& MiningTruckController::GetRegistry<UnloadingLocation>()
+{
+	return UnloadingLocationRegistry;
+}
+
 /*
 * Primary Tick (update) function.
-* Ticks the Simulation Timer, and all Entities performing actions in the Simulation.
+* Advances the simulation by deltaSeconds, in steps of at most MaxTickStep, so the result is the same however the time is handed out.
+*/
+bool MiningTruckController::Tick(float deltaSeconds)
+{
+	TRACE_SCOPE("Tick");
+
+	// Scale the change in time by the Global Time Dilation value, then convert to integer Simulation Time for the rest of the update.
+	SimulationTime deltaTime = SecondsToSimulationTime(deltaSeconds * SimulationTimer.GetGlobalTimeDilation());
+
+	do
+	{
+		SimulationTime stepTime = std::min(deltaTime, MaxTickStep);
+		deltaTime -= stepTime;
+		if (TickStep(stepTime))
+		{
+			return true;
+		}
+	} while (deltaTime > 0);
+
+	return false;
+}
+
+/*
+* Simulates one step. Ticks the Simulation Timer, and all Entities performing actions in the Simulation.
 */
-bool MiningTruckController::Tick(float deltaTime)
+bool MiningTruckController::TickStep(SimulationTime deltaTime)
 {
-	// Scale the change in time by the Global Time Dilation value.
-	deltaTime *= SimulationTimer.GetGlobalTimeDilation();
+	if (Converged)
+	{
+		// Stopped early, the efficiency estimate is already within tolerance.
+		return true;
+	}
 
 	// Tick the Simulation Timer.
 	bool exit = SimulationTimer.Tick(deltaTime);
@@ -25,48 +89,82 @@ bool MiningTruckController::Tick(float deltaTime)
 		return true;
 	}
 
-	// Tick (update) every truck.
-	for (auto iterator : MiningTruckRegistry)
-	{
-		MiningTruck* miningTruckPtr = reinterpret_cast<MiningTruck*>(iterator.second);
-		if (miningTruckPtr)
-		{
-			miningTruckPtr->Tick(deltaTime);
-		}
-	}
+	// Update the trucks. Completions raised here are only buffered, so the registry is never modified while we iterate it.
+	// Trucks that are mining are suspended until their mining time is up, and every other state is instant, so only due and unloading trucks are visited.
+	ResumeDueMiningTrucks(SimulationTimer.GetElapsedSimulationTime());
+	TickUnloadingMiningTrucks(deltaTime);
+
+	// A tick where trucks finish unloading is a candidate period boundary for steady state detection.
+	bool steadyStateBoundary = !TickCompletionEvents.UnloadingCompleted.empty();
+
+	SimulationPolicies::Instrumentation::OnTick(TickCompletionEvents.MiningCompleted.size(), TickCompletionEvents.UnloadingCompleted.size());
+
+	// Respond to every truck that finished mining or unloading this tick.
+	DispatchCompletionEvents();
 
 	// Mining Locations don't need to tick. They only have state changes.
 
 	// Tick (update) every unloading location.
-	for (auto iterator : UnloadingLocationRegistry)
 	{
-		UnloadingLocation* unloadingLocationPtr = reinterpret_cast<UnloadingLocation*>(iterator.second);
-		if (unloadingLocationPtr)
+		TRACE_SCOPE("TickUnloadingLocations");
+		for (UnloadingLocation* unloadingLocationPtr : UnloadingLocationRegistry)
 		{
 			unloadingLocationPtr->Tick(deltaTime);
 		}
 	}
 
+	if (Metrics)
+	{
+		UpdateMetrics();
+	}
+
+	if (TimeSeries.IsSampleDue(SimulationTimer.GetElapsedSimulationTime()))
+	{
+		RecordTimeSeriesSample();
+	}
+
+	if (SimulationPolicies::EnableSteadyStateExtrapolation && steadyStateBoundary && CanExtrapolateSteadyState())
+	{
+		DetectSteadyStateCycle(deltaTime);
+	}
+
+	if (SimulationPolicies::EnableConvergenceStopping && UpdateConvergence())
+	{
+		return true;
+	}
+
 	// Return false. As returning true will exit the simulation.
 	return false;
 }
 
 /*
 * Clean up function called when the Simulation is complete.
-* Destroys all Entities that were peforming Actions and were allocated dynamically, then clears any Maps that their pointers were housed in.
+* Destroys all Entities that were peforming Actions and were allocated dynamically, then clears any state that referred to them.
 */
 OperationEfficiency MiningTruckController::Teardown()
 {
+	TRACE_SCOPE("Teardown");
 	OperationEfficiency efficiency = GetOperationEfficiency();
+
+	// A run rarely ends right on a sample. Take one more so the time series reaches the end of the run.
+	if (TimeSeries.IsEnabled())
+	{
+		if (SimulationTimer.GetElapsedSimulationTime() > TimeSeries.GetLastSampleTime())
+		{
+			RecordTimeSeriesSample();
+		}
+		TimeSeries.Finish();
+	}
+
 	DestroyAllEntities();
 	
-	// Since all entities have been destroyed at this point, clear all state related maps.
-	MoveToMiningLocationPending.clear();
-	ActiveMiningTrucks.clear();
-	MovingToUnloadingLocationPending.clear();
-	MiningTrucksPendingUnload.clear();
-	MiningTrucksTransitioningToUnload.clear();
-	ActiveUnloadingTrucks.clear();
+	// Since all entities have been destroyed at this point, clear all remaining simulation state.
+	TickCompletionEvents.Clear();
+	Dispatcher.Reset(SimConfig.DispatchStrategy, SimConfig.DispatchTravelSpeed);
+	ResetSteadyStateDetection();
+	SteadyStateExtrapolated = false;
+	NumSteadyStateSignatureWords = 0;
+	ResetConvergence();
 
 	return efficiency;
 }
@@ -76,26 +174,46 @@ OperationEfficiency MiningTruckController::Teardown()
 */
 OperationEfficiency MiningTruckController::GetOperationEfficiency() const
 {
-	float elapsedSimulationTime = SimulationTimer.GetElapsedSimulationTime();
+	double elapsedSimulationTime = static_cast<double>(SimulationTimer.GetElapsedSimulationTime());
 	OperationEfficiency efficiency;
 	efficiency.GlobalEfficiency = GetMiningEfficiency();
+	efficiency.SimulatedTimeSeconds = SimulationTimeToSeconds(SimulationTimer.GetElapsedSimulationTime());
 
-	for (auto iterator : MiningTruckRegistry)
+	if (SimConfig.ConvergenceTolerance > 0.0f && EfficiencyBatchMeans.GetNumBatches() > 1)
 	{
-		MiningTruck* miningTruckPtr = reinterpret_cast<MiningTruck*>(iterator.second);
-		if (miningTruckPtr)
-		{
-			efficiency.PerTruckEfficiency.push_back(miningTruckPtr->GetTotalHeliumUnloaded() / elapsedSimulationTime);
-		}
+		efficiency.Converged = Converged;
+		efficiency.NumEfficiencyBatches = EfficiencyBatchMeans.GetNumBatches();
+		efficiency.EstimatedEfficiency = static_cast<float>(EfficiencyBatchMeans.GetMean());
+		efficiency.EfficiencyConfidenceHalfWidth = static_cast<float>(EfficiencyBatchMeans.GetConfidenceHalfWidth());
 	}
 
-	for (auto iterator : UnloadingLocationRegistry)
+	for (MiningTruck* miningTruckPtr : MiningTruckRegistry)
 	{
-		UnloadingLocation* unloadingLocationPtr = reinterpret_cast<UnloadingLocation*>(iterator.second);
-		if (unloadingLocationPtr)
-		{
-			efficiency.PerUnloadingLocationEfficiency.push_back(unloadingLocationPtr->GetTotalUnloadingTime() / elapsedSimulationTime);
-		}
+		efficiency.PerTruckEfficiency.push_back(static_cast<float>(miningTruckPtr->GetTotalHeliumUnloaded() / elapsedSimulationTime));
+	}
+
+	for (UnloadingLocation* unloadingLocationPtr : UnloadingLocationRegistry)
+	{
+		efficiency.PerUnloadingLocationEfficiency.push_back(static_cast<float>(unloadingLocationPtr->GetTotalUnloadingTime() / elapsedSimulationTime));
+	}
+
+	// What each truck costs: the truck, the mining location spawned for it, its assignment entry, and (mostly truck) bound delegates.
+	// What each station costs: the station, its queue (sized for its share of the fleet, more if it had to grow), and its entry in the dispatcher.
+	MemoryFootprint& memory = efficiency.Memory;
+	memory = MemoryAccounting::GetFootprint();
+	if (MiningTruckRegistry.Size() > 0)
+	{
+		int64_t truckBytes = memory[EMemorySubsystem::MiningTrucks].Bytes + memory[EMemorySubsystem::MiningLocations].Bytes +
+							 memory[EMemorySubsystem::TruckAssignments].Bytes + memory[EMemorySubsystem::Delegates].Bytes +
+							 memory[EMemorySubsystem::Scheduling].Bytes;
+		memory.BytesPerMiningTruck = static_cast<double>(truckBytes) / MiningTruckRegistry.Size();
+	}
+
+	if (UnloadingLocationRegistry.Size() > 0)
+	{
+		int64_t stationBytes = memory[EMemorySubsystem::UnloadingLocations].Bytes + memory[EMemorySubsystem::UnloadingQueues].Bytes +
+							   memory[EMemorySubsystem::Dispatch].Bytes;
+		memory.BytesPerUnloadingLocation = static_cast<double>(stationBytes) / UnloadingLocationRegistry.Size();
 	}
 
 	return efficiency;
@@ -110,29 +228,37 @@ float MiningTruckController::GetMiningTruckSpeed()
 }
 
 /*
-* Increases the Simulation speed by Dilating it's accumulation of time.
+* Doubles the Playback Speed. Playback speed sets how fast an interactive run is paced against the wall clock (see SimulationPacer),
+* it doesn't change the length of a tick, so the simulation behaves the same at any speed.
 */
 void MiningTruckController::IncreasePlaybackSpeed()
 {
-	SimulationPlaybackSpeed += 1.0f;
-	if (SimulationPlaybackSpeed > 5.0f) // 5x is the max simulation speed.
-	{
-		SimulationPlaybackSpeed = 5.0f;
-	}
-	SimulationTimer.SetGlobalTimeDialation(SimulationPlaybackSpeed);
+	SetPlaybackSpeed(SimulationPlaybackSpeed * 2.0f);
 }
 
 /*
-* Decreases the Simulation speed by contracting it's accumulation of time.
+* Halves the Playback Speed.
 */
 void MiningTruckController::DecreasePlaybackSpeed()
 {
-	SimulationPlaybackSpeed -= 1.0f;
-	if (SimulationPlaybackSpeed < 1.0f) // 72 hours is a long time, no need to go even slower.
+	// 72 hours is a long time, no need to go slower than real time.
+	SetPlaybackSpeed(SimulationPlaybackSpeed * 0.5f);
+}
+
+/*
+* Sets the Playback Speed, clamped to [MinPlaybackSpeed, MaxPlaybackSpeed].
+*/
+void MiningTruckController::SetPlaybackSpeed(float playbackSpeed)
+{
+	SimulationPlaybackSpeed = playbackSpeed;
+	if (SimulationPlaybackSpeed < MinPlaybackSpeed)
 	{
-		SimulationPlaybackSpeed = 1.0f;
+		SimulationPlaybackSpeed = MinPlaybackSpeed;
+	}
+	else if (SimulationPlaybackSpeed > MaxPlaybackSpeed)
+	{
+		SimulationPlaybackSpeed = MaxPlaybackSpeed;
 	}
-	SimulationTimer.SetGlobalTimeDialation(SimulationPlaybackSpeed);
 }
 
 /*
@@ -142,13 +268,9 @@ void MiningTruckController::IncreaseTruckSpeed()
 {
 	MiningTruckSpeed += 1.0f;
 
-	for (auto iterator : MiningTruckRegistry)
+	for (MiningTruck* miningTruckPtr : MiningTruckRegistry)
 	{
-		MiningTruck* miningTruckPtr = reinterpret_cast<MiningTruck*>(iterator.second);
-		if (miningTruckPtr)
-		{
-			miningTruckPtr->SetMiningTruckSpeed(MiningTruckSpeed);
-		}
+		miningTruckPtr->SetMiningTruckSpeed(MiningTruckSpeed);
 	}
 }
 
@@ -163,18 +285,14 @@ void MiningTruckController::DecreaseTruckSpeed()
 		MiningTruckSpeed = 0.5f;
 	}
 
-	for (auto iterator : MiningTruckRegistry)
+	for (MiningTruck* miningTruckPtr : MiningTruckRegistry)
 	{
-		MiningTruck* miningTruckPtr = reinterpret_cast<MiningTruck*>(iterator.second);
-		if (miningTruckPtr)
-		{
-			miningTruckPtr->SetMiningTruckSpeed(MiningTruckSpeed);
-		}
+		miningTruckPtr->SetMiningTruckSpeed(MiningTruckSpeed);
 	}
 }
 
 /*
-* Returns the Time Dilation value of the Simulation.
+* Returns the Playback Speed of the Simulation.
 */
 float MiningTruckController::GetPlaybackSpeed() const
 {
@@ -187,13 +305,9 @@ float MiningTruckController::GetPlaybackSpeed() const
 std::vector<BaseEntity*> MiningTruckController::GetMiningTrucks() const
 {
 	std::vector<BaseEntity*> miningTrucks;
-	for (const auto& iterator : MiningTruckRegistry)
+	for (MiningTruck* miningTruckPtr : MiningTruckRegistry)
 	{
-		MiningTruck* miningTruckPtr = reinterpret_cast<MiningTruck*>(iterator.second);
-		if (miningTruckPtr)
-		{
-			miningTrucks.push_back(miningTruckPtr);
-		}
+		miningTrucks.push_back(miningTruckPtr);
 	}
 	return miningTrucks;
 }
@@ -203,7 +317,7 @@ std::vector<BaseEntity*> MiningTruckController::GetMiningTrucks() const
 */
 unsigned int MiningTruckController::GetNumMiningTrucks() const
 {
-	return MiningTruckRegistry.size();
+	return MiningTruckRegistry.Size();
 }
 
 /*
@@ -212,13 +326,9 @@ unsigned int MiningTruckController::GetNumMiningTrucks() const
 std::vector<BaseEntity*> MiningTruckController::GetUnloadingLocations() const
 {
 	std::vector<BaseEntity*> unloadingLocations;
-	for (const auto& iterator : UnloadingLocationRegistry)
+	for (UnloadingLocation* unloadingLocationPtr : UnloadingLocationRegistry)
 	{
-		UnloadingLocation* unloadingLocationPtr = reinterpret_cast<UnloadingLocation*>(iterator.second);
-		if (unloadingLocationPtr)
-		{
-			unloadingLocations.push_back(unloadingLocationPtr);
-		}
+		unloadingLocations.push_back(unloadingLocationPtr);
 	}
 	return unloadingLocations;
 }
@@ -228,7 +338,7 @@ std::vector<BaseEntity*> MiningTruckController::GetUnloadingLocations() const
 */
 float MiningTruckController::GetGlobalRemainingTime() const
 {
-	return SimulationTimer.GetRemainingGlobalTime();
+	return static_cast<float>(SimulationTimeToSeconds(SimulationTimer.GetRemainingGlobalTime()));
 }
 
 /*
@@ -241,25 +351,109 @@ float MiningTruckController::GetGlobalRemainingTime() const
 float MiningTruckController::GetMiningEfficiency() const
 {
 	// Sum up how much Helium-3 has been unloaded at this point in time.
-	float efficiency = 0.0f;
-	for (const auto& iterator : UnloadingLocationRegistry)
-	{
-		UnloadingLocation* unloadingLocationPtr = reinterpret_cast<UnloadingLocation*>(iterator.second);
-		if (unloadingLocationPtr)
-		{
-			efficiency += unloadingLocationPtr->GetTotalUnloadingTime();
-		}
-	}
+	SimulationTime totalUnloadingTime = GetTotalUnloadingTime();
 
 	// Calculation of efficiency = Total Amount of time spent unloading Helium-3 divided by the total elapsed time of the operation (up to 72 hours).
 	// Efficiency is expected to drop during moments where no truck us unloading cargo. As time is still elapsing.
-	float elapsedTime = SimulationTimer.GetMaxGlobalTime() - SimulationTimer.GetRemainingGlobalTime();
-	if (elapsedTime == 0.0f)
+	SimulationTime elapsedTime = SimulationTimer.GetMaxGlobalTime() - SimulationTimer.GetRemainingGlobalTime();
+	if (elapsedTime == 0)
 	{
 		return 0.0f;
 	}
 
-	return efficiency / elapsedTime;
+	return static_cast<float>(static_cast<double>(totalUnloadingTime) / static_cast<double>(elapsedTime));
+}
+
+/*
+* Summarizes the current state of the simulation: fleet states, station queues, and efficiency.
+*/
+void MiningTruckController::GetSimulationStatus(SimulationStatus& outStatus) const
+{
+	outStatus.ElapsedSeconds = SimulationTimeToSeconds(SimulationTimer.GetElapsedSimulationTime());
+	outStatus.RemainingSeconds = SimulationTimeToSeconds(SimulationTimer.GetRemainingGlobalTime());
+	outStatus.PlaybackSpeed = SimulationPlaybackSpeed;
+	outStatus.GlobalEfficiency = GetMiningEfficiency();
+	outStatus.NumMiningTrucks = MiningTruckRegistry.Size();
+
+	outStatus.NumMiningTrucksInState = NumMiningTrucksInState;
+
+	double elapsedSimulationTime = static_cast<double>(SimulationTimer.GetElapsedSimulationTime());
+	outStatus.UnloadingLocations.clear();
+	for (UnloadingLocation* unloadingLocationPtr : UnloadingLocationRegistry)
+	{
+		UnloadingLocationStatus unloadingLocationStatus;
+		unloadingLocationStatus.State = unloadingLocationPtr->GetState();
+		unloadingLocationStatus.QueueLength = unloadingLocationPtr->GetQueueLength();
+		unloadingLocationStatus.QueueTimeSeconds = SimulationTimeToSeconds(unloadingLocationPtr->GetQueueTime());
+		unloadingLocationStatus.Efficiency = elapsedSimulationTime > 0.0 ? static_cast<float>(unloadingLocationPtr->GetTotalUnloadingTime() / elapsedSimulationTime) : 0.0f;
+		outStatus.UnloadingLocations.push_back(unloadingLocationStatus);
+	}
+}
+
+/*
+* Subscribers see every state change from the moment they subscribe. Changes skipped over by steady state extrapolation are not published.
+*/
+SimulationEventBus& MiningTruckController::GetEventBus()
+{
+	return EventBus;
+}
+
+/*
+* Attaching part way through a run copies the fleet's state counts once. From then on they are kept up to date per state change.
+*/
+void MiningTruckController::SetMetrics(SimulationMetrics* metrics)
+{
+	Metrics = metrics;
+	if (!Metrics)
+	{
+		return;
+	}
+
+	Metrics->Reset(UnloadingLocationRegistry.GetNumSlots());
+	for (size_t state = 0; state < NumMiningTruckStates; ++state)
+	{
+		Metrics->AddMiningTrucks(static_cast<EMiningTruckState>(state), NumMiningTrucksInState[state]);
+	}
+	UpdateMetrics();
+}
+
+const SimulationTimeSeries& MiningTruckController::GetTimeSeries() const
+{
+	return TimeSeries;
+}
+
+void MiningTruckController::RecordTimeSeriesSample()
+{
+	TRACE_SCOPE("RecordTimeSeriesSample");
+	TimeSeries.BeginSample(SimulationTimer.GetElapsedSimulationTime(), GetMiningEfficiency(), GetTotalUnloadingTime(), NumMiningTrucksInState);
+	for (UnloadingLocation* unloadingLocationPtr : UnloadingLocationRegistry)
+	{
+		TimeSeries.AddUnloadingLocationQueueTime(unloadingLocationPtr->GetHandle().Index, unloadingLocationPtr->GetQueueTime());
+	}
+	TimeSeries.EndSample();
+}
+
+void MiningTruckController::UpdateMetrics()
+{
+	TRACE_SCOPE("UpdateMetrics");
+	Metrics->OnTick(SimulationTimer.GetElapsedSimulationTime(), SimulationTimer.GetRemainingGlobalTime(), GetMiningEfficiency());
+	for (UnloadingLocation* unloadingLocationPtr : UnloadingLocationRegistry)
+	{
+		Metrics->SetUnloadingLocationQueueLength(unloadingLocationPtr->GetHandle().Index, unloadingLocationPtr->GetQueueLength());
+	}
+}
+
+/*
+* Returns the time spent unloading Helium-3, summed over every Unloading Location.
+*/
+SimulationTime MiningTruckController::GetTotalUnloadingTime() const
+{
+	SimulationTime totalUnloadingTime = 0;
+	for (UnloadingLocation* unloadingLocationPtr : UnloadingLocationRegistry)
+	{
+		totalUnloadingTime += unloadingLocationPtr->GetTotalUnloadingTime();
+	}
+	return totalUnloadingTime;
 }
 
 /*
@@ -269,37 +463,74 @@ float MiningTruckController::GetMiningEfficiency() const
 */
 void MiningTruckController::StartSimulation(const SimulationConfiguration& simulationConfiguration)
 {
+	TRACE_SCOPE("StartSimulation");
 	SimConfig = simulationConfiguration;
-	SimulationTimer.SetSimulationMaxTime(SimConfig.SimulationMaxTimeSeconds);
+	SimulationTimer.SetSimulationMaxTime(SecondsToSimulationTime(SimConfig.SimulationMaxTimeSeconds));
+	SimulationTimer.SetLogSimulationTime(SimConfig.LogSimulationTime);
+	ResetConvergence();
 
 	NumMiningTrucksToSpawn = SimConfig.NumMiningTrucksToSpawn;
 	NumUnloadingLocationsToSpawn = SimConfig.NumUnloadingLocationsToSpawn;
+	Dispatcher.Reset(SimConfig.DispatchStrategy, SimConfig.DispatchTravelSpeed);
+
+	// Seeded before anything is spawned, so a configured seed repeats the whole run, locations included.
+	SimulationPolicies::Random::Seed(SimConfig.RandomSeed != 0 ? SimConfig.RandomSeed : static_cast<unsigned int>(time(0)));
 
 	SpawnActorsInCircularPattern<MiningTruck>(NumMiningTrucksToSpawn, [this](MiningTruck* miningTruck) {
 		if (miningTruck)
 		{
 			miningTruck->SetMiningAndUnloadingTimes(SimConfig.MiningAndUnloadingTimes);
-			MiningTruckRegistry.emplace(miningTruck->GetUniqueId(), miningTruck);
 		}
 	}, MiningTruckSpawnRadius);
 
+	NumMiningTrucksInState.fill(0);
+	NumMiningTrucksInState[static_cast<size_t>(EMiningTruckState::Idle)] = MiningTruckRegistry.Size();
+	if (Metrics)
+	{
+		Metrics->Reset(NumUnloadingLocationsToSpawn);
+		Metrics->AddMiningTrucks(EMiningTruckState::Idle, MiningTruckRegistry.Size());
+	}
+	TimeSeries.Reset(SimConfig.TimeSeriesIntervalSeconds, SimConfig.TimeSeriesMaxPoints, NumUnloadingLocationsToSpawn);
+
 	SpawnActorsInCircularPattern<UnloadingLocation>(NumUnloadingLocationsToSpawn, [this](UnloadingLocation* unloadingLocation) {
 		if (unloadingLocation)
 		{
 			// Pre-bind to the OnRequestMiningTruckStartUnloading delegate. As there is no need to ever have it unbound.
-			unloadingLocation->OnRequestMiningTruckStartUnloading.Bind([this](unsigned int truckUniqueId) {
-				OnRequestUnloadMiningTruck(truckUniqueId);
+			unloadingLocation->OnRequestMiningTruckStartUnloading.Bind([this](MiningTruckHandle miningTruckHandle) {
+				OnRequestUnloadMiningTruck(miningTruckHandle);
 			});
 
-			UnloadingLocationRegistry.emplace(unloadingLocation->GetUniqueId(), unloadingLocation);
+			// Size each queue for the station's share of the fleet, so queue storage across every station stays proportional to the fleet.
+			unloadingLocation->ReserveQueueCapacity((NumMiningTrucksToSpawn + NumUnloadingLocationsToSpawn - 1) / NumUnloadingLocationsToSpawn);
+			Dispatcher.AddUnloadingLocation(unloadingLocation);
 		}
 	}, UnloadingLocationSpawnRadius);
 
 	SpawnMiningLocations();
+
+	// At most every truck can complete in the same tick, size the event buffers for that so dispatching never allocates.
+	TickCompletionEvents.Reserve(NumMiningTrucksToSpawn);
+	Scheduler.Reserve(NumMiningTrucksToSpawn);
+	DueMiningTrucks.reserve(NumMiningTrucksToSpawn);
+	UnloadingMiningTrucks.reserve(NumUnloadingLocationsToSpawn);
+
 	BeginMiningOperation();
+}
 
-	// Set the initial simulation speed.
-	SimulationTimer.SetGlobalTimeDialation(SimulationPlaybackSpeed);
+/*
+* Starts a simulation, ticks it until the simulation time runs out, then tears it down and returns the Operation Efficiency.
+*/
+OperationEfficiency MiningTruckController::RunSimulation(const SimulationConfiguration& simulationConfiguration, float deltaTime /* = 1.0f */)
+{
+	StartSimulation(simulationConfiguration);
+
+	bool exit = false;
+	while (!exit)
+	{
+		exit = Tick(deltaTime);
+	}
+
+	return Teardown();
 }
 
 /*
@@ -358,59 +589,134 @@ unsigned int MiningTruckController::GetTotalUnloadingStations()
 }
 
 /*
-* Spawns a Single Entity of any type and returns a pointer to it.
-* This is a templated function so that we don't have to write the same function over and over just for a different Spawn type.
+* Removes one actively mining truck from the simulation and describes it in outTransfer so it can join another simulation.
+* Returns false if no truck is currently mining. The truck's mining location is released back to Idle.
 */
-template<typename T>
-T* MiningTruckController::SpawnEntity(const Vector& location)
+bool MiningTruckController::TransferOutMiningTruck(MiningTruckTransfer& outTransfer)
 {
-	T* entity = new T();
-	if (!entity)
+	for (MiningTruck* miningTruck : MiningTruckRegistry)
 	{
-		return nullptr;
+		MiningTruckAssignment& assignment = GetAssignment(miningTruck);
+		MiningLocation* miningLocation = MiningLocationRegistry.Resolve(assignment.ActiveMiningLocation);
+		if (!miningLocation)
+		{
+			continue;
+		}
+
+		ReleaseMiningLocation(miningLocation);
+
+		// The truck's slot (and so its fleet index) is freed for the next truck that joins, and every handle to it becomes stale.
+		outTransfer.TotalHeliumUnloaded = miningTruck->GetTotalHeliumUnloaded();
+		--NumMiningTrucksInState[static_cast<size_t>(miningTruck->GetState())];
+		if (Metrics)
+		{
+			Metrics->AddMiningTrucks(miningTruck->GetState(), -1);
+		}
+		assignment = MiningTruckAssignment();
+		MiningTruckRegistry.Destroy(miningTruck->GetHandle());
+
+		// The registry changed, so earlier state signatures can no longer be compared against.
+		ResetSteadyStateDetection();
+		return true;
 	}
 
-	entity->SetLocation(location);
+	return false;
+}
+
+/*
+* Spawns a truck described by a transfer from another simulation and sends it to mine.
+* Every truck needs a mining location of its own, so one is spawned along with the truck.
+*/
+void MiningTruckController::TransferInMiningTruck(const MiningTruckTransfer& transfer)
+{
+	Vector spawnLocation(MiningTruckSpawnRadius, 0.0f, 50.0f);
+	MiningTruck* miningTruck = SpawnEntity<MiningTruck>(spawnLocation);
+	if (!miningTruck)
+	{
+		return;
+	}
 
-	++NumSpawnedEntities;
-	entity->SetUniqueId(NumSpawnedEntities);
+	++NumMiningTrucksInState[static_cast<size_t>(miningTruck->GetState())];
+	if (Metrics)
+	{
+		Metrics->AddMiningTrucks(miningTruck->GetState(), 1);
+	}
 
-	return entity;
+	miningTruck->SetMiningAndUnloadingTimes(SimConfig.MiningAndUnloadingTimes);
+	miningTruck->SetTotalHeliumUnloaded(transfer.TotalHeliumUnloaded);
+	miningTruck->SetMiningTruckSpeed(MiningTruckSpeed);
+
+	Vector randomNavLocation;
+	randomNavLocation.Randomize();
+	MiningLocation* miningLocation = SpawnEntity<MiningLocation>(randomNavLocation);
+	if (miningLocation)
+	{
+		IdleMiningLocations.push(miningLocation->GetHandle());
+	}
+
+	ResetSteadyStateDetection();
+	FindLocationToMine(miningTruck);
 }
 
 /*
-* Destroys an entity that was spawned.
+* Returns the assignment entry of a truck. Entries are indexed by fleet index, so the table grows with the truck registry's slots.
 */
-void MiningTruckController::DestroyEntity(BaseEntity* entity) const
+MiningTruckAssignment& MiningTruckController::GetAssignment(const MiningTruck* miningTruck)
 {
-	if (entity)
+	unsigned int fleetIndex = miningTruck->GetFleetIndex();
+	if (fleetIndex >= MiningTruckAssignments.size())
 	{
-		delete entity;
-		entity = nullptr;
+		MiningTruckAssignments.resize(MiningTruckRegistry.GetNumSlots());
 	}
+
+	return MiningTruckAssignments[fleetIndex];
+}
+
+/*
+* Spawns a Single Entity of any type into its registry and returns a pointer to it.
+* This is a templated function so that we don't have to write the same function over and over just for a different Spawn type.
+*/
+template<typename T>
+T* MiningTruckController::SpawnEntity(const Vector& location)
+{
+	EntityPool<T>& registry = GetRegistry<T>();
+	T* entity = registry.Resolve(registry.Spawn());
+	if (!entity)
+	{
+		return nullptr;
+	}
+
+	entity->SetLocation(location);
+	SimulationPolicies::Instrumentation::OnEntitySpawned();
+
+	return entity;
 }
 
 /*
 * Spawns Mining Locations in random locations.
 * These are the mining Locations the Mining Trucks will use to gather Helium-3.
-* Also stores each Mining Truck in the MiningTruckRegistry map.
 */
 void MiningTruckController::SpawnMiningLocations()
 {
+	TRACE_SCOPE("SpawnMiningLocations");
 	// Spawn Mining Locations in a random pattern. Remember, the number of trucks = the number of mining locations, so NumMiningTrucksToSpawn is used here.
-	for (unsigned int i = 0; i < NumMiningTrucksToSpawn; ++i)
+	// Locations are drawn from the random stream one after another, so a seeded run places them the same way however the spawn is split up.
+	std::vector<Vector> randomNavLocations(NumMiningTrucksToSpawn);
+	for (Vector& randomNavLocation : randomNavLocations)
 	{
-		Vector randomNavLocation;
-		float miningLocationDistance = 0.0f;
-
 		// Pseudo-code. This Vector should be a random vector that is a valid location to spawn the Mining Location at.
 		randomNavLocation.Randomize();
+	}
 
-		BaseEntity* spawnedEntity = SpawnEntity<MiningLocation>(randomNavLocation);
-		if (spawnedEntity)
-		{
-			MiningLocationRegistry.emplace(spawnedEntity->GetUniqueId(), spawnedEntity );
-		}
+	std::vector<MiningLocationHandle> spawnedHandles(NumMiningTrucksToSpawn);
+	MiningLocationRegistry.SpawnMany(NumMiningTrucksToSpawn, spawnedHandles.data(), [&randomNavLocations](MiningLocation& miningLocation, size_t i) {
+		miningLocation.SetLocation(randomNavLocations[i]);
+	});
+
+	for (MiningLocationHandle spawnedHandle : spawnedHandles)
+	{
+		SimulationPolicies::Instrumentation::OnEntitySpawned();
+		IdleMiningLocations.push(spawnedHandle);
 	}
 }
 
@@ -418,40 +724,53 @@ void MiningTruckController::SpawnMiningLocations()
 * Spawns any Entity Type (T) in a circular pattern.
 * If we spawn 10 Mining Trucks they will spawn around the center defined by BaseLocation, and the angle will divided by 10 for each truck spawn.
 * This is a templated function so we can spawn any entity in a circular pattern.
+* Positions are worked out first, then every entity is spawned in one bulk call. onEntitySpawned is called afterwards, in spawn order.
 */
-template<typename T>
+template<typename T, typename OnEntitySpawned>
 void MiningTruckController::SpawnActorsInCircularPattern(unsigned int numActorsToSpawn,
-														 std::function<void(T*)> onEntitySpawned,
+														 OnEntitySpawned onEntitySpawned,
 														 float spawnRadius /* = 1.0f */)
 {
-	Vector baseLocation = Vector(0.0f, 0.0f, 0.0f);
-	float spawnAngle = 0.0f;
-	float degreeOffset = 360.0f / numActorsToSpawn;
-	for (unsigned int i = 0; i < numActorsToSpawn; ++i)
+	if (numActorsToSpawn == 0)
 	{
-		// Convert the degree angle into radians, as cos / sin expect radians.
-		float finalAngle = spawnAngle * PI / 180.0f;
-
-		// Posiiton the actors around the Base Station (X, Y, Z). 
-		Vector spawnLocation(cos(finalAngle) * spawnRadius, sin(finalAngle) * spawnRadius, 50.0f);
+		return;
+	}
 
-		// Face the actors away from the base.
-		Vector lookAtLocation = (baseLocation - spawnLocation) * -2.0f; // -2.0f to look away from the base.
-		lookAtLocation.Z = 0.0f;										 // Prevents Pitch.
-		lookAtLocation.Normalize();
+	TRACE_SCOPE("SpawnActorsInCircularPattern");
 
-		// Spawn Entity.
-		T* spawnedEntity = reinterpret_cast<T*>(SpawnEntity<T>(spawnLocation));
-		if (!spawnedEntity)
+	// Posiiton the actors around the Base Station (X, Y, Z). Each position is the previous one rotated by the angle between actors,
+	// rather than a cos / sin per actor.
+	std::vector<Vector4> spawnLocations(numActorsToSpawn);
+	double angleStep = 2.0 * PI / numActorsToSpawn;
+	double stepCos = cos(angleStep);
+	double stepSin = sin(angleStep);
+	double rotationCos = 1.0;
+	double rotationSin = 0.0;
+	for (unsigned int i = 0; i < numActorsToSpawn; ++i)
+	{
+		if (i % SpawnRotationResyncInterval == 0)
 		{
-			// Entity failed to spawn.
-			continue;
+			rotationCos = cos(angleStep * i);
+			rotationSin = sin(angleStep * i);
 		}
 
-		onEntitySpawned(spawnedEntity);
+		spawnLocations[i] = Vector4(static_cast<float>(rotationCos * spawnRadius), static_cast<float>(rotationSin * spawnRadius), 50.0f);
 
-		// Offset the spawn location in degrees.
-		spawnAngle += degreeOffset;
+		double nextCos = rotationCos * stepCos - rotationSin * stepSin;
+		rotationSin = rotationSin * stepCos + rotationCos * stepSin;
+		rotationCos = nextCos;
+	}
+
+	EntityPool<T>& registry = GetRegistry<T>();
+	std::vector<EntityHandle<T>> spawnedHandles(numActorsToSpawn);
+	registry.SpawnMany(numActorsToSpawn, spawnedHandles.data(), [&spawnLocations](T& entity, size_t i) {
+		entity.SetLocation(spawnLocations[i].ToVector());
+	});
+
+	for (EntityHandle<T> spawnedHandle : spawnedHandles)
+	{
+		SimulationPolicies::Instrumentation::OnEntitySpawned();
+		onEntitySpawned(registry.Resolve(spawnedHandle));
 	}
 }
 
@@ -460,14 +779,9 @@ void MiningTruckController::SpawnActorsInCircularPattern(unsigned int numActorsT
 */
 void MiningTruckController::BeginMiningOperation()
 {
-	for (const auto iterator : MiningTruckRegistry)
+	TRACE_SCOPE("BeginMiningOperation");
+	for (MiningTruck* miningTruck : MiningTruckRegistry)
 	{
-		MiningTruck* miningTruck = reinterpret_cast<MiningTruck*>(iterator.second);
-		if (!miningTruck)
-		{
-			continue;
-		}
-
 		// Found and Idle truck.
 		if (miningTruck->GetState() == EMiningTruckState::Idle)
 		{
@@ -481,47 +795,334 @@ void MiningTruckController::BeginMiningOperation()
 }
 
 /*
-* Finds and empty mining location for a single mining truck to mine at. Empty in this case means Idle.
+* Resumes every mining truck whose mining wait ended at or before now, in fleet order. Entries left behind by trucks that have since
+* left the simulation are dropped.
+*/
+void MiningTruckController::ResumeDueMiningTrucks(SimulationTime now)
+{
+	TRACE_SCOPE("ResumeDueMiningTrucks");
+	DueMiningTrucks.clear();
+	Scheduler.PopDue(now, DueMiningTrucks);
+	for (MiningTruckHandle miningTruckHandle : DueMiningTrucks)
+	{
+		MiningTruck* miningTruck = MiningTruckRegistry.Resolve(miningTruckHandle);
+		if (miningTruck && miningTruck->GetState() == EMiningTruckState::Mining && miningTruck->GetMiningCompletesAt() <= now)
+		{
+			miningTruck->FinishMining();
+		}
+	}
+}
+
+/*
+* Ticks the truck unloading at each station, in fleet order so unloading completions are buffered in the same order as a tick over every truck.
+*/
+void MiningTruckController::TickUnloadingMiningTrucks(SimulationTime deltaTime)
+{
+	TRACE_SCOPE("TickUnloadingMiningTrucks");
+	UnloadingMiningTrucks.clear();
+	for (UnloadingLocation* unloadingLocationPtr : UnloadingLocationRegistry)
+	{
+		MiningTruckHandle miningTruckHandle = unloadingLocationPtr->GetUnloadingMiningTruck();
+		if (miningTruckHandle.IsValid())
+		{
+			UnloadingMiningTrucks.push_back(miningTruckHandle);
+		}
+	}
+
+	std::sort(UnloadingMiningTrucks.begin(), UnloadingMiningTrucks.end(), [](const MiningTruckHandle& lhs, const MiningTruckHandle& rhs) {
+		return lhs.Index < rhs.Index;
+	});
+
+	for (MiningTruckHandle miningTruckHandle : UnloadingMiningTrucks)
+	{
+		MiningTruck* miningTruck = MiningTruckRegistry.Resolve(miningTruckHandle);
+		if (miningTruck)
+		{
+			miningTruck->Tick(deltaTime);
+		}
+	}
+}
+
+/*
+* Dispatches the completion events buffered during the truck update loop.
+* Unloading completions are handled first, so stations freed this tick are visible to the trucks choosing a queue.
+* Mining completions are then assigned to Unloading Locations by the dispatcher, which sees each assignment as it is made.
+*/
+void MiningTruckController::DispatchCompletionEvents()
+{
+	TRACE_SCOPE("DispatchCompletionEvents");
+	{
+		TRACE_SCOPE("OnUnloadingCompleted");
+		for (MiningTruckHandle miningTruckHandle : TickCompletionEvents.UnloadingCompleted)
+		{
+			OnUnloadingCompleted(miningTruckHandle);
+		}
+	}
+
+	// Trucks that finished mining are sent to an unloading station here.
+	{
+		TRACE_SCOPE("OnMiningCompleted");
+		for (MiningTruckHandle miningTruckHandle : TickCompletionEvents.MiningCompleted)
+		{
+			OnMiningCompleted(miningTruckHandle);
+		}
+	}
+
+	TickCompletionEvents.Clear();
+}
+
+/*
+* The simulation can only become periodic if every random duration is actually constant (min and max times are equal).
+*/
+bool MiningTruckController::CanExtrapolateSteadyState() const
+{
+	const MiningAndUnloadingTimes& times = SimConfig.MiningAndUnloadingTimes;
+	return SimConfig.EnableSteadyStateExtrapolation &&
+		   !SteadyStateExtrapolated &&
+		   NumSteadyStateSignatureWords < MaxSteadyStateSignatureWords &&
+		   times.MinMiningTimeHours == times.MaxMiningTimeHours &&
+		   times.MinUnloadingTimeMinutes == times.MaxUnloadingTimeMinutes;
+}
+
+/*
+* Builds the signature of the global simulation state: every truck's state and timers, every station's state and queue, and the dispatcher's projections.
+* Registries iterate in slot order, and spawning or destroying an entity resets detection, so the order is the same for every signature.
+*/
+void MiningTruckController::BuildStateSignature(StateSignature& signature) const
+{
+	signature.clear();
+	for (MiningTruck* miningTruckPtr : MiningTruckRegistry)
+	{
+		miningTruckPtr->AppendStateSignature(signature, SimulationTimer.GetElapsedSimulationTime());
+	}
+
+	for (UnloadingLocation* unloadingLocationPtr : UnloadingLocationRegistry)
+	{
+		unloadingLocationPtr->AppendStateSignature(signature);
+	}
+
+	Dispatcher.AppendStateSignature(signature, SimulationTimer.GetElapsedSimulationTime());
+}
+
+/*
+* Called at candidate period boundaries. Hashes the current state signature and looks for an earlier boundary with the same hash.
+* A hash match is only a candidate: the full state is snapshotted, and the period is confirmed once the boundary one period later has exactly
+* the same signature. Only then does the simulation repeat itself from here on. Confirming costs one more period of simulation, but only one
+* full snapshot is ever kept, instead of one per boundary.
+*/
+void MiningTruckController::DetectSteadyStateCycle(SimulationTime deltaTime)
+{
+	TRACE_SCOPE("DetectSteadyStateCycle");
+	// Changing the tick rate (playback speed) changes how the simulation evolves, so earlier samples can't be compared against.
+	if (deltaTime != SteadyStateDeltaTime)
+	{
+		ResetSteadyStateDetection();
+		SteadyStateDeltaTime = deltaTime;
+	}
+
+	BuildStateSignature(SteadyStateSignature);
+	NumSteadyStateSignatureWords += SteadyStateSignature.size();
+	SimulationTime elapsedTime = SimulationTimer.GetElapsedSimulationTime();
+
+	if (HasSteadyStateCandidate)
+	{
+		SimulationTime confirmationTime = SteadyStateCandidate.ElapsedTime + SteadyStateCandidatePeriod;
+		if (elapsedTime == confirmationTime && SteadyStateSignature == SteadyStateCandidate.Signature)
+		{
+			ExtrapolateSteadyStatePeriods(SteadyStateCandidate, SteadyStateCandidatePeriod, deltaTime);
+			return;
+		}
+
+		if (elapsedTime >= confirmationTime)
+		{
+			// A hash collision, or the state only repeated once.
+			HasSteadyStateCandidate = false;
+		}
+	}
+
+	// FNV-1a over the signature words.
+	uint64_t hash = 14695981039346656037ull;
+	for (uint64_t word : SteadyStateSignature)
+	{
+		hash ^= word;
+		hash *= 1099511628211ull;
+	}
+
+	auto sampleIter = SteadyStateSamples.find(hash);
+	if (!HasSteadyStateCandidate && sampleIter != SteadyStateSamples.end())
+	{
+		HasSteadyStateCandidate = true;
+		SteadyStateCandidatePeriod = elapsedTime - sampleIter->second;
+		SteadyStateCandidate.ElapsedTime = elapsedTime;
+		SteadyStateCandidate.Signature = SteadyStateSignature;
+		SteadyStateCandidate.TruckHeliumUnloaded.clear();
+		SteadyStateCandidate.UnloadingLocationTimeUnloading.clear();
+
+		for (MiningTruck* miningTruckPtr : MiningTruckRegistry)
+		{
+			SteadyStateCandidate.TruckHeliumUnloaded.push_back(miningTruckPtr->GetTotalHeliumUnloaded());
+		}
+
+		for (UnloadingLocation* unloadingLocationPtr : UnloadingLocationRegistry)
+		{
+			SteadyStateCandidate.UnloadingLocationTimeUnloading.push_back(unloadingLocationPtr->GetTotalUnloadingTime());
+		}
+	}
+
+	if (SteadyStateSamples.size() >= MaxSteadyStateSamples && sampleIter == SteadyStateSamples.end())
+	{
+		// No period found within the sample budget, start over rather than growing without bound.
+		SteadyStateSamples.clear();
+	}
+
+	SteadyStateSamples[hash] = elapsedTime;
+}
+
+/*
+* Skips as many whole periods as fit in the remaining simulation time.
+* Each skipped period adds exactly what every truck and station unloaded during the detected period.
+* At least one tick is always left to simulate, so the simulation still finishes through the normal Tick path.
 */
-void MiningTruckController::FindLocationToMine(BaseEntity* miningTruckPtr)
+void MiningTruckController::ExtrapolateSteadyStatePeriods(const SteadyStateSample& periodStart, SimulationTime periodTime, SimulationTime deltaTime)
 {
-	if (!miningTruckPtr)
+	TRACE_SCOPE("ExtrapolateSteadyStatePeriods");
+	SteadyStateExtrapolated = true;
+
+	SimulationTime remainingTime = SimulationTimer.GetRemainingGlobalTime();
+	if (periodTime <= 0 || remainingTime <= deltaTime)
+	{
+		ResetSteadyStateDetection();
+		return;
+	}
+
+	SimulationTime numPeriods = (remainingTime - deltaTime) / periodTime;
+	if (numPeriods < 1)
 	{
+		ResetSteadyStateDetection();
 		return;
 	}
 
-	MiningTruck* miningTruck = reinterpret_cast<MiningTruck*>(miningTruckPtr);
+	unsigned int index = 0;
+	for (MiningTruck* miningTruckPtr : MiningTruckRegistry)
+	{
+		SimulationTime heliumPerPeriod = miningTruckPtr->GetTotalHeliumUnloaded() - periodStart.TruckHeliumUnloaded[index];
+		miningTruckPtr->AddExtrapolatedHelium(heliumPerPeriod * numPeriods);
+		++index;
+	}
+
+	index = 0;
+	for (UnloadingLocation* unloadingLocationPtr : UnloadingLocationRegistry)
+	{
+		SimulationTime unloadingPerPeriod = unloadingLocationPtr->GetTotalUnloadingTime() - periodStart.UnloadingLocationTimeUnloading[index];
+		unloadingLocationPtr->AddExtrapolatedUnloadingTime(unloadingPerPeriod * numPeriods);
+		++index;
+	}
+
+	for (MiningTruck* miningTruckPtr : MiningTruckRegistry)
+	{
+		miningTruckPtr->AdvanceMiningWait(periodTime * numPeriods);
+	}
+
+	SimulationTimer.AdvanceTime(periodTime * numPeriods);
+	Scheduler.AdvanceTime(periodTime * numPeriods);
+	Dispatcher.AdvanceTime(periodTime * numPeriods);
+	ResetSteadyStateDetection();
+}
+
+/*
+* Discards all period boundary samples.
+*/
+void MiningTruckController::ResetSteadyStateDetection()
+{
+	SteadyStateSamples.clear();
+	SteadyStateSignature.clear();
+	SteadyStateDeltaTime = 0;
+	HasSteadyStateCandidate = false;
+}
+
+/*
+* Batch means stopping rule. Called once per Tick; closes a batch whenever ConvergenceBatchSeconds of simulation time have passed since the last one.
+* Once steady state extrapolation has run, the result is exact, so there's nothing left to estimate.
+*/
+bool MiningTruckController::UpdateConvergence()
+{
+	if (SimConfig.ConvergenceTolerance <= 0.0f || SteadyStateExtrapolated)
+	{
+		return false;
+	}
+
+	TRACE_SCOPE("UpdateConvergence");
+
+	SimulationTime elapsedTime = SimulationTimer.GetElapsedSimulationTime();
+	SimulationTime batchTime = elapsedTime - ConvergenceBatchStart;
+	if (batchTime < SecondsToSimulationTime(SimConfig.ConvergenceBatchSeconds) || batchTime <= 0)
+	{
+		return false;
+	}
+
+	SimulationTime totalUnloadingTime = GetTotalUnloadingTime();
+	if (ConvergenceWarmUpComplete)
+	{
+		EfficiencyBatchMeans.AddBatch(static_cast<double>(totalUnloadingTime - ConvergenceBatchUnloadingTime) / static_cast<double>(batchTime));
+	}
+	else
+	{
+		// The first batch starts with every truck heading out to mine at once, it isn't representative of the rest of the run.
+		ConvergenceWarmUpComplete = true;
+	}
+
+	ConvergenceBatchStart = elapsedTime;
+	ConvergenceBatchUnloadingTime = totalUnloadingTime;
+
+	unsigned int minBatches = SimConfig.ConvergenceMinBatches > 2 ? SimConfig.ConvergenceMinBatches : 2;
+	Converged = EfficiencyBatchMeans.GetNumBatches() >= minBatches &&
+				EfficiencyBatchMeans.GetConfidenceHalfWidth() <= SimConfig.ConvergenceTolerance;
+	return Converged;
+}
+
+void MiningTruckController::ResetConvergence()
+{
+	EfficiencyBatchMeans.Reset();
+	ConvergenceBatchStart = 0;
+	ConvergenceBatchUnloadingTime = 0;
+	ConvergenceWarmUpComplete = false;
+	Converged = false;
+}
+
+/*
+* Finds and empty mining location for a single mining truck to mine at. Empty in this case means Idle.
+*/
+void MiningTruckController::FindLocationToMine(MiningTruck* miningTruck)
+{
 	if (!miningTruck)
 	{
 		return;
 	}
 
 	// The only requirement to be a valid mining location is for the mining location to be in the Idle state for the sake of this simulation.
-	for (const auto miningLocationIterator : MiningLocationRegistry)
+	// Idle locations are taken lowest slot first, the same one a scan of the registry would find.
+	while (!IdleMiningLocations.empty())
 	{
-		MiningLocation* miningLocation = reinterpret_cast<MiningLocation*>(miningLocationIterator.second);
-		if (!miningLocation)
-		{
-			continue;
-		}
+		MiningLocation* miningLocation = MiningLocationRegistry.Resolve(IdleMiningLocations.top());
+		IdleMiningLocations.pop();
 
-		// Ensure the mining location is idle.
-		if (miningLocation->GetState() != EMiningLocationState::Idle)
+		// Ensure the mining location is idle. Entries of locations that were destroyed, or taken since they were added, are dropped.
+		if (!miningLocation || miningLocation->GetState() != EMiningLocationState::Idle)
 		{
 			continue;
 		}
 
 		// Bind callback that will be used to respond to when the truck arrives at the mining location.
-		miningTruck->OnMoveToMiningLocationComplete.Bind([this](unsigned int truckUniqueId) {
-			OnMoveToMiningLocationComplete(truckUniqueId);
+		miningTruck->OnMoveToMiningLocationComplete.Bind([this](MiningTruckHandle miningTruckHandle) {
+			OnMoveToMiningLocationComplete(miningTruckHandle);
 		});
 
 		// Track the truck as moving to a mining location.
-		MoveToMiningLocationPending.emplace(miningTruck->GetUniqueId(), miningLocationIterator.first);
+		GetAssignment(miningTruck).MoveToMiningLocationPending = miningLocation->GetHandle();
 
 		// We've found a match for a truck and a Mining Location, move the truck to the mining location.
-		miningTruck->SetState(EMiningTruckState::MovingToMiningLocation);
-		miningLocation->SetState(EMiningLocationState::MiningTruckEnRoute);
+		SetMiningTruckState(miningTruck, EMiningTruckState::MovingToMiningLocation);
+		SetMiningLocationState(miningLocation, EMiningLocationState::MiningTruckEnRoute);
 
 		// Attempt to start moving the truck to the mining location.
 		if (!miningTruck->MoveToLocation(miningLocation, EMiningTruckMovementTarget::MiningLocation))
@@ -534,32 +1135,90 @@ void MiningTruckController::FindLocationToMine(BaseEntity* miningTruckPtr)
 }
 
 /*
-* After a truck is told to move to a mining location, this callback moves the truck into the Mining state and MiningTruckController will now wait for the truck to complete mining.
+* Sets a mining location back to Idle and makes it available to FindLocationToMine again.
 */
-void MiningTruckController::OnMoveToMiningLocationComplete(unsigned int truckUniqueId)
+void MiningTruckController::ReleaseMiningLocation(MiningLocation* miningLocation)
 {
-	// Truck and Mining Location Validation.
-	const auto truckToMiningIter = MoveToMiningLocationPending.find(truckUniqueId);
-	if (truckToMiningIter == MoveToMiningLocationPending.end())
+	SetMiningLocationState(miningLocation, EMiningLocationState::Idle);
+	IdleMiningLocations.push(miningLocation->GetHandle());
+}
+
+/*
+* Changes a truck's state and reports the change. The delegate is called straight away; the event bus only if something is subscribed.
+*/
+void MiningTruckController::SetMiningTruckState(MiningTruck* miningTruck, EMiningTruckState newState)
+{
+	EMiningTruckState previousState = miningTruck->GetState();
+	miningTruck->SetState(newState);
+	if (previousState == newState)
 	{
 		return;
 	}
 
-	const auto miningLocationIter = MiningLocationRegistry.find(truckToMiningIter->second);
-	if (miningLocationIter == MiningLocationRegistry.end())
+	--NumMiningTrucksInState[static_cast<size_t>(previousState)];
+	++NumMiningTrucksInState[static_cast<size_t>(newState)];
+	if (Metrics)
+	{
+		Metrics->OnMiningTruckStateChanged(previousState, newState);
+	}
+
+	OnMiningTruckStateChanged.ExecuteIfBound(miningTruck->GetHandle(), newState);
+	PublishStateChange(ESimulationEventType::MiningTruckStateChanged, miningTruck->GetHandle(), static_cast<size_t>(previousState), static_cast<size_t>(newState));
+}
+
+void MiningTruckController::SetMiningLocationState(MiningLocation* miningLocation, EMiningLocationState newState)
+{
+	EMiningLocationState previousState = miningLocation->GetState();
+	miningLocation->SetState(newState);
+	if (previousState != newState)
+	{
+		PublishStateChange(ESimulationEventType::MiningLocationStateChanged, miningLocation->GetHandle(), static_cast<size_t>(previousState), static_cast<size_t>(newState));
+	}
+}
+
+void MiningTruckController::SetUnloadingLocationState(UnloadingLocation* unloadingLocation, EUnloadingLocationState newState)
+{
+	EUnloadingLocationState previousState = unloadingLocation->GetState();
+	unloadingLocation->SetState(newState);
+	if (previousState != newState)
+	{
+		PublishStateChange(ESimulationEventType::UnloadingLocationStateChanged, unloadingLocation->GetHandle(), static_cast<size_t>(previousState), static_cast<size_t>(newState));
+	}
+}
+
+template<typename T>
+void MiningTruckController::PublishStateChange(ESimulationEventType type, EntityHandle<T> handle, size_t previousState, size_t newState)
+{
+	if (!EventBus.HasSubscribers())
 	{
 		return;
 	}
 
-	const auto miningTruckIter = MiningTruckRegistry.find(truckUniqueId);
-	if (miningTruckIter == MiningTruckRegistry.end())
+	SimulationEvent event;
+	event.Time = SimulationTimer.GetElapsedSimulationTime();
+	event.Type = type;
+	event.PreviousState = static_cast<uint8_t>(previousState);
+	event.NewState = static_cast<uint8_t>(newState);
+	event.EntityIndex = handle.Index;
+	event.EntityGeneration = handle.Generation;
+	EventBus.Publish(event);
+}
+
+/*
+* After a truck is told to move to a mining location, this callback moves the truck into the Mining state and MiningTruckController will now wait for the truck to complete mining.
+*/
+void MiningTruckController::OnMoveToMiningLocationComplete(MiningTruckHandle miningTruckHandle)
+{
+	// Truck and Mining Location Validation.
+	MiningTruck* miningTruck = MiningTruckRegistry.Resolve(miningTruckHandle);
+	if (!miningTruck)
 	{
 		return;
 	}
 
-	MiningLocation* miningLocation = reinterpret_cast<MiningLocation*>(miningLocationIter->second);
-	MiningTruck* miningTruck = reinterpret_cast<MiningTruck*>(miningTruckIter->second);
-	if (!miningLocation || !miningTruck)
+	MiningTruckAssignment& assignment = GetAssignment(miningTruck);
+	MiningLocation* miningLocation = MiningLocationRegistry.Resolve(assignment.MoveToMiningLocationPending);
+	if (!miningLocation)
 	{
 		return;
 	}
@@ -568,81 +1227,55 @@ void MiningTruckController::OnMoveToMiningLocationComplete(unsigned int truckUni
 	miningTruck->OnMoveToMiningLocationComplete.Unbind();
 
 	// Move Truck from the Move-To mining state, to the actively mining state.
-	MoveToMiningLocationPending.erase(truckUniqueId);
-	ActiveMiningTrucks.emplace(truckUniqueId, miningLocation->GetUniqueId());
+	assignment.MoveToMiningLocationPending = MiningLocationHandle();
+	assignment.ActiveMiningLocation = miningLocation->GetHandle();
 
-	// Bind to the delegate that responds to mining being completed.
-	miningTruck->OnMiningCompleted.Bind([this](unsigned int truckUniqueId) {
-		OnMiningCompleted(truckUniqueId);
+	// Bind to the delegate that responds to mining being completed. The completion is handled after all trucks have ticked.
+	miningTruck->OnMiningCompleted.Bind([this](MiningTruckHandle miningTruckHandle) {
+		TickCompletionEvents.MiningCompleted.push_back(miningTruckHandle);
 	});
 
 	// Set the Truck and the Mining Location to the "being mined" state.
-	miningTruck->SetState(EMiningTruckState::Mining);
-	miningLocation->SetState(EMiningLocationState::ActivelyBeingMined);
+	SetMiningTruckState(miningTruck, EMiningTruckState::Mining);
+	SetMiningLocationState(miningLocation, EMiningLocationState::ActivelyBeingMined);
+
+	// Suspend the truck until its mining time is up. A truck with no mining time never finishes, as it never did when mining was counted down.
+	SimulationTime now = SimulationTimer.GetElapsedSimulationTime();
+	miningTruck->StartMiningWait(now);
+	if (miningTruck->GetRemainingMiningTime(now) > 0)
+	{
+		Scheduler.Suspend(miningTruckHandle, miningTruck->GetMiningCompletesAt());
+	}
 }
 
 /*
 * Once Mining has completed this function will find a suitable unloading station to queue at.
-* The rule is to find the station with the shortest queue, and send the truck there.
+* The station is picked by the dispatcher, using the configured strategy (by default the station with the shortest queue).
 * If there is no queue at all, naturally that station will be the best selection for efficiency.
 * AddMiningTruckToQueue() is called to add the truck to the mining queue of the Unloading Station.
 */
-void MiningTruckController::OnMiningCompleted(unsigned int truckUniqueId)
+void MiningTruckController::OnMiningCompleted(MiningTruckHandle miningTruckHandle)
 {
 	// Truck and Mining Location Validation.
-	const auto truckToMiningIter = ActiveMiningTrucks.find(truckUniqueId);
-	if (truckToMiningIter == ActiveMiningTrucks.end())
-	{
-		return;
-	}
-
-	const auto miningLocationIter = MiningLocationRegistry.find(truckToMiningIter->second);
-	if (miningLocationIter == MiningLocationRegistry.end())
-	{
-		return;
-	}
-
-	const auto miningTruckIter = MiningTruckRegistry.find(truckUniqueId);
-	if (miningTruckIter == MiningTruckRegistry.end())
+	MiningTruck* miningTruck = MiningTruckRegistry.Resolve(miningTruckHandle);
+	if (!miningTruck)
 	{
 		return;
 	}
 
-	MiningLocation* miningLocation = reinterpret_cast<MiningLocation*>(miningLocationIter->second);
-	MiningTruck* miningTruck = reinterpret_cast<MiningTruck*>(miningTruckIter->second);
-	if (!miningLocation || !miningTruck)
+	MiningTruckAssignment& assignment = GetAssignment(miningTruck);
+	MiningLocation* miningLocation = MiningLocationRegistry.Resolve(assignment.ActiveMiningLocation);
+	if (!miningLocation)
 	{
 		return;
 	}
 
-	// Find a suitable Unloading Location that has the shortest queue for efficiency.
-	// Linear search O(n) should be sufficient, as it not expected that there will be a million or more unloading locations.
-	// If there were going to be a million or more unloading locations, then I would keep a sorted list of Unloading Locations that will be sorted by queue time from lowest to highest.
-	// My sort function would have been Quick Sort at O(n^2) worst case and O( n log n ) average case.
-	// My search function would have simply taken the Unloading location from the front of the list (Location with the shortest queue).
-	float shortestQueueTime = 99999.0f;
-	UnloadingLocation* selectedUnloadingLocation = nullptr;
-	for (const auto unloadingLocationInfo : UnloadingLocationRegistry)
-	{
-		BaseEntity* unloadingLocationPtr = unloadingLocationInfo.second;
-		if (!unloadingLocationPtr)
-		{
-			continue;
-		}
-		
-		UnloadingLocation* unloadingLocation = reinterpret_cast<UnloadingLocation*>(unloadingLocationPtr);
-		if (!unloadingLocation)
-		{
-			continue;
-		}
+	// Pre-calculate an unloading time.
+	// This way, the Unloading location, can sum all the queue times up from each Mining Truck in the queue to calculate a total queue time,
+	// and the dispatcher can book the truck's unloading time onto the station it picks.
+	miningTruck->CalculateUnloadTimer();
 
-		float queueTime = unloadingLocation->GetQueueTime();
-		if (queueTime < shortestQueueTime)
-		{
-			shortestQueueTime = queueTime;
-			selectedUnloadingLocation = unloadingLocation;
-		}
-	}
+	UnloadingLocation* selectedUnloadingLocation = Dispatcher.Dispatch(miningLocation, SimulationTimer.GetElapsedSimulationTime(), miningTruck->GetRemainingUnloadingTime());
 
 	// If we return here, we may have not spawned any Unloading Locations.
 	if (!selectedUnloadingLocation)
@@ -651,28 +1284,23 @@ void MiningTruckController::OnMiningCompleted(unsigned int truckUniqueId)
 	}
 
 	// Bind to the delegate that responds to mining truck move to Unload Queue being completed.
-	miningTruck->OnMoveToUnloadingQueueComplete.Bind([this](unsigned int truckUniqueId) {
-		OnMoveToUnloadingQueueComplete(truckUniqueId);
+	miningTruck->OnMoveToUnloadingQueueComplete.Bind([this](MiningTruckHandle miningTruckHandle) {
+		OnMoveToUnloadingQueueComplete(miningTruckHandle);
 	});
 
 	// Unbind from the Move to Mining Location Delegate.
 	miningTruck->OnMiningCompleted.Unbind();
 
 	// Move Truck from the mining state, to the move-to unloading state.
-	ActiveMiningTrucks.erase(truckUniqueId);
-	MovingToUnloadingLocationPending.emplace(truckUniqueId, selectedUnloadingLocation->GetUniqueId());
-	MiningTrucksPendingUnload.emplace(truckUniqueId, selectedUnloadingLocation->GetUniqueId());
-
-	// Pre-calculate an unloading time. if the move attempt was successful.
-	// This way, the Unloading location, can sum all the queue times up from each Mining Truck in the queue to calculate a total queue time.
-	// This time is calculated as the truck begins to move toward the unloading queue location.
-	miningTruck->CalculateUnloadTimer();
+	assignment.ActiveMiningLocation = MiningLocationHandle();
+	assignment.MovingToUnloadingLocationPending = selectedUnloadingLocation->GetHandle();
+	assignment.PendingUnload = selectedUnloadingLocation->GetHandle();
 
 	selectedUnloadingLocation->AddMiningTruckToQueue(miningTruck);
 
 	// Set the Truck and the Mining Location states to moving to unloading, and depleted states respectively.
-	miningTruck->SetState(EMiningTruckState::MovingToUnloadingLocation);
-	miningLocation->SetState(EMiningLocationState::Idle);
+	SetMiningTruckState(miningTruck, EMiningTruckState::MovingToUnloadingLocation);
+	ReleaseMiningLocation(miningLocation);
 
 	// Attempt to start moving the truck to the unloading location. 8,000 units is the min radius where the movement can stop as they will join the queue at that point.
 	if (!miningTruck->MoveToLocation(selectedUnloadingLocation, EMiningTruckMovementTarget::UnloadingQueue))
@@ -683,82 +1311,58 @@ void MiningTruckController::OnMiningCompleted(unsigned int truckUniqueId)
 
 /*
 * Once a truck arrives in the loading queue it's state is transitioned to "InUnloadingQueue".
-* The Mining Truck's Id will be used to Request that it begin unloading when the Unloading Station is ready.
+* The Mining Truck's handle will be used to Request that it begin unloading when the Unloading Station is ready.
 */
-void MiningTruckController::OnMoveToUnloadingQueueComplete(unsigned int truckUniqueId)
+void MiningTruckController::OnMoveToUnloadingQueueComplete(MiningTruckHandle miningTruckHandle)
 {
 	// Truck and Mining Location Validation.
-	auto truckToUnloadingIter = MovingToUnloadingLocationPending.find(truckUniqueId);
-	if (truckToUnloadingIter == MovingToUnloadingLocationPending.end())
-	{
-		return;
-	}
-
-	auto unloadingLocationIter = UnloadingLocationRegistry.find(truckToUnloadingIter->second);
-	if (unloadingLocationIter == UnloadingLocationRegistry.end())
-	{
-		return;
-	}
-
-	auto miningTruckIter = MiningTruckRegistry.find(truckUniqueId);
-	if (miningTruckIter == MiningTruckRegistry.end())
+	MiningTruck* miningTruck = MiningTruckRegistry.Resolve(miningTruckHandle);
+	if (!miningTruck)
 	{
 		return;
 	}
 
-	UnloadingLocation* unloadingLocation = reinterpret_cast<UnloadingLocation*>(unloadingLocationIter->second);
-	MiningTruck* miningTruck = reinterpret_cast<MiningTruck*>(miningTruckIter->second);
-	if (!unloadingLocation || !miningTruck)
+	MiningTruckAssignment& assignment = GetAssignment(miningTruck);
+	UnloadingLocation* unloadingLocation = UnloadingLocationRegistry.Resolve(assignment.MovingToUnloadingLocationPending);
+	if (!unloadingLocation)
 	{
 		return;
 	}
 
-	MovingToUnloadingLocationPending.erase(truckUniqueId);
+	assignment.MovingToUnloadingLocationPending = UnloadingLocationHandle();
 
 	miningTruck->OnMoveToUnloadingQueueComplete.Unbind();
-	miningTruck->SetState(EMiningTruckState::InUnloadingQueue);
+	SetMiningTruckState(miningTruck, EMiningTruckState::InUnloadingQueue);
 }
 
 /*
 * Callback function used by the Unloading Station to request that a truck begin unloading at a station.
 * This function is called by a Delegate from an Unloading Station during it's ProcessQueue() function.
 */
-void MiningTruckController::OnRequestUnloadMiningTruck(unsigned int truckUniqueId)
+void MiningTruckController::OnRequestUnloadMiningTruck(MiningTruckHandle miningTruckHandle)
 {
-	auto truckToUnloadingIter = MiningTrucksPendingUnload.find(truckUniqueId);
-	if (truckToUnloadingIter == MiningTrucksPendingUnload.end())
-	{
-		return;
-	}
-
-	auto unloadingLocationIter = UnloadingLocationRegistry.find(truckToUnloadingIter->second);
-	if (unloadingLocationIter == UnloadingLocationRegistry.end())
-	{
-		return;
-	}
-
-	auto miningTruckIter = MiningTruckRegistry.find(truckUniqueId);
-	if (miningTruckIter == MiningTruckRegistry.end())
+	MiningTruck* miningTruck = MiningTruckRegistry.Resolve(miningTruckHandle);
+	if (!miningTruck)
 	{
 		return;
 	}
 
-	UnloadingLocation* unloadingLocation = reinterpret_cast<UnloadingLocation*>(unloadingLocationIter->second);
-	MiningTruck* miningTruck = reinterpret_cast<MiningTruck*>(miningTruckIter->second);
-	if (!unloadingLocation || !miningTruck)
+	MiningTruckAssignment& assignment = GetAssignment(miningTruck);
+	UnloadingLocation* unloadingLocation = UnloadingLocationRegistry.Resolve(assignment.PendingUnload);
+	if (!unloadingLocation)
 	{
 		return;
 	}
 
 	// Bind callback function that gets invoked when a mining truck has finished moving into the unloading station from the queue.
-	miningTruck->OnMoveToUnloadingLocationComplete.Bind([this](unsigned int truckUniqueId) {
-		OnMoveToUnloadingLocationComplete(truckUniqueId);
+	miningTruck->OnMoveToUnloadingLocationComplete.Bind([this](MiningTruckHandle miningTruckHandle) {
+		OnMoveToUnloadingLocationComplete(miningTruckHandle);
 	});
 
-	MiningTrucksPendingUnload.erase(truckUniqueId);
-	MiningTrucksTransitioningToUnload.emplace(truckUniqueId, unloadingLocation->GetUniqueId());
+	assignment.PendingUnload = UnloadingLocationHandle();
+	assignment.TransitioningToUnload = unloadingLocation->GetHandle();
 
-	miningTruck->SetState(EMiningTruckState::TransitioningToUnload);
+	SetMiningTruckState(miningTruck, EMiningTruckState::TransitioningToUnload);
 
 	// Attempt to start moving the truck to the mining location.
 	if (!miningTruck->MoveToLocation(unloadingLocation, EMiningTruckMovementTarget::UnloadingLocation))
@@ -770,92 +1374,69 @@ void MiningTruckController::OnRequestUnloadMiningTruck(unsigned int truckUniqueI
 /*
 * After requesting a Mining Truck move "directly" into the Mining Station to begin unloading, this function will change the state of the mining truck to the "actual" unloading state.
 */
-void MiningTruckController::OnMoveToUnloadingLocationComplete(unsigned int truckUniqueId)
+void MiningTruckController::OnMoveToUnloadingLocationComplete(MiningTruckHandle miningTruckHandle)
 {
 	// Truck and Mining Location Validation.
-	auto truckToUnloadingIter = MiningTrucksTransitioningToUnload.find(truckUniqueId);
-	if (truckToUnloadingIter == MiningTrucksTransitioningToUnload.end())
-	{
-		return;
-	}
-
-	auto unloadingLocationIter = UnloadingLocationRegistry.find(truckToUnloadingIter->second);
-	if (unloadingLocationIter == UnloadingLocationRegistry.end())
-	{
-		return;
-	}
-
-	auto miningTruckIter = MiningTruckRegistry.find(truckUniqueId);
-	if (miningTruckIter == MiningTruckRegistry.end())
+	MiningTruck* miningTruck = MiningTruckRegistry.Resolve(miningTruckHandle);
+	if (!miningTruck)
 	{
 		return;
 	}
 
-	UnloadingLocation* unloadingLocation = reinterpret_cast<UnloadingLocation*>(unloadingLocationIter->second);
-	MiningTruck* miningTruck = reinterpret_cast<MiningTruck*>(miningTruckIter->second);
-	if (!unloadingLocation || !miningTruck)
+	MiningTruckAssignment& assignment = GetAssignment(miningTruck);
+	UnloadingLocation* unloadingLocation = UnloadingLocationRegistry.Resolve(assignment.TransitioningToUnload);
+	if (!unloadingLocation)
 	{
 		return;
 	}
 
 	miningTruck->OnMoveToUnloadingLocationComplete.Unbind();
 
-	MiningTrucksTransitioningToUnload.erase(truckUniqueId);
-	ActiveUnloadingTrucks.emplace(truckUniqueId, unloadingLocation->GetUniqueId());
+	assignment.TransitioningToUnload = UnloadingLocationHandle();
+	assignment.ActiveUnloadingLocation = unloadingLocation->GetHandle();
 
-	// Bind callback to notify when unloading for a truck is complete.
-	miningTruck->OnUnloadingCompleted.Bind([this](unsigned int truckUniqueId) {
-		OnUnloadingCompleted(truckUniqueId);
+	// Bind callback to notify when unloading for a truck is complete. The completion is handled after all trucks have ticked.
+	miningTruck->OnUnloadingCompleted.Bind([this](MiningTruckHandle miningTruckHandle) {
+		TickCompletionEvents.UnloadingCompleted.push_back(miningTruckHandle);
 	});
 
 	// Update the Unloading Location with the change in time (deltaTime) so that UnloadingLocation::GetQueueTime() stays in sync in real time.
-	miningTruck->OnUnloadHelium.Bind([unloadingLocation](unsigned int truckUniqueId, float deltaTime) {
+	miningTruck->OnUnloadHelium.Bind([unloadingLocation](MiningTruckHandle miningTruckHandle, SimulationTime deltaTime) {
 		if (unloadingLocation)
 		{
 			unloadingLocation->UnloadHelium(deltaTime);
 		}
 	});
 
-	miningTruck->SetState(EMiningTruckState::Unloading);
-	unloadingLocation->SetState(EUnloadingLocationState::Unloading);
+	SetMiningTruckState(miningTruck, EMiningTruckState::Unloading);
+	SetUnloadingLocationState(unloadingLocation, EUnloadingLocationState::Unloading);
 }
 
 /*
 * Callback function to respond to a truck finishing it's unloading of Helium-3.
 * After a truck is "emptied" it's then told to go mine a new Mining Location to maintain efficiency.
 */
-void MiningTruckController::OnUnloadingCompleted(unsigned int truckUniqueId)
+void MiningTruckController::OnUnloadingCompleted(MiningTruckHandle miningTruckHandle)
 {
-	auto truckToUnloadingLocationIter = ActiveUnloadingTrucks.find(truckUniqueId);
-	if (truckToUnloadingLocationIter == ActiveUnloadingTrucks.end())
-	{
-		return;
-	}
-
-	auto unloadingLocationIter = UnloadingLocationRegistry.find(truckToUnloadingLocationIter->second);
-	if (unloadingLocationIter == UnloadingLocationRegistry.end())
-	{
-		return;
-	}
-
-	auto miningTruckIter = MiningTruckRegistry.find(truckUniqueId);
-	if (miningTruckIter == MiningTruckRegistry.end())
+	MiningTruck* miningTruck = MiningTruckRegistry.Resolve(miningTruckHandle);
+	if (!miningTruck)
 	{
 		return;
 	}
 
-	UnloadingLocation* unloadingLocation = reinterpret_cast<UnloadingLocation*>(unloadingLocationIter->second);
-	MiningTruck* miningTruck = reinterpret_cast<MiningTruck*>(miningTruckIter->second);
-	if (!unloadingLocation || !miningTruck)
+	MiningTruckAssignment& assignment = GetAssignment(miningTruck);
+	UnloadingLocation* unloadingLocation = UnloadingLocationRegistry.Resolve(assignment.ActiveUnloadingLocation);
+	if (!unloadingLocation)
 	{
 		return;
 	}
 
-	ActiveUnloadingTrucks.erase(truckUniqueId);
+	assignment.ActiveUnloadingLocation = UnloadingLocationHandle();
 
-	unloadingLocation->SetState(EUnloadingLocationState::Idle);
-	unloadingLocation->MiningTruckUnloadingFinished(truckUniqueId);
-	miningTruck->SetState(EMiningTruckState::Idle);
+	SetUnloadingLocationState(unloadingLocation, EUnloadingLocationState::Idle);
+	unloadingLocation->MiningTruckUnloadingFinished(miningTruck);
+	Dispatcher.OnUnloadingFinished(unloadingLocation, SimulationTimer.GetElapsedSimulationTime());
+	SetMiningTruckState(miningTruck, EMiningTruckState::Idle);
 
 	// Remove the Mining Location's callback from the Mining Trucks OnUnloadHelium callback.
 	miningTruck->OnUnloadHelium.Unbind();
@@ -865,41 +1446,16 @@ void MiningTruckController::OnUnloadingCompleted(unsigned int truckUniqueId)
 }
 
 /*
-* Destroys all Spawned Entities.
+* Destroys all Spawned Entities. Every handle handed out so far becomes stale.
 */
 void MiningTruckController::DestroyAllEntities()
 {
-
-	// Destroy all Mining Trucks.
-	for (const auto& iterator : MiningTruckRegistry)
-	{
-		BaseEntity* miningTruckPtr = iterator.second;
-		if (miningTruckPtr)
-		{
-			DestroyEntity(miningTruckPtr);
-		}
-	}
-	MiningTruckRegistry.clear();
-
-	// Destroy all Mining Trucks.
-	for (const auto& iterator : MiningLocationRegistry)
-	{
-		BaseEntity* miningLocationPtr = iterator.second;
-		if (miningLocationPtr)
-		{
-			DestroyEntity(miningLocationPtr);
-		}
-	}
-	MiningLocationRegistry.clear();
-
-	// Destroy all Unloading Locations.
-	for (const auto& iterator : UnloadingLocationRegistry)
-	{
-		BaseEntity* unloadingLocationPtr = iterator.second;
-		if (unloadingLocationPtr)
-		{
-			DestroyEntity(unloadingLocationPtr);
-		}
-	}
-	UnloadingLocationRegistry.clear();
-}
\ No newline at end of file
+	TRACE_SCOPE("DestroyAllEntities");
+	MiningTruckRegistry.Clear();
+	MiningLocationRegistry.Clear();
+	UnloadingLocationRegistry.Clear();
+	MiningTruckAssignments.clear();
+	IdleMiningLocations = IdleMiningLocationQueue();
+	Scheduler.Reset();
+	NumMiningTrucksInState.fill(0);
+}
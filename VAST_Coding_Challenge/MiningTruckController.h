@@ -1,12 +1,88 @@
 #pragma once
 #include "BaseEntity.h"
+#include "BatchMeansEstimator.h"
 #include "Delegate.h"
+#include "EntityPool.h"
+#include "MiningLocation.h"
+#include "MiningTruck.h"
+#include "MiningTruckScheduler.h"
 #include "MiningTruckSimulationTimer.h"
+#include "SimulationEventBus.h"
+#include "SimulationMetrics.h"
+#include "SimulationTimeSeries.h"
+#include "SimulationPolicies.h"
+#include "UnloadingDispatcher.h"
+#include "UnloadingLocation.h"
 
+#include <array>
 #include <functional>
+#include <queue>
 #include <vector>
 #include <unordered_map>
 
+// Completion events raised by Mining Trucks while they Tick.
+// Events are buffered per type during the truck update loop, then dispatched in one batch once every truck has ticked.
+struct MiningTruckCompletionEvents
+{
+    TrackedVector<MiningTruckHandle, EMemorySubsystem::CompletionEvents> MiningCompleted;
+    TrackedVector<MiningTruckHandle, EMemorySubsystem::CompletionEvents> UnloadingCompleted;
+
+    void Reserve(unsigned int numMiningTrucks)
+    {
+        MiningCompleted.reserve(numMiningTrucks);
+        UnloadingCompleted.reserve(numMiningTrucks);
+    }
+
+    void Clear()
+    {
+        MiningCompleted.clear();
+        UnloadingCompleted.clear();
+    }
+};
+
+// Where a truck is in its mine / unload cycle, and the location it is using for that step. Unset handles mean the truck isn't in that step.
+// Kept per truck, indexed by the truck's fleet index.
+struct MiningTruckAssignment
+{
+    MiningLocationHandle MoveToMiningLocationPending;
+    MiningLocationHandle ActiveMiningLocation;
+    UnloadingLocationHandle MovingToUnloadingLocationPending;
+    UnloadingLocationHandle PendingUnload;
+    UnloadingLocationHandle TransitioningToUnload;
+    UnloadingLocationHandle ActiveUnloadingLocation;
+};
+
+// Full snapshot of the simulation taken at a period boundary (a tick where at least one truck finished unloading) whose state hash was seen before.
+// If the boundary one period later has the same state signature, the simulation has become periodic with that period.
+struct SteadyStateSample
+{
+    SimulationTime ElapsedTime = 0;
+    StateSignature Signature;
+    TrackedVector<SimulationTime, EMemorySubsystem::SteadyStateDetection> TruckHeliumUnloaded;
+    TrackedVector<SimulationTime, EMemorySubsystem::SteadyStateDetection> UnloadingLocationTimeUnloading;
+};
+
+struct UnloadingLocationStatus
+{
+    EUnloadingLocationState State = EUnloadingLocationState::Idle;
+    unsigned int QueueLength = 0;
+    double QueueTimeSeconds = 0.0;
+    float Efficiency = 0.0f;
+};
+
+// Point in time summary of a running simulation, for displays.
+// Filled into an existing instance, so its vectors are reused from one frame to the next.
+struct SimulationStatus
+{
+    double ElapsedSeconds = 0.0;
+    double RemainingSeconds = 0.0;
+    float PlaybackSpeed = 1.0f;
+    float GlobalEfficiency = 0.0f;
+    unsigned int NumMiningTrucks = 0;
+    std::array<unsigned int, NumMiningTruckStates> NumMiningTrucksInState{};
+    std::vector<UnloadingLocationStatus> UnloadingLocations;
+};
+
 class MiningTruckController
 {
 
@@ -16,9 +92,10 @@ public:
     OperationEfficiency Teardown();
     OperationEfficiency GetOperationEfficiency() const;
 
-    // Allows changing of the Playback Speed of the Simulation.
+    // Allows changing of the Playback Speed of the Simulation. Only used to pace interactive runs, see SimulationPacer.
     void IncreasePlaybackSpeed();
     void DecreasePlaybackSpeed();
+    void SetPlaybackSpeed(float playbackSpeed);
     float GetMiningTruckSpeed();
 
     // Allows changing of the speed of the Mining Trucks Movement.
@@ -32,65 +109,179 @@ public:
     std::vector<BaseEntity*> GetUnloadingLocations() const;
     float GetGlobalRemainingTime() const;
     float GetMiningEfficiency() const;
+    void GetSimulationStatus(SimulationStatus& outStatus) const;
     void StartSimulation(const SimulationConfiguration& simulationConfiguration);
+
+    // Runs a whole simulation as fast as possible (no real time pacing) and returns the final report. The controller can be reused afterwards.
+    OperationEfficiency RunSimulation(const SimulationConfiguration& simulationConfiguration, float deltaTime = 1.0f);
     void RestartSimulation();
     void ChangeNumTrucks(unsigned int amount);
     void ChangeNumUnloadingStations(unsigned int amount);
     unsigned int GetTotalMiningTrucks();
     unsigned int GetTotalUnloadingStations();
 
-    Delegate<> OnMiningTruckStateChanged;
+    // Moves trucks between simulations. Only call between Ticks.
+    // A truck can only leave while it is mining, so it is never removed from the middle of an unloading queue.
+    bool TransferOutMiningTruck(MiningTruckTransfer& outTransfer);
+    void TransferInMiningTruck(const MiningTruckTransfer& transfer);
+
+    // Called on the simulation thread, as each truck changes state. For consumers on other threads, subscribe to the event bus instead.
+    Delegate<MiningTruckHandle, EMiningTruckState> OnMiningTruckStateChanged;
+
+    // Truck, station and mining location state changes, for any number of consumers on threads of their own.
+    SimulationEventBus& GetEventBus();
+
+    // Keeps metrics up to date as the simulation runs, for exporting from another thread (see MetricsExporter). nullptr detaches them.
+    // The metrics must outlive the controller, or be detached first.
+    void SetMetrics(SimulationMetrics* metrics);
+
+    // Recorded when SimulationConfiguration::TimeSeriesIntervalSeconds is set. Complete once Teardown() returns, and kept until the next run starts.
+    const SimulationTimeSeries& GetTimeSeries() const;
 
 private:
 
     MiningTruckSimulationTimer SimulationTimer;
 
-    // All actors could be placed into the same registry, but for organizational purposes, I'm placing each type of Actor into their own registry for even faster access.
-    std::unordered_map<unsigned int, BaseEntity*> MiningTruckRegistry;
-    std::unordered_map<unsigned int, BaseEntity*> MiningLocationRegistry;
-    std::unordered_map<unsigned int, BaseEntity*> UnloadingLocationRegistry;
+    // Each type of Actor is owned by its own registry (an EntityPool). Actors are referred to by typed handles that resolve with an array lookup.
+    EntityPool<MiningTruck> MiningTruckRegistry;
+    EntityPool<MiningLocation> MiningLocationRegistry;
+    EntityPool<UnloadingLocation> UnloadingLocationRegistry;
+
+    // Mining locations that may be Idle, lowest slot first. Entries that are stale or no longer Idle are skipped when they reach the top.
+    struct LowerSlotFirst
+    {
+        bool operator()(const MiningLocationHandle& lhs, const MiningLocationHandle& rhs) const
+        {
+            return lhs.Index > rhs.Index;
+        }
+    };
+    using IdleMiningLocationQueue = std::priority_queue<MiningLocationHandle, TrackedVector<MiningLocationHandle, EMemorySubsystem::MiningLocations>, LowerSlotFirst>;
+    IdleMiningLocationQueue IdleMiningLocations;
+
+    // Tracks the state of the simulation, one entry per truck slot.
+    TrackedVector<MiningTruckAssignment, EMemorySubsystem::TruckAssignments> MiningTruckAssignments;
+
+    // Mining trucks waiting out their mining time, and the trucks found due or unloading during the current Tick.
+    MiningTruckScheduler Scheduler;
+    TrackedVector<MiningTruckHandle, EMemorySubsystem::Scheduling> DueMiningTrucks;
+    TrackedVector<MiningTruckHandle, EMemorySubsystem::Scheduling> UnloadingMiningTrucks;
 
-    // Hash maps to track the state of the simulation.
-    std::unordered_map<unsigned int, unsigned int> MoveToMiningLocationPending;
-    std::unordered_map<unsigned int, unsigned int> ActiveMiningTrucks;
-    std::unordered_map<unsigned int, unsigned int> MovingToUnloadingLocationPending;
-    std::unordered_map<unsigned int, unsigned int> MiningTrucksPendingUnload;
-    std::unordered_map<unsigned int, unsigned int> MiningTrucksTransitioningToUnload;
-    std::unordered_map<unsigned int, unsigned int> ActiveUnloadingTrucks;
+    // Completion events collected during the current Tick. Trucks never call back into the controller mid-iteration.
+    MiningTruckCompletionEvents TickCompletionEvents;
+
+    // Picks the Unloading Location for each truck that finishes mining.
+    UnloadingDispatcher Dispatcher;
+
+    // State changes, published only while something is subscribed.
+    SimulationEventBus EventBus;
+
+    // Live metrics, only updated while attached.
+    SimulationMetrics* Metrics = nullptr;
+
+    // Mining trucks in each state, kept up to date as they change state rather than counted.
+    std::array<unsigned int, NumMiningTruckStates> NumMiningTrucksInState{};
+
+    // Efficiency, truck states and queues over the run, at a fixed memory cost.
+    SimulationTimeSeries TimeSeries;
+
+    // Time of the latest candidate period boundary with each state signature hash. Only the hash is kept, so a sample costs the same at any fleet size.
+    std::unordered_map<uint64_t, SimulationTime, std::hash<uint64_t>, std::equal_to<uint64_t>,
+                       TrackingAllocator<std::pair<const uint64_t, SimulationTime>, EMemorySubsystem::SteadyStateDetection>> SteadyStateSamples;
+    StateSignature SteadyStateSignature;
+
+    // A boundary whose hash repeated an earlier one, kept in full until the boundary one period later confirms (or rules out) the period.
+    SteadyStateSample SteadyStateCandidate;
+    SimulationTime SteadyStateCandidatePeriod = 0;
+    bool HasSteadyStateCandidate = false;
+    uint64_t NumSteadyStateSignatureWords = 0;
+    SimulationTime SteadyStateDeltaTime = 0;
+    bool SteadyStateExtrapolated = false;
+
+    // Convergence based stopping. Each batch's efficiency is the unloading time added during the batch over the batch length.
+    BatchMeansEstimator EfficiencyBatchMeans;
+    SimulationTime ConvergenceBatchStart = 0;
+    SimulationTime ConvergenceBatchUnloadingTime = 0;
+    bool ConvergenceWarmUpComplete = false;
+    bool Converged = false;
+
+    // Registry (pool) that owns entities of type T.
+    template<typename T>
+    EntityPool<T>& GetRegistry();
 
     template<typename T>
     T* SpawnEntity(const Vector& location);
-    void DestroyEntity(BaseEntity* entity) const;
 
     void SpawnMiningLocations();
 
     // Spawns actors in a circular pattern around the world.
     // This function accepts a lambda function that's called whenever an actor is spawned.
+    // The lambda's type is a template parameter rather than a std::function, so the call is inlined.
     // Used to Spawn Mining Trucks, and Unloading Locations.
-    template<typename T>
+    template<typename T, typename OnEntitySpawned>
     void SpawnActorsInCircularPattern(unsigned int numActorsToSpawn, 
-                                      std::function<void(T*)> onEntitySpawned,
+                                      OnEntitySpawned onEntitySpawned,
                                       float spawnRadius = 1.0f);
     void BeginMiningOperation();
-    void FindLocationToMine(BaseEntity* miningTruckPtr);
+
+    // Returns the assignment entry of a truck, growing the table if the truck was just spawned into a new slot.
+    MiningTruckAssignment& GetAssignment(const MiningTruck* miningTruck);
+
+    // One step of Tick(), at most MaxTickStep long.
+    bool TickStep(SimulationTime deltaTime);
+
+    // The truck update loop: resumes the trucks whose mining wait is over, and ticks the trucks that are unloading. No other truck needs ticking.
+    void ResumeDueMiningTrucks(SimulationTime now);
+    void TickUnloadingMiningTrucks(SimulationTime deltaTime);
+
+    // Processes every completion event raised during the truck update loop, grouped by event type.
+    void DispatchCompletionEvents();
+
+    // Steady state detection. Once the simulation is found to be periodic, whole periods are skipped and their results extrapolated.
+    bool CanExtrapolateSteadyState() const;
+    void BuildStateSignature(StateSignature& signature) const;
+    void DetectSteadyStateCycle(SimulationTime deltaTime);
+    void ExtrapolateSteadyStatePeriods(const SteadyStateSample& periodStart, SimulationTime periodTime, SimulationTime deltaTime);
+    void ResetSteadyStateDetection();
+
+    // Closes the current batch once it is long enough. Returns true once the efficiency estimate is within the configured tolerance.
+    bool UpdateConvergence();
+    void ResetConvergence();
+    SimulationTime GetTotalUnloadingTime() const;
+
+    // Every state change goes through these, so it reaches OnMiningTruckStateChanged and the event bus.
+    void SetMiningTruckState(MiningTruck* miningTruck, EMiningTruckState newState);
+    void SetMiningLocationState(MiningLocation* miningLocation, EMiningLocationState newState);
+    void SetUnloadingLocationState(UnloadingLocation* unloadingLocation, EUnloadingLocationState newState);
+
+    // Stores this tick's efficiency and queue lengths into the attached metrics. Per station, never per truck.
+    void UpdateMetrics();
+
+    // Samples the simulation into the time series. Per station, never per truck.
+    void RecordTimeSeriesSample();
+
+    template<typename T>
+    void PublishStateChange(ESimulationEventType type, EntityHandle<T> handle, size_t previousState, size_t newState);
+
+    void FindLocationToMine(MiningTruck* miningTruck);
+    void ReleaseMiningLocation(MiningLocation* miningLocation);
 
     // Callback handle to set a truck and a mining state to "being mined".
-    void OnMoveToMiningLocationComplete(unsigned int truckUniqueId);
+    void OnMoveToMiningLocationComplete(MiningTruckHandle miningTruckHandle);
 
     // Callback to handle mining a location. Will remove reserves from the mining location until the reserves are depleted.
-    void OnMiningCompleted(unsigned int truckUniqueId);
+    void OnMiningCompleted(MiningTruckHandle miningTruckHandle);
 
     // Callback handling trucks arriving at an unloading queuelocation.
-    void OnMoveToUnloadingQueueComplete(unsigned int truckUniqueId);
+    void OnMoveToUnloadingQueueComplete(MiningTruckHandle miningTruckHandle);
 
     // Callback handling a request from an unloading station to have a truck start unloading cargo.
-    void OnRequestUnloadMiningTruck(unsigned int truckUniqueId);
+    void OnRequestUnloadMiningTruck(MiningTruckHandle miningTruckHandle);
 
     // Callback handling trucks arriving at an unloading location.
-    void OnMoveToUnloadingLocationComplete(unsigned int truckUniqueId);
+    void OnMoveToUnloadingLocationComplete(MiningTruckHandle miningTruckHandle);
 
     // Callback responding to Unloading being completed for a Mining Truck.
-    void OnUnloadingCompleted(unsigned int truckUniqueId);
+    void OnUnloadingCompleted(MiningTruckHandle miningTruckHandle);
 
     void DestroyAllEntities();
 
@@ -109,9 +300,6 @@ private:
     float MiningTruckSpeed = 1.0f;
     float SimulationPlaybackSpeed = 1.0f;
 
-    // Count the number of spawned entities.
-    int NumSpawnedEntities = 0;
-
     // Last Used Simulation Configurations.
     SimulationConfiguration SimConfig;
 };
@@ -0,0 +1,70 @@
+#include "MiningTruckScheduler.h"
+
+#include <algorithm>
+
+namespace
+{
+	// std heap functions build a max-heap, so the comparison is reversed to keep the earliest wake time on top.
+	bool WakesLater(const MiningTruckScheduler::WakeUp& lhs, const MiningTruckScheduler::WakeUp& rhs)
+	{
+		return lhs.WakeAt > rhs.WakeAt;
+	}
+
+	bool LowerSlot(const MiningTruckHandle& lhs, const MiningTruckHandle& rhs)
+	{
+		return lhs.Index < rhs.Index;
+	}
+}
+
+/*
+* Forgets every suspended truck. Reserved storage is kept for the next simulation.
+*/
+void MiningTruckScheduler::Reset()
+{
+	WakeUps.clear();
+}
+
+/*
+* Every truck can be suspended at once, so size the heap for the whole fleet up front.
+*/
+void MiningTruckScheduler::Reserve(unsigned int numMiningTrucks)
+{
+	WakeUps.reserve(numMiningTrucks);
+}
+
+void MiningTruckScheduler::Suspend(MiningTruckHandle miningTruckHandle, SimulationTime wakeAt)
+{
+	WakeUp wakeUp;
+	wakeUp.WakeAt = wakeAt;
+	wakeUp.MiningTruck = miningTruckHandle;
+	WakeUps.push_back(wakeUp);
+	std::push_heap(WakeUps.begin(), WakeUps.end(), WakesLater);
+}
+
+/*
+* Trucks due in the same tick can have different wake times (a tick can cover more than one second), so they are sorted by slot once
+* popped, rather than resumed in wake time order.
+*/
+void MiningTruckScheduler::PopDue(SimulationTime now, TrackedVector<MiningTruckHandle, EMemorySubsystem::Scheduling>& outDue)
+{
+	size_t firstDue = outDue.size();
+	while (!WakeUps.empty() && WakeUps.front().WakeAt <= now)
+	{
+		outDue.push_back(WakeUps.front().MiningTruck);
+		std::pop_heap(WakeUps.begin(), WakeUps.end(), WakesLater);
+		WakeUps.pop_back();
+	}
+
+	std::sort(outDue.begin() + firstDue, outDue.end(), LowerSlot);
+}
+
+/*
+* Shifting every entry by the same amount keeps the heap ordered, so nothing needs re-sorting.
+*/
+void MiningTruckScheduler::AdvanceTime(SimulationTime time)
+{
+	for (WakeUp& wakeUp : WakeUps)
+	{
+		wakeUp.WakeAt += time;
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "Global.h"
+#include "MiningTruck.h"
+
+/*
+* Wakes Mining Trucks that are waiting on simulation time.
+*
+* A mining truck does nothing until its mining time is up, so instead of being ticked every tick it is suspended here with the time it
+* finishes, and resumed on the first tick at or after that time. Suspended trucks cost nothing per tick: a tick only looks at the top of a
+* min-heap keyed by wake time. Storage is reserved for the whole fleet, so suspending and resuming never allocate during the simulation.
+*
+* Entries are never removed early. A truck that left the simulation (or was suspended again since) leaves a stale entry behind, which the
+* controller recognizes and drops when it comes due.
+*/
+class MiningTruckScheduler
+{
+public:
+	MiningTruckScheduler() = default;
+
+	void Reset();
+	void Reserve(unsigned int numMiningTrucks);
+
+	// Wakes the truck on the first tick at or after wakeAt.
+	void Suspend(MiningTruckHandle miningTruckHandle, SimulationTime wakeAt);
+
+	// Removes every entry due at or before now and appends it to outDue, in fleet (slot) order: the order a tick over every truck would find them in.
+	void PopDue(SimulationTime now, TrackedVector<MiningTruckHandle, EMemorySubsystem::Scheduling>& outDue);
+
+	// Moves every wake time forward after simulation time was skipped by steady state extrapolation.
+	void AdvanceTime(SimulationTime time);
+
+	struct WakeUp
+	{
+		SimulationTime WakeAt = 0;
+		MiningTruckHandle MiningTruck;
+	};
+
+private:
+	TrackedVector<WakeUp, EMemorySubsystem::Scheduling> WakeUps;
+};
@@ -4,20 +4,23 @@
 /*
 * Updates the Global Simulation Timer (the 72 hour countdown).
 */
-bool MiningTruckSimulationTimer::Tick(float deltaTime)
+bool MiningTruckSimulationTimer::Tick(SimulationTime deltaTime)
 {
-	if (GlobalRemainingTime <= 0.0f)
+	if (GlobalRemainingTime <= 0)
 	{
 		return true;
 	}
 
 	GlobalRemainingTime -= deltaTime;
-	std::cout << "Simulation Time Left: " << GlobalRemainingTime << " seconds." << std::endl;
+	if (LogSimulationTime)
+	{
+		std::cout << "Simulation Time Left: " << SimulationTimeToSeconds(GlobalRemainingTime) << " seconds." << std::endl;
+	}
 
-	if (GlobalRemainingTime <= 0.0f)
+	if (GlobalRemainingTime <= 0)
 	{
 		// Once our sim timer reaches 0, the simulation is complete, we can exit the sim now.
-		GlobalRemainingTime = 0.0f;
+		GlobalRemainingTime = 0;
 		return true;
 	}
 
@@ -27,7 +30,7 @@ bool MiningTruckSimulationTimer::Tick(float deltaTime)
 /*
 * Returns how much Simulation Time is left.
 */
-double MiningTruckSimulationTimer::GetRemainingGlobalTime() const
+SimulationTime MiningTruckSimulationTimer::GetRemainingGlobalTime() const
 {
 	return GlobalRemainingTime;
 }
@@ -35,7 +38,7 @@ double MiningTruckSimulationTimer::GetRemainingGlobalTime() const
 /*
 * Returns the total Simulation Time we started the simulation with. (72-hours)
 */
-double MiningTruckSimulationTimer::GetMaxGlobalTime() const
+SimulationTime MiningTruckSimulationTimer::GetMaxGlobalTime() const
 {
 	return GlobalMaxTime;
 }
@@ -43,7 +46,7 @@ double MiningTruckSimulationTimer::GetMaxGlobalTime() const
 /*
 * Returns how much Simulation time has passed.
 */
-double MiningTruckSimulationTimer::GetElapsedSimulationTime() const
+SimulationTime MiningTruckSimulationTimer::GetElapsedSimulationTime() const
 {
 	return GlobalMaxTime - GlobalRemainingTime;
 }
@@ -67,9 +70,29 @@ float MiningTruckSimulationTimer::GetGlobalTimeDilation() const
 
 
 /*
-* Sets the Max time (runtime) of the global simulation in seconds.
+* Skips simulation time forward without ticking. Used when the remainder of the simulation is extrapolated.
+*/
+void MiningTruckSimulationTimer::AdvanceTime(SimulationTime time)
+{
+	GlobalRemainingTime -= time;
+	if (GlobalRemainingTime < 0)
+	{
+		GlobalRemainingTime = 0;
+	}
+}
+
+/*
+* Enables or disables printing the remaining Simulation Time every tick.
+*/
+void MiningTruckSimulationTimer::SetLogSimulationTime(bool logSimulationTime)
+{
+	LogSimulationTime = logSimulationTime;
+}
+
+/*
+* Sets the Max time (runtime) of the global simulation.
 */
-void MiningTruckSimulationTimer::SetSimulationMaxTime(float maxTime)
+void MiningTruckSimulationTimer::SetSimulationMaxTime(SimulationTime maxTime)
 {
 	GlobalRemainingTime = maxTime;
 	GlobalMaxTime = maxTime;
@@ -1,4 +1,5 @@
 #pragma once
+#include "Global.h"
 
 class MiningTruckSimulationTimer
 {
@@ -6,18 +7,22 @@ class MiningTruckSimulationTimer
 public:
 	MiningTruckSimulationTimer() = default;
 
-	bool Tick(float DeltaTime);
-	double GetRemainingGlobalTime() const;
-	double GetMaxGlobalTime() const;
-	double GetElapsedSimulationTime() const;
+	bool Tick(SimulationTime deltaTime);
+	SimulationTime GetRemainingGlobalTime() const;
+	SimulationTime GetMaxGlobalTime() const;
+	SimulationTime GetElapsedSimulationTime() const;
 	void SetGlobalTimeDialation(float dilation);
 	float GetGlobalTimeDilation() const;
-	void SetSimulationMaxTime(float maxTime);
+	void SetSimulationMaxTime(SimulationTime maxTime);
+	void AdvanceTime(SimulationTime time);
+	void SetLogSimulationTime(bool logSimulationTime);
 
 private:
 	// 259,200 seconds is 72 hours.
-	double GlobalRemainingTime = 259200.0f;
-	double GlobalMaxTime = 259200.0f;
+	SimulationTime GlobalRemainingTime = 259200 * SimulationTimeTicksPerSecond;
+	SimulationTime GlobalMaxTime = 259200 * SimulationTimeTicksPerSecond;
 
-	double TimeDilation = 1.0f;
+	float TimeDilation = 1.0f;
+
+	bool LogSimulationTime = true;
 };
@@ -0,0 +1,206 @@
+#include "MultiSiteSimulationCoordinator.h"
+#include "SimulationTrace.h"
+
+#include <algorithm>
+#include <random>
+
+/*
+* Runs every site to completion and returns the rolled up report.
+* The calling thread acts as the coordinator: it starts each window, waits for every shard to finish it, then exchanges truck transfers.
+*/
+MultiSiteOperationEfficiency MultiSiteSimulationCoordinator::Run(const MultiSiteConfiguration& configuration)
+{
+	MultiSiteOperationEfficiency report;
+	if (configuration.Sites.empty())
+	{
+		return report;
+	}
+
+	DeltaTimeSeconds = configuration.DeltaTimeSeconds;
+	TicksPerWindow = std::max(1u, static_cast<unsigned int>(configuration.WindowSeconds / configuration.DeltaTimeSeconds));
+	PendingTransfers = configuration.Transfers;
+	std::sort(PendingTransfers.begin(), PendingTransfers.end(), [](const SiteTruckTransfer& lhs, const SiteTruckTransfer& rhs) {
+		return lhs.TimeSeconds < rhs.TimeSeconds;
+	});
+
+	WindowGeneration = 0;
+	ShuttingDown = false;
+
+	Shards.clear();
+	std::random_device seedSource;
+	for (const SimulationConfiguration& siteConfiguration : configuration.Sites)
+	{
+		SimulationConfiguration shardConfiguration = siteConfiguration;
+
+		// Left to the clock, shards starting in the same second would all draw the same stream.
+		while (shardConfiguration.RandomSeed == 0)
+		{
+			shardConfiguration.RandomSeed = seedSource();
+		}
+
+		// Shards share the console, and a site that gains or loses trucks mid-run can't be extrapolated as a single period.
+		shardConfiguration.LogSimulationTime = false;
+		if (!PendingTransfers.empty())
+		{
+			shardConfiguration.EnableSteadyStateExtrapolation = false;
+		}
+
+		std::unique_ptr<SiteShard> shard(new SiteShard());
+		shard->Configuration = shardConfiguration;
+		Shards.push_back(std::move(shard));
+	}
+
+	std::vector<std::thread> shardThreads;
+	shardThreads.reserve(Shards.size());
+	for (auto& shard : Shards)
+	{
+		SiteShard* shardPtr = shard.get();
+		shardThreads.emplace_back([this, shardPtr]() {
+			RunShard(*shardPtr);
+		});
+	}
+
+	SimulationTime windowTime = SecondsToSimulationTime(DeltaTimeSeconds) * TicksPerWindow;
+	SimulationTime windowEndTime = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(WindowMutex);
+			bool anyRunning = std::any_of(Shards.begin(), Shards.end(), [](const std::unique_ptr<SiteShard>& shard) {
+				return !shard->Finished;
+			});
+
+			if (!anyRunning)
+			{
+				ShuttingDown = true;
+				WindowStarted.notify_all();
+				break;
+			}
+
+			// Start the next window and wait for every shard to reach its end.
+			NumShardsRunning = static_cast<unsigned int>(Shards.size());
+			++WindowGeneration;
+			WindowStarted.notify_all();
+			WindowCompleted.wait(lock, [this]() {
+				return NumShardsRunning == 0;
+			});
+		}
+
+		// Every shard is paused at the window boundary, so their controllers can be accessed from here.
+		windowEndTime += windowTime;
+		ExchangeTransfers(windowEndTime);
+	}
+
+	for (std::thread& shardThread : shardThreads)
+	{
+		shardThread.join();
+	}
+
+	for (auto& shard : Shards)
+	{
+		OperationEfficiency siteEfficiency = shard->Controller.Teardown();
+		report.GlobalEfficiency += siteEfficiency.GlobalEfficiency;
+		report.PerSiteEfficiency.push_back(std::move(siteEfficiency));
+	}
+
+	Shards.clear();
+	return report;
+}
+
+/*
+* Body of a shard thread. Starts its controller, so the random stream is seeded and drawn from on this thread only. Then waits for a window to start, receives any trucks posted to its inbox, then ticks its controller through the window.
+*/
+void MultiSiteSimulationCoordinator::RunShard(SiteShard& shard)
+{
+	TRACE_THREAD_NAME("Site shard");
+
+	// The random policy keeps its state per thread. Seeding on the coordinator thread would leave this thread's stream unseeded,
+	// and a seeded multi-site run wouldn't repeat.
+	shard.Controller.StartSimulation(shard.Configuration);
+
+	unsigned int lastWindow = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(WindowMutex);
+			WindowStarted.wait(lock, [this, lastWindow]() {
+				return ShuttingDown || WindowGeneration != lastWindow;
+			});
+
+			if (ShuttingDown)
+			{
+				return;
+			}
+
+			lastWindow = WindowGeneration;
+		}
+
+		{
+			std::lock_guard<std::mutex> inboxLock(shard.InboxMutex);
+			for (const MiningTruckTransfer& transfer : shard.Inbox)
+			{
+				shard.Controller.TransferInMiningTruck(transfer);
+			}
+			shard.Inbox.clear();
+		}
+
+		for (unsigned int i = 0; i < TicksPerWindow && !shard.Finished; ++i)
+		{
+			shard.Finished = shard.Controller.Tick(DeltaTimeSeconds);
+		}
+
+		std::lock_guard<std::mutex> lock(WindowMutex);
+		if (--NumShardsRunning == 0)
+		{
+			WindowCompleted.notify_one();
+		}
+	}
+}
+
+/*
+* Takes every transfer that is due by the end of the window out of its source site and posts it to the destination site's inbox.
+* A transfer that can't be fully served yet (no truck is mining at the source right now) stays pending for the next window.
+*/
+void MultiSiteSimulationCoordinator::ExchangeTransfers(SimulationTime windowEndTime)
+{
+	TRACE_SCOPE("ExchangeTransfers");
+	auto transferIter = PendingTransfers.begin();
+	while (transferIter != PendingTransfers.end() && SecondsToSimulationTime(transferIter->TimeSeconds) <= windowEndTime)
+	{
+		if (transferIter->FromSite >= Shards.size() || transferIter->ToSite >= Shards.size() || transferIter->FromSite == transferIter->ToSite)
+		{
+			transferIter = PendingTransfers.erase(transferIter);
+			continue;
+		}
+
+		SiteShard& fromShard = *Shards[transferIter->FromSite];
+		SiteShard& toShard = *Shards[transferIter->ToSite];
+		if (fromShard.Finished || toShard.Finished)
+		{
+			transferIter = PendingTransfers.erase(transferIter);
+			continue;
+		}
+
+		while (transferIter->NumMiningTrucks > 0)
+		{
+			MiningTruckTransfer transfer;
+			if (!fromShard.Controller.TransferOutMiningTruck(transfer))
+			{
+				break;
+			}
+
+			std::lock_guard<std::mutex> inboxLock(toShard.InboxMutex);
+			toShard.Inbox.push_back(transfer);
+			--transferIter->NumMiningTrucks;
+		}
+
+		if (transferIter->NumMiningTrucks == 0)
+		{
+			transferIter = PendingTransfers.erase(transferIter);
+		}
+		else
+		{
+			++transferIter;
+		}
+	}
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include "Global.h"
+#include "MiningTruckController.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Moves Mining Trucks from one site to another once the simulation reaches TimeSeconds.
+struct SiteTruckTransfer
+{
+	unsigned int FromSite = 0;
+	unsigned int ToSite = 0;
+	float TimeSeconds = 0.0f;
+	unsigned int NumMiningTrucks = 1;
+};
+
+struct MultiSiteConfiguration
+{
+	// One configuration per mining site. Each site runs as its own shard on its own thread.
+	std::vector<SimulationConfiguration> Sites;
+	std::vector<SiteTruckTransfer> Transfers;
+
+	// Shards run independently for a window of simulation time, then wait for each other and exchange trucks.
+	float WindowSeconds = 60.0f;
+	float DeltaTimeSeconds = 1.0f;
+};
+
+/*
+* Operation Report rolled up over every site.
+* Global efficiency is the sum of the site efficiencies, the same way a site's efficiency is the sum of its station efficiencies.
+*/
+struct MultiSiteOperationEfficiency
+{
+	float GlobalEfficiency = 0.0f;
+	std::vector<OperationEfficiency> PerSiteEfficiency;
+
+	void Print()
+	{
+		std::cout << "Multi-Site Global Efficiency: " << GlobalEfficiency << std::endl;
+		for (unsigned int i = 0; i < PerSiteEfficiency.size(); ++i)
+		{
+			std::cout << "Site: " << i << std::endl;
+			PerSiteEfficiency[i].Print();
+		}
+	}
+};
+
+/*
+* Runs several independent mining sites in parallel, one MiningTruckController shard per site, each on its own thread.
+* Shards advance in lockstep windows. Between windows every shard is paused, and scheduled truck transfers are taken out of their source shard
+* and posted to the destination shard's inbox. Each shard drains its own inbox on its own thread at the start of the next window.
+*/
+class MultiSiteSimulationCoordinator
+{
+public:
+	MultiSiteSimulationCoordinator() = default;
+	~MultiSiteSimulationCoordinator() = default;
+
+	MultiSiteOperationEfficiency Run(const MultiSiteConfiguration& configuration);
+
+private:
+	struct SiteShard
+	{
+		MiningTruckController Controller;
+		SimulationConfiguration Configuration;
+
+		// Trucks arriving from other sites. Written by the coordinator between windows, drained by the shard thread.
+		std::mutex InboxMutex;
+		std::vector<MiningTruckTransfer> Inbox;
+
+		bool Finished = false;
+	};
+
+	void RunShard(SiteShard& shard);
+	void ExchangeTransfers(SimulationTime windowEndTime);
+
+	std::vector<std::unique_ptr<SiteShard>> Shards;
+	std::vector<SiteTruckTransfer> PendingTransfers;
+
+	unsigned int TicksPerWindow = 60;
+	float DeltaTimeSeconds = 1.0f;
+
+	// Window hand-off between the coordinator and the shard threads.
+	std::mutex WindowMutex;
+	std::condition_variable WindowStarted;
+	std::condition_variable WindowCompleted;
+	unsigned int WindowGeneration = 0;
+	unsigned int NumShardsRunning = 0;
+	bool ShuttingDown = false;
+};
@@ -0,0 +1,109 @@
+#include "QueueingModelEstimator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	constexpr double SecondsPerHour = 3600.0;
+	constexpr double SecondsPerMinute = 60.0;
+
+	// Mining and unloading times are drawn uniformly between their min and max.
+	double GetMeanMiningSeconds(const MiningAndUnloadingTimes& times)
+	{
+		return 0.5 * (times.MinMiningTimeHours + times.MaxMiningTimeHours) * SecondsPerHour;
+	}
+
+	double GetMeanUnloadingSeconds(const MiningAndUnloadingTimes& times)
+	{
+		return 0.5 * (times.MinUnloadingTimeMinutes + times.MaxUnloadingTimeMinutes) * SecondsPerMinute;
+	}
+}
+
+/*
+* With Z the mean mining time and S the mean unloading time, the probability of k of the N trucks being at the c stations is proportional to
+*     Z^(N - k) / (N - k)!  *  S^k / B(k),    B(k) = k! for k <= c, and c! * c^(k - c) past that
+* (the first term is the N - k trucks mining, each at a site of its own; the second the k trucks unloading or queued). The terms overflow a
+* double long before a large fleet is summed, so they are kept as logs and normalized against the largest one.
+*/
+QueueingModelEstimate QueueingModelEstimator::Estimate(const SimulationConfiguration& configuration)
+{
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	QueueingModelEstimate estimate;
+	estimate.NumMiningTrucks = static_cast<unsigned int>(std::max(0, configuration.NumMiningTrucksToSpawn));
+	estimate.NumUnloadingLocations = static_cast<unsigned int>(std::max(0, configuration.NumUnloadingLocationsToSpawn));
+	estimate.GlobalEfficiencyUpperBound = GetEfficiencyUpperBound(configuration);
+
+	unsigned int numTrucks = estimate.NumMiningTrucks;
+	unsigned int numStations = estimate.NumUnloadingLocations;
+	double miningSeconds = GetMeanMiningSeconds(configuration.MiningAndUnloadingTimes);
+	double unloadingSeconds = GetMeanUnloadingSeconds(configuration.MiningAndUnloadingTimes);
+	if (numTrucks == 0 || numStations == 0 || unloadingSeconds <= 0.0)
+	{
+		estimate.ComputeTimeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		return estimate;
+	}
+
+	// Without any mining time, every truck is always at the stations.
+	unsigned int minTrucksAtStations = miningSeconds > 0.0 ? 0 : numTrucks;
+	double logMiningSeconds = miningSeconds > 0.0 ? log(miningSeconds) : 0.0;
+	double logUnloadingSeconds = log(unloadingSeconds);
+	double logStations = log(static_cast<double>(numStations));
+	double logStationsFactorial = lgamma(numStations + 1.0);
+
+	LogWeights.assign(numTrucks + 1, 0.0);
+	double maxLogWeight = -std::numeric_limits<double>::infinity();
+	for (unsigned int k = minTrucksAtStations; k <= numTrucks; ++k)
+	{
+		unsigned int numMining = numTrucks - k;
+		double logMining = numMining * logMiningSeconds - lgamma(numMining + 1.0);
+		double logStationTerm = k <= numStations ? lgamma(k + 1.0) : logStationsFactorial + (k - numStations) * logStations;
+		LogWeights[k] = logMining + k * logUnloadingSeconds - logStationTerm;
+		maxLogWeight = std::max(maxLogWeight, LogWeights[k]);
+	}
+
+	double totalWeight = 0.0;
+	double meanBusyStations = 0.0;
+	double meanTrucksAtStations = 0.0;
+	for (unsigned int k = minTrucksAtStations; k <= numTrucks; ++k)
+	{
+		double weight = exp(LogWeights[k] - maxLogWeight);
+		totalWeight += weight;
+		meanBusyStations += weight * std::min(k, numStations);
+		meanTrucksAtStations += weight * k;
+	}
+	meanBusyStations /= totalWeight;
+	meanTrucksAtStations /= totalWeight;
+
+	// Little's law turns the mean number of trucks at the stations into the time each one spends there.
+	estimate.Throughput = meanBusyStations / unloadingSeconds;
+	estimate.GlobalEfficiency = static_cast<float>(std::min(meanBusyStations, static_cast<double>(estimate.GlobalEfficiencyUpperBound)));
+	estimate.TruckEfficiency = estimate.GlobalEfficiency / numTrucks;
+	estimate.UnloadingLocationEfficiency = estimate.GlobalEfficiency / numStations;
+	estimate.QueueWaitSeconds = estimate.Throughput > 0.0 ? std::max(0.0, meanTrucksAtStations / estimate.Throughput - unloadingSeconds) : 0.0;
+	estimate.ComputeTimeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	return estimate;
+}
+
+/*
+* Stations can't unload more than one truck each at a time. And a truck starts out mining, so however its times are drawn it can't have spent
+* more than MaxUnloading / (MinMining + MaxUnloading) of any stretch of the run unloading.
+*/
+float QueueingModelEstimator::GetEfficiencyUpperBound(const SimulationConfiguration& configuration)
+{
+	const MiningAndUnloadingTimes& times = configuration.MiningAndUnloadingTimes;
+	double numTrucks = std::max(0, configuration.NumMiningTrucksToSpawn);
+	double bound = std::min(numTrucks, static_cast<double>(std::max(0, configuration.NumUnloadingLocationsToSpawn)));
+
+	double longestUnloadSeconds = times.MaxUnloadingTimeMinutes * SecondsPerMinute;
+	double shortestCycleSeconds = times.MinMiningTimeHours * SecondsPerHour + longestUnloadSeconds;
+	if (shortestCycleSeconds > 0.0)
+	{
+		bound = std::min(bound, numTrucks * longestUnloadSeconds / shortestCycleSeconds);
+	}
+
+	return static_cast<float>(bound);
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include "Global.h"
+
+#include <vector>
+
+/*
+* Expected efficiencies of a configuration, worked out from queueing theory instead of simulated.
+*/
+struct QueueingModelEstimate
+{
+	unsigned int NumMiningTrucks = 0;
+	unsigned int NumUnloadingLocations = 0;
+
+	// Trucks finishing an unload per second, once the fleet has settled into a steady state.
+	double Throughput = 0.0;
+
+	// Same meaning as OperationEfficiency: the sum of every station's efficiency, and the mean of each truck's and each station's.
+	float GlobalEfficiency = 0.0f;
+	float TruckEfficiency = 0.0f;
+	float UnloadingLocationEfficiency = 0.0f;
+
+	// Mean time a truck spends queued at a station before it starts unloading.
+	double QueueWaitSeconds = 0.0;
+
+	// Most efficiency any run of this configuration can reach, whatever the random draws: see QueueingModelEstimator::GetEfficiencyUpperBound().
+	float GlobalEfficiencyUpperBound = 0.0f;
+
+	double ComputeTimeSeconds = 0.0;
+
+	// Relative difference between this estimate and a simulated global efficiency (positive when the estimate is higher).
+	float GetDeviation(float simulatedGlobalEfficiency) const
+	{
+		return simulatedGlobalEfficiency > 0.0f ? (GlobalEfficiency - simulatedGlobalEfficiency) / simulatedGlobalEfficiency : 0.0f;
+	}
+
+	void Print()
+	{
+		std::cout << "Estimated Global Efficiency: " << GlobalEfficiency << " (upper bound " << GlobalEfficiencyUpperBound << ", computed in "
+				  << ComputeTimeSeconds * 1000.0 << " ms)" << std::endl;
+		std::cout << "Estimated Truck Efficiency: " << TruckEfficiency << " Unloading Station Efficiency: " << UnloadingLocationEfficiency
+				  << " Queue Wait: " << QueueWaitSeconds << " seconds." << std::endl;
+	}
+
+	// Prints the estimate next to a simulated run of the same configuration.
+	void PrintDeviation(const OperationEfficiency& simulated)
+	{
+		std::cout << "Estimated Global Efficiency: " << GlobalEfficiency << " Simulated: " << simulated.GlobalEfficiency
+				  << " Deviation: " << GetDeviation(simulated.GlobalEfficiency) * 100.0f << "%" << std::endl;
+	}
+};
+
+/*
+* Models the mine as a closed queueing network: a fixed fleet of trucks cycling between mining (an infinite server delay, since every truck
+* mines at a site of its own) and unloading (c identical servers, one per station). Travel is instant, so those are the only two stages.
+*
+* The network has a product form solution, so the steady state probability of k trucks being at the stations is known exactly, and every
+* efficiency follows from that distribution. Summing it costs O(trucks) and needs no simulation at all, so it can be evaluated for every
+* candidate of a sweep up front. (Mean Value Analysis reaches the same answer, but its multi-server recursion costs O(trucks * stations)
+* and loses all precision once a few dozen stations are nearly always busy.)
+*
+* The model only uses mean times, and assumes one shared queue for every station, so the estimate drifts from the simulator when the
+* dispatcher balances queues poorly or when the run is too short to leave its start (every truck mining at once) behind.
+*/
+class QueueingModelEstimator
+{
+public:
+	QueueingModelEstimator() = default;
+
+	QueueingModelEstimate Estimate(const SimulationConfiguration& configuration);
+
+	/*
+	* Efficiency no run of the configuration can go past: every station unloading non-stop, or every truck doing nothing but its shortest
+	* mine and longest unload. Unlike the estimate, this holds for any run length, so a candidate whose bound misses a goal can be skipped
+	* without ever being simulated.
+	*/
+	static float GetEfficiencyUpperBound(const SimulationConfiguration& configuration);
+
+private:
+	// Log of the unnormalized probability of k trucks being at the stations. Kept between estimates to avoid reallocating.
+	std::vector<double> LogWeights;
+};
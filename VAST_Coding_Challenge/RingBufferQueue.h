@@ -0,0 +1,101 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+// FIFO queue backed by a single contiguous buffer.
+// The buffer is allocated up front (Reserve). Pop never allocates, and Push only allocates when the queue is full, doubling the capacity,
+// so a queue reserved for its usual load reallocates only a handful of times however long the simulation runs.
+// Capacity is rounded up to a power of two so wrapping the read / write positions is a mask instead of a modulo.
+template<typename T, typename Allocator = std::allocator<T>>
+class RingBufferQueue
+{
+public:
+	RingBufferQueue() = default;
+	~RingBufferQueue() = default;
+
+	// Pre-allocates room for at least "capacity" elements. Any queued elements are kept in order.
+	void Reserve(unsigned int capacity)
+	{
+		unsigned int newCapacity = 1;
+		while (newCapacity < capacity)
+		{
+			newCapacity <<= 1;
+		}
+
+		if (newCapacity <= Buffer.size())
+		{
+			return;
+		}
+
+		std::vector<T, Allocator> newBuffer(newCapacity);
+		for (unsigned int i = 0; i < Count; ++i)
+		{
+			newBuffer[i] = Buffer[(Head + i) & Mask];
+		}
+
+		Buffer.swap(newBuffer);
+		Mask = newCapacity - 1;
+		Head = 0;
+	}
+
+	void Push(const T& value)
+	{
+		// Allocates when the queue outgrows its reserved capacity: the buffer is doubled and the queued elements are moved over.
+		if (Count == Buffer.size())
+		{
+			Reserve(Count + 1);
+		}
+
+		Buffer[(Head + Count) & Mask] = value;
+		++Count;
+	}
+
+	void Pop()
+	{
+		if (Count == 0)
+		{
+			return;
+		}
+
+		Head = (Head + 1) & Mask;
+		--Count;
+	}
+
+	const T& Front() const
+	{
+		return Buffer[Head];
+	}
+
+	// Access by position in the queue, 0 being the front.
+	const T& operator[](unsigned int index) const
+	{
+		return Buffer[(Head + index) & Mask];
+	}
+
+	unsigned int Size() const
+	{
+		return Count;
+	}
+
+	bool Empty() const
+	{
+		return Count == 0;
+	}
+
+	unsigned int Capacity() const
+	{
+		return static_cast<unsigned int>(Buffer.size());
+	}
+
+	void Clear()
+	{
+		Head = 0;
+		Count = 0;
+	}
+
+private:
+	std::vector<T, Allocator> Buffer;
+	unsigned int Mask = 0;
+	unsigned int Head = 0;
+	unsigned int Count = 0;
+};
@@ -0,0 +1,531 @@
+#include "ScenarioFileReader.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <sstream>
+
+namespace
+{
+	// Release parsed pages of the mapping every few megabytes rather than after every line.
+	constexpr size_t ReleaseInterval = 4 * 1024 * 1024;
+
+	// Exponents are clamped to this while parsing, well past where a double overflows.
+	constexpr int MaxParsedExponent = 100000;
+
+	const char* const DefaultCsvColumns[] = {
+		"trucks", "stations", "min_mining_hours", "max_mining_hours", "min_unloading_minutes", "max_unloading_minutes", "max_time_seconds"
+	};
+
+	bool IsSpace(char character)
+	{
+		return character == ' ' || character == '\t' || character == '\r';
+	}
+
+	void SkipSpaces(const char*& cursor, const char* end)
+	{
+		while (cursor < end && IsSpace(*cursor))
+		{
+			++cursor;
+		}
+	}
+
+	// Parses a decimal number ([-]digits[.digits][e[-]digits]) directly out of the mapped file. The text is not null terminated, so strtod can't be used.
+	bool ParseNumber(const char*& cursor, const char* end, double& outValue)
+	{
+		const char* position = cursor;
+		bool negative = false;
+		if (position < end && (*position == '-' || *position == '+'))
+		{
+			negative = (*position == '-');
+			++position;
+		}
+
+		double mantissa = 0.0;
+		int exponent = 0;
+		bool anyDigits = false;
+		while (position < end && *position >= '0' && *position <= '9')
+		{
+			mantissa = mantissa * 10.0 + (*position - '0');
+			anyDigits = true;
+			++position;
+		}
+
+		if (position < end && *position == '.')
+		{
+			++position;
+			while (position < end && *position >= '0' && *position <= '9')
+			{
+				mantissa = mantissa * 10.0 + (*position - '0');
+				--exponent;
+				anyDigits = true;
+				++position;
+			}
+		}
+
+		if (!anyDigits)
+		{
+			return false;
+		}
+
+		if (position < end && (*position == 'e' || *position == 'E'))
+		{
+			++position;
+			bool negativeExponent = false;
+			if (position < end && (*position == '-' || *position == '+'))
+			{
+				negativeExponent = (*position == '-');
+				++position;
+			}
+
+			int explicitExponent = 0;
+			bool anyExponentDigits = false;
+			while (position < end && *position >= '0' && *position <= '9')
+			{
+				// Anything this far out is already 0 or infinite, so stop before the int overflows.
+				explicitExponent = std::min(explicitExponent * 10 + (*position - '0'), MaxParsedExponent);
+				anyExponentDigits = true;
+				++position;
+			}
+
+			if (!anyExponentDigits)
+			{
+				return false;
+			}
+			exponent += negativeExponent ? -explicitExponent : explicitExponent;
+		}
+
+		outValue = mantissa * pow(10.0, exponent);
+		if (negative)
+		{
+			outValue = -outValue;
+		}
+
+		// Too large for a double. Treated as malformed, the same as the service does with inf and nan.
+		if (!std::isfinite(outValue))
+		{
+			return false;
+		}
+
+		cursor = position;
+		return true;
+	}
+}
+
+/*
+* Sets the configuration value named by key. Every value is range checked against the type it is stored in before it is converted,
+* since converting an out of range double to an integer (or a float) is undefined.
+*/
+bool ApplyScenarioValue(SimulationConfiguration& configuration, const char* key, size_t keyLength, double value, std::string& outError)
+{
+	auto keyIs = [key, keyLength](const char* name) {
+		return strlen(name) == keyLength && strncmp(key, name, keyLength) == 0;
+	};
+
+	auto inRange = [key, keyLength, value, &outError](double min, double max) {
+		if (value >= min && value <= max)
+		{
+			return true;
+		}
+
+		std::ostringstream error;
+		error.precision(10);
+		error << "'" << std::string(key, keyLength) << "' must be between " << min << " and " << max;
+		outError = error.str();
+		return false;
+	};
+
+	constexpr double MaxFloat = std::numeric_limits<float>::max();
+	if (keyIs("trucks"))
+	{
+		if (!inRange(1.0, MaxScenarioMiningTrucks))
+		{
+			return false;
+		}
+		configuration.NumMiningTrucksToSpawn = static_cast<int>(value);
+	}
+	else if (keyIs("stations"))
+	{
+		if (!inRange(1.0, MaxScenarioUnloadingLocations))
+		{
+			return false;
+		}
+		configuration.NumUnloadingLocationsToSpawn = static_cast<int>(value);
+	}
+	else if (keyIs("dispatch_strategy"))
+	{
+		if (!inRange(0.0, static_cast<double>(EUnloadingDispatchStrategy::EarliestUnloadStart)))
+		{
+			return false;
+		}
+		configuration.DispatchStrategy = static_cast<EUnloadingDispatchStrategy>(static_cast<size_t>(value));
+	}
+	else if (keyIs("random_seed"))
+	{
+		if (!inRange(0.0, std::numeric_limits<unsigned int>::max()))
+		{
+			return false;
+		}
+		configuration.RandomSeed = static_cast<unsigned int>(value);
+	}
+	else
+	{
+		float* setting = nullptr;
+		if (keyIs("min_mining_hours"))
+		{
+			setting = &configuration.MiningAndUnloadingTimes.MinMiningTimeHours;
+		}
+		else if (keyIs("max_mining_hours"))
+		{
+			setting = &configuration.MiningAndUnloadingTimes.MaxMiningTimeHours;
+		}
+		else if (keyIs("min_unloading_minutes"))
+		{
+			setting = &configuration.MiningAndUnloadingTimes.MinUnloadingTimeMinutes;
+		}
+		else if (keyIs("max_unloading_minutes"))
+		{
+			setting = &configuration.MiningAndUnloadingTimes.MaxUnloadingTimeMinutes;
+		}
+		else if (keyIs("max_time_seconds"))
+		{
+			setting = &configuration.SimulationMaxTimeSeconds;
+		}
+		else if (keyIs("convergence_tolerance"))
+		{
+			setting = &configuration.ConvergenceTolerance;
+		}
+		else if (keyIs("convergence_batch_seconds"))
+		{
+			setting = &configuration.ConvergenceBatchSeconds;
+		}
+		else if (keyIs("dispatch_travel_speed"))
+		{
+			setting = &configuration.DispatchTravelSpeed;
+		}
+		else
+		{
+			outError = "unknown key '" + std::string(key, keyLength) + "'";
+			return false;
+		}
+
+		if (!inRange(-MaxFloat, MaxFloat))
+		{
+			return false;
+		}
+		*setting = static_cast<float>(value);
+	}
+
+	return true;
+}
+
+/*
+* Checks that a scenario can be simulated.
+*/
+bool ValidateScenario(const SimulationConfiguration& configuration, std::string& outError)
+{
+	const MiningAndUnloadingTimes& times = configuration.MiningAndUnloadingTimes;
+	if (configuration.NumMiningTrucksToSpawn < 1 || configuration.NumUnloadingLocationsToSpawn < 1)
+	{
+		outError = "trucks and stations must be at least 1";
+		return false;
+	}
+
+	// Written as !(valid) throughout, so a NaN fails every check instead of passing it.
+	if (!(configuration.SimulationMaxTimeSeconds > 0.0f) ||
+		!(times.MinMiningTimeHours > 0.0f) || !(times.MinMiningTimeHours <= times.MaxMiningTimeHours) ||
+		!(times.MinUnloadingTimeMinutes > 0.0f) || !(times.MinUnloadingTimeMinutes <= times.MaxUnloadingTimeMinutes))
+	{
+		outError = "times must be positive, with min <= max";
+		return false;
+	}
+
+	if (!(configuration.SimulationMaxTimeSeconds <= MaxScenarioSimulationSeconds) ||
+		!(times.MaxMiningTimeHours * 3600.0f <= MaxScenarioSimulationSeconds) ||
+		!(times.MaxUnloadingTimeMinutes * 60.0f <= MaxScenarioSimulationSeconds) ||
+		!(configuration.ConvergenceBatchSeconds <= MaxScenarioSimulationSeconds))
+	{
+		std::ostringstream error;
+		error.precision(10);
+		error << "times can't be longer than " << MaxScenarioSimulationSeconds << " seconds";
+		outError = error.str();
+		return false;
+	}
+
+	if (!(configuration.ConvergenceTolerance >= 0.0f) || !(configuration.ConvergenceBatchSeconds > 0.0f))
+	{
+		outError = "convergence_tolerance can't be negative and convergence_batch_seconds must be positive";
+		return false;
+	}
+
+	if (configuration.DispatchStrategy > EUnloadingDispatchStrategy::EarliestUnloadStart || !(configuration.DispatchTravelSpeed >= 0.0f))
+	{
+		outError = "dispatch_strategy must be 0 (shortest queue), 1 (nearest) or 2 (earliest unload start), and dispatch_travel_speed can't be negative";
+		return false;
+	}
+
+	return true;
+}
+
+/*
+* Maps the file and works out its format from the first non-blank character: '{' means JSON lines, anything else CSV.
+* A CSV file whose first line starts with a letter has a header row naming its columns.
+*/
+bool ScenarioFileReader::Open(const std::string& path, std::string& outError)
+{
+	Offset = 0;
+	LineNumber = 0;
+	CsvColumns.assign(std::begin(DefaultCsvColumns), std::end(DefaultCsvColumns));
+
+	if (!File.Open(path))
+	{
+		outError = "unable to open " + path;
+		return false;
+	}
+
+	const char* data = File.GetData();
+	const char* end = data + File.GetSize();
+	const char* cursor = data;
+	while (cursor < end && (IsSpace(*cursor) || *cursor == '\n'))
+	{
+		++cursor;
+	}
+
+	Format = (cursor < end && *cursor == '{') ? EScenarioFileFormat::JsonLines : EScenarioFileFormat::Csv;
+	if (Format == EScenarioFileFormat::Csv && cursor < end && ((*cursor >= 'a' && *cursor <= 'z') || (*cursor >= 'A' && *cursor <= 'Z')))
+	{
+		const char* lineBegin = nullptr;
+		const char* lineEnd = nullptr;
+		ReadLine(lineBegin, lineEnd);
+
+		CsvColumns.clear();
+		SimulationConfiguration validation;
+		const char* column = lineBegin;
+		while (column <= lineEnd)
+		{
+			const char* columnEnd = static_cast<const char*>(memchr(column, ',', lineEnd - column));
+			if (!columnEnd)
+			{
+				columnEnd = lineEnd;
+			}
+
+			const char* nameBegin = column;
+			const char* nameEnd = columnEnd;
+			SkipSpaces(nameBegin, nameEnd);
+			while (nameEnd > nameBegin && IsSpace(nameEnd[-1]))
+			{
+				--nameEnd;
+			}
+
+			std::string keyError;
+			if (!ApplyScenarioValue(validation, nameBegin, nameEnd - nameBegin, 1.0, keyError))
+			{
+				outError = "unknown column '" + std::string(nameBegin, nameEnd) + "'";
+				return false;
+			}
+
+			CsvColumns.emplace_back(nameBegin, nameEnd);
+			column = columnEnd + 1;
+		}
+	}
+
+	return true;
+}
+
+/*
+* Returns the bounds of the next line in the mapping, without the newline. Returns false at the end of the file.
+*/
+bool ScenarioFileReader::ReadLine(const char*& outBegin, const char*& outEnd)
+{
+	size_t size = File.GetSize();
+	if (Offset >= size)
+	{
+		return false;
+	}
+
+	const char* data = File.GetData();
+	const char* begin = data + Offset;
+	const char* newline = static_cast<const char*>(memchr(begin, '\n', size - Offset));
+	const char* end = newline ? newline : data + size;
+
+	outBegin = begin;
+	outEnd = end;
+	Offset = static_cast<size_t>(end - data) + (newline ? 1 : 0);
+	++LineNumber;
+
+	if (Offset / ReleaseInterval != (begin - data) / ReleaseInterval)
+	{
+		File.ReleaseConsumed(begin - data);
+	}
+
+	return true;
+}
+
+/*
+* Reads the next scenario, skipping blank lines and lines starting with '#'.
+*/
+bool ScenarioFileReader::Next(SimulationConfiguration& outConfiguration, std::string& outError)
+{
+	const char* begin = nullptr;
+	const char* end = nullptr;
+	while (ReadLine(begin, end))
+	{
+		SkipSpaces(begin, end);
+		if (begin == end || *begin == '#')
+		{
+			continue;
+		}
+
+		outConfiguration = SimulationConfiguration();
+		outError.clear();
+
+		bool parsed = (Format == EScenarioFileFormat::JsonLines) ? ParseJsonLine(begin, end, outConfiguration, outError)
+																 : ParseCsvLine(begin, end, outConfiguration, outError);
+		if (parsed)
+		{
+			ValidateScenario(outConfiguration, outError);
+		}
+
+		if (!outError.empty())
+		{
+			outConfiguration = SimulationConfiguration();
+		}
+		return true;
+	}
+
+	File.Close();
+	return false;
+}
+
+EScenarioFileFormat ScenarioFileReader::GetFormat() const
+{
+	return Format;
+}
+
+unsigned int ScenarioFileReader::GetLineNumber() const
+{
+	return LineNumber;
+}
+
+/*
+* Parses comma separated numbers, one per column. Empty fields keep the default value.
+*/
+bool ScenarioFileReader::ParseCsvLine(const char* begin, const char* end, SimulationConfiguration& outConfiguration, std::string& outError) const
+{
+	const char* cursor = begin;
+	for (size_t column = 0; cursor <= end; ++column)
+	{
+		if (column >= CsvColumns.size())
+		{
+			outError = "too many columns";
+			return false;
+		}
+
+		SkipSpaces(cursor, end);
+		if (cursor < end && *cursor != ',')
+		{
+			double value = 0.0;
+			if (!ParseNumber(cursor, end, value))
+			{
+				outError = "invalid number in column '" + CsvColumns[column] + "'";
+				return false;
+			}
+
+			if (!ApplyScenarioValue(outConfiguration, CsvColumns[column].c_str(), CsvColumns[column].size(), value, outError))
+			{
+				return false;
+			}
+			SkipSpaces(cursor, end);
+		}
+
+		if (cursor < end && *cursor != ',')
+		{
+			outError = "expected ',' after column '" + CsvColumns[column] + "'";
+			return false;
+		}
+
+		// Step over the comma (or past the end of the line).
+		++cursor;
+	}
+
+	return true;
+}
+
+/*
+* Parses a flat JSON object whose values are all numbers.
+*/
+bool ScenarioFileReader::ParseJsonLine(const char* begin, const char* end, SimulationConfiguration& outConfiguration, std::string& outError) const
+{
+	const char* cursor = begin;
+	if (cursor >= end || *cursor != '{')
+	{
+		outError = "expected '{'";
+		return false;
+	}
+	++cursor;
+
+	SkipSpaces(cursor, end);
+	if (cursor < end && *cursor == '}')
+	{
+		return true;
+	}
+
+	while (cursor < end)
+	{
+		SkipSpaces(cursor, end);
+		if (cursor >= end || *cursor != '"')
+		{
+			outError = "expected a quoted key";
+			return false;
+		}
+
+		const char* keyBegin = ++cursor;
+		const char* keyEnd = static_cast<const char*>(memchr(keyBegin, '"', end - keyBegin));
+		if (!keyEnd)
+		{
+			outError = "unterminated key";
+			return false;
+		}
+		cursor = keyEnd + 1;
+
+		SkipSpaces(cursor, end);
+		if (cursor >= end || *cursor != ':')
+		{
+			outError = "expected ':'";
+			return false;
+		}
+		++cursor;
+		SkipSpaces(cursor, end);
+
+		double value = 0.0;
+		if (!ParseNumber(cursor, end, value))
+		{
+			outError = "invalid number for '" + std::string(keyBegin, keyEnd) + "'";
+			return false;
+		}
+
+		if (!ApplyScenarioValue(outConfiguration, keyBegin, keyEnd - keyBegin, value, outError))
+		{
+			return false;
+		}
+
+		SkipSpaces(cursor, end);
+		if (cursor < end && *cursor == ',')
+		{
+			++cursor;
+			continue;
+		}
+
+		if (cursor < end && *cursor == '}')
+		{
+			return true;
+		}
+
+		outError = "expected ',' or '}'";
+		return false;
+	}
+
+	outError = "unterminated object";
+	return false;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "Global.h"
+#include "MappedFile.h"
+
+#include <string>
+#include <vector>
+
+// Largest fleet and station count a scenario may ask for. Far beyond any real mine, but keeps a typo from exhausting memory.
+constexpr int MaxScenarioMiningTrucks = 1000000;
+constexpr int MaxScenarioUnloadingLocations = 100000;
+
+// Longest simulated time a scenario may ask for, and so the longest any duration in it may be: a year. Far below where seconds overflow
+// SimulationTime, and short enough that one request can't hold a service worker indefinitely.
+constexpr float MaxScenarioSimulationSeconds = 365.0f * 24.0f * 3600.0f;
+static_assert(MaxScenarioSimulationSeconds < static_cast<float>(INT64_MAX / SimulationTimeTicksPerSecond), "scenario times must fit SimulationTime");
+
+// Scenario keys, shared by scenario files and the simulation service:
+// trucks, stations, min_mining_hours, max_mining_hours, min_unloading_minutes, max_unloading_minutes, max_time_seconds,
+// convergence_tolerance, convergence_batch_seconds, dispatch_strategy, dispatch_travel_speed, random_seed.
+// Returns false, with outError set, for unknown keys and for values out of range of the setting they are stored in.
+bool ApplyScenarioValue(SimulationConfiguration& configuration, const char* key, size_t keyLength, double value, std::string& outError);
+bool ValidateScenario(const SimulationConfiguration& configuration, std::string& outError);
+
+enum class EScenarioFileFormat : size_t
+{
+	Csv,		// One scenario per line. Optional header row naming the columns, otherwise the columns are in the key order above.
+	JsonLines	// One flat JSON object per line, e.g. {"trucks": 10, "stations": 3}
+};
+
+/*
+* Streams scenarios out of a CSV or JSON-lines file.
+* The file is memory mapped and parsed in place (no line is copied out of the mapping), and pages are released once they have been parsed,
+* so batches of any size can be read without the whole file being resident.
+*/
+class ScenarioFileReader
+{
+public:
+	ScenarioFileReader() = default;
+	~ScenarioFileReader() = default;
+
+	bool Open(const std::string& path, std::string& outError);
+
+	// Reads the next scenario. Returns false once the file is exhausted.
+	// If the line is malformed it still returns true, with outError set and outConfiguration left at the defaults.
+	bool Next(SimulationConfiguration& outConfiguration, std::string& outError);
+
+	EScenarioFileFormat GetFormat() const;
+	unsigned int GetLineNumber() const;
+
+private:
+	bool ReadLine(const char*& outBegin, const char*& outEnd);
+	bool ParseCsvLine(const char* begin, const char* end, SimulationConfiguration& outConfiguration, std::string& outError) const;
+	bool ParseJsonLine(const char* begin, const char* end, SimulationConfiguration& outConfiguration, std::string& outError) const;
+
+	MappedFile File;
+	size_t Offset = 0;
+	unsigned int LineNumber = 0;
+	EScenarioFileFormat Format = EScenarioFileFormat::Csv;
+
+	// Column keys of a CSV file, from its header row or the default key order.
+	std::vector<std::string> CsvColumns;
+};
@@ -0,0 +1,252 @@
+#include "SimulationEventBus.h"
+
+#include <chrono>
+
+constexpr unsigned int SimulationEventBus::DefaultCapacity;
+
+namespace
+{
+	// How long an idle consumer sleeps before looking for new events again.
+	constexpr std::chrono::milliseconds IdleConsumerSleep(1);
+
+	uint64_t PackEntity(const SimulationEvent& event)
+	{
+		return (static_cast<uint64_t>(event.EntityGeneration) << 32) | event.EntityIndex;
+	}
+
+	uint64_t PackStates(const SimulationEvent& event)
+	{
+		return static_cast<uint64_t>(event.Type) | (static_cast<uint64_t>(event.PreviousState) << 8) | (static_cast<uint64_t>(event.NewState) << 16);
+	}
+}
+
+SimulationEventBus::SimulationEventBus(unsigned int capacity /* = DefaultCapacity */)
+{
+	Capacity = 1;
+	while (Capacity < capacity)
+	{
+		Capacity <<= 1;
+	}
+}
+
+SimulationEventBus::~SimulationEventBus()
+{
+	UnsubscribeAll();
+	if (Slots)
+	{
+		MemoryAccounting::RecordDeallocation(EMemorySubsystem::EventBus, sizeof(Slot) * Capacity);
+	}
+}
+
+/*
+* Seqlock write: the slot's sequence is cleared before the event is written and set once it is complete, so a consumer never mistakes a half
+* written event for a published one.
+*/
+void SimulationEventBus::Publish(SimulationEvent event)
+{
+	// Acquire pairs with Subscribe(), which allocates the ring before counting the subscriber.
+	if (NumSubscribers.load(std::memory_order_acquire) == 0)
+	{
+		return;
+	}
+
+	uint64_t sequence = NextSequence.fetch_add(1, std::memory_order_relaxed);
+	Slot& slot = Slots[sequence & (Capacity - 1)];
+
+	slot.Sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	slot.Words[0].store(static_cast<uint64_t>(event.Time), std::memory_order_relaxed);
+	slot.Words[1].store(PackEntity(event), std::memory_order_relaxed);
+	slot.Words[2].store(PackStates(event), std::memory_order_relaxed);
+
+	// Slots store sequence + 1, so 0 always means "being written" (or never written).
+	slot.Sequence.store(sequence + 1, std::memory_order_release);
+}
+
+SimulationEventBus::SubscriptionId SimulationEventBus::Subscribe(EventHandler handler)
+{
+	std::lock_guard<std::mutex> lock(SubscribersMutex);
+	if (!Slots)
+	{
+		Slots.reset(new Slot[Capacity]);
+		MemoryAccounting::RecordAllocation(EMemorySubsystem::EventBus, sizeof(Slot) * Capacity);
+	}
+
+	std::unique_ptr<Subscriber> subscriber(new Subscriber());
+	subscriber->Id = NextSubscriptionId++;
+	subscriber->Handler = std::move(handler);
+	subscriber->Cursor = NextSequence.load(std::memory_order_acquire);
+
+	Subscriber* subscriberPtr = subscriber.get();
+	subscriber->Thread = std::thread([this, subscriberPtr]() {
+		RunSubscriber(*subscriberPtr);
+	});
+
+	Subscribers.push_back(std::move(subscriber));
+	NumSubscribers.fetch_add(1, std::memory_order_release);
+	return subscriberPtr->Id;
+}
+
+void SimulationEventBus::Unsubscribe(SubscriptionId subscriptionId)
+{
+	std::unique_ptr<Subscriber> subscriber;
+	{
+		std::lock_guard<std::mutex> lock(SubscribersMutex);
+		for (size_t i = 0; i < Subscribers.size(); ++i)
+		{
+			if (Subscribers[i]->Id == subscriptionId)
+			{
+				subscriber = std::move(Subscribers[i]);
+				Subscribers.erase(Subscribers.begin() + i);
+				break;
+			}
+		}
+	}
+
+	if (subscriber)
+	{
+		StopSubscriber(*subscriber);
+	}
+}
+
+void SimulationEventBus::UnsubscribeAll()
+{
+	std::vector<std::unique_ptr<Subscriber>> subscribers;
+	{
+		std::lock_guard<std::mutex> lock(SubscribersMutex);
+		subscribers.swap(Subscribers);
+	}
+
+	for (std::unique_ptr<Subscriber>& subscriber : subscribers)
+	{
+		StopSubscriber(*subscriber);
+	}
+}
+
+uint64_t SimulationEventBus::GetNumPublished() const
+{
+	return NextSequence.load(std::memory_order_relaxed);
+}
+
+uint64_t SimulationEventBus::GetNumHandled(SubscriptionId subscriptionId) const
+{
+	std::lock_guard<std::mutex> lock(SubscribersMutex);
+	const Subscriber* subscriber = FindSubscriber(subscriptionId);
+	return subscriber ? subscriber->NumHandled.load(std::memory_order_relaxed) : 0;
+}
+
+uint64_t SimulationEventBus::GetNumDropped(SubscriptionId subscriptionId) const
+{
+	std::lock_guard<std::mutex> lock(SubscribersMutex);
+	const Subscriber* subscriber = FindSubscriber(subscriptionId);
+	return subscriber ? subscriber->NumDropped.load(std::memory_order_relaxed) : 0;
+}
+
+/*
+* Consumer thread. Handles events in order until asked to stop, then drains whatever was published before the stop request.
+*/
+void SimulationEventBus::RunSubscriber(Subscriber& subscriber)
+{
+	SimulationEvent event;
+	while (true)
+	{
+		bool stopRequested = subscriber.StopRequested.load(std::memory_order_acquire);
+		uint64_t published = NextSequence.load(std::memory_order_acquire);
+
+		bool handledAny = false;
+		while (subscriber.Cursor < published)
+		{
+			EReadResult result = TryRead(subscriber.Cursor, event);
+			if (result == EReadResult::NotPublished)
+			{
+				// Claimed by a producer that hasn't finished writing it. Events are handled in order, so wait for it.
+				break;
+			}
+
+			if (result == EReadResult::Overwritten)
+			{
+				// Lapped: skip to the oldest event that can still be in the ring.
+				uint64_t newest = NextSequence.load(std::memory_order_acquire);
+				uint64_t oldest = newest > Capacity ? newest - Capacity : 0;
+				uint64_t resumeAt = oldest > subscriber.Cursor ? oldest : subscriber.Cursor + 1;
+				subscriber.NumDropped.fetch_add(resumeAt - subscriber.Cursor, std::memory_order_relaxed);
+				subscriber.Cursor = resumeAt;
+				continue;
+			}
+
+			subscriber.Handler(event);
+			subscriber.NumHandled.fetch_add(1, std::memory_order_relaxed);
+			++subscriber.Cursor;
+			handledAny = true;
+		}
+
+		if (stopRequested && subscriber.Cursor >= published)
+		{
+			break;
+		}
+
+		if (!handledAny)
+		{
+			std::this_thread::sleep_for(IdleConsumerSleep);
+		}
+	}
+}
+
+/*
+* Seqlock read: the event is only valid if the slot held this event's sequence both before and after it was copied out.
+*/
+SimulationEventBus::EReadResult SimulationEventBus::TryRead(uint64_t sequence, SimulationEvent& outEvent) const
+{
+	const Slot& slot = Slots[sequence & (Capacity - 1)];
+	uint64_t slotSequence = slot.Sequence.load(std::memory_order_acquire);
+	if (slotSequence != sequence + 1)
+	{
+		// Either an older event still (this one isn't finished), being rewritten, or already a newer one. Only a newer one lapped the consumer.
+		bool lapped = slotSequence > sequence + 1 || NextSequence.load(std::memory_order_acquire) > sequence + Capacity;
+		return lapped ? EReadResult::Overwritten : EReadResult::NotPublished;
+	}
+
+	uint64_t time = slot.Words[0].load(std::memory_order_relaxed);
+	uint64_t entity = slot.Words[1].load(std::memory_order_relaxed);
+	uint64_t states = slot.Words[2].load(std::memory_order_relaxed);
+
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if (slot.Sequence.load(std::memory_order_relaxed) != slotSequence)
+	{
+		return EReadResult::Overwritten;
+	}
+
+	outEvent.Sequence = sequence;
+	outEvent.Time = static_cast<SimulationTime>(time);
+	outEvent.EntityIndex = static_cast<uint32_t>(entity);
+	outEvent.EntityGeneration = static_cast<uint32_t>(entity >> 32);
+	outEvent.Type = static_cast<ESimulationEventType>(states & 0xFF);
+	outEvent.PreviousState = static_cast<uint8_t>((states >> 8) & 0xFF);
+	outEvent.NewState = static_cast<uint8_t>((states >> 16) & 0xFF);
+	return EReadResult::Read;
+}
+
+void SimulationEventBus::StopSubscriber(Subscriber& subscriber)
+{
+	subscriber.StopRequested.store(true, std::memory_order_release);
+	if (subscriber.Thread.joinable())
+	{
+		subscriber.Thread.join();
+	}
+
+	NumSubscribers.fetch_sub(1, std::memory_order_relaxed);
+}
+
+const SimulationEventBus::Subscriber* SimulationEventBus::FindSubscriber(SubscriptionId subscriptionId) const
+{
+	for (const std::unique_ptr<Subscriber>& subscriber : Subscribers)
+	{
+		if (subscriber->Id == subscriptionId)
+		{
+			return subscriber.get();
+		}
+	}
+
+	return nullptr;
+}
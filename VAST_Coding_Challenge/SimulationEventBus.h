@@ -0,0 +1,128 @@
+#pragma once
+#include "Global.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+enum class ESimulationEventType : uint8_t
+{
+	MiningTruckStateChanged,		// States are EMiningTruckState values.
+	UnloadingLocationStateChanged,	// States are EUnloadingLocationState values.
+	MiningLocationStateChanged		// States are EMiningLocationState values.
+};
+
+/*
+* A state change of one entity. The entity is identified by the index and generation of its handle, so a consumer can tell a reused slot
+* apart from the entity that used to be in it.
+*/
+struct SimulationEvent
+{
+	// Position of the event on the bus. Consecutive for a consumer that hasn't dropped any events.
+	uint64_t Sequence = 0;
+
+	SimulationTime Time = 0;
+	ESimulationEventType Type = ESimulationEventType::MiningTruckStateChanged;
+	uint8_t PreviousState = 0;
+	uint8_t NewState = 0;
+	uint32_t EntityIndex = 0;
+	uint32_t EntityGeneration = 0;
+};
+
+/*
+* Broadcasts simulation events to any number of subscribers, each consuming on a thread of its own.
+*
+* Events are written into a fixed size ring. Publishing claims the next position with one atomic add and never waits on a consumer, so a
+* slow logger can't hold up the simulation thread; a consumer that falls a whole ring behind skips ahead and counts the events it missed.
+* Every subscriber keeps its own cursor into the same ring, so adding a consumer doesn't copy the events.
+*
+* Each slot carries the sequence number of the event in it, written last on publish (a seqlock). A consumer checks it before and after
+* copying the event out, which tells it whether the event was published yet, and whether it was overwritten while being read.
+*
+* The ring is only allocated once there is a subscriber, and Publish() should only be called while HasSubscribers() is true, so a simulation
+* nobody is watching pays for one relaxed load per state change.
+*/
+class SimulationEventBus
+{
+public:
+	using EventHandler = std::function<void(const SimulationEvent&)>;
+	using SubscriptionId = unsigned int;
+
+	// Capacity is rounded up to a power of two.
+	explicit SimulationEventBus(unsigned int capacity = DefaultCapacity);
+	~SimulationEventBus();
+
+	SimulationEventBus(const SimulationEventBus&) = delete;
+	SimulationEventBus& operator=(const SimulationEventBus&) = delete;
+
+	// Safe to call from any number of threads at once. Fills in the event's Sequence.
+	void Publish(SimulationEvent event);
+
+	bool HasSubscribers() const
+	{
+		return NumSubscribers.load(std::memory_order_relaxed) > 0;
+	}
+
+	// Starts a consumer thread that calls handler for every event published from now on, in order.
+	SubscriptionId Subscribe(EventHandler handler);
+
+	// Stops a consumer once it has handled every event published before the call. Blocks until its thread has finished.
+	void Unsubscribe(SubscriptionId subscriptionId);
+	void UnsubscribeAll();
+
+	uint64_t GetNumPublished() const;
+	uint64_t GetNumHandled(SubscriptionId subscriptionId) const;
+	uint64_t GetNumDropped(SubscriptionId subscriptionId) const;
+
+	static constexpr unsigned int DefaultCapacity = 1 << 16;
+
+private:
+	// One event packed into three words, stored as atomics so a consumer reading a slot that is being overwritten is not a data race.
+	struct Slot
+	{
+		std::atomic<uint64_t> Sequence{ 0 };
+		std::atomic<uint64_t> Words[3];
+	};
+
+	struct Subscriber
+	{
+		SubscriptionId Id = 0;
+		EventHandler Handler;
+		std::atomic<uint64_t> NumHandled{ 0 };
+		std::atomic<uint64_t> NumDropped{ 0 };
+		std::atomic<bool> StopRequested{ false };
+		uint64_t Cursor = 0;
+		std::thread Thread;
+	};
+
+	void RunSubscriber(Subscriber& subscriber);
+
+	enum class EReadResult
+	{
+		Read,
+		NotPublished,
+		Overwritten
+	};
+	EReadResult TryRead(uint64_t sequence, SimulationEvent& outEvent) const;
+
+	void StopSubscriber(Subscriber& subscriber);
+	const Subscriber* FindSubscriber(SubscriptionId subscriptionId) const;
+
+	unsigned int Capacity = 0;
+	std::unique_ptr<Slot[]> Slots;
+
+	// Claimed by producers, so kept on a cache line of its own away from the consumers' reads of the slots. Padded rather than aligned:
+	// the bus lives inside the controller, and operator new doesn't honour over-aligned members before C++17.
+	static constexpr size_t CacheLineSize = 64;
+	char PaddingBeforeNextSequence[CacheLineSize];
+	std::atomic<uint64_t> NextSequence{ 0 };
+	char PaddingAfterNextSequence[CacheLineSize - sizeof(std::atomic<uint64_t>)];
+	std::atomic<unsigned int> NumSubscribers{ 0 };
+
+	mutable std::mutex SubscribersMutex;
+	std::vector<std::unique_ptr<Subscriber>> Subscribers;
+	SubscriptionId NextSubscriptionId = 1;
+};
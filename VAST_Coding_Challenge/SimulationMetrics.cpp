@@ -0,0 +1,123 @@
+#include "SimulationMetrics.h"
+
+#include <cstdarg>
+#include <cstdio>
+
+namespace
+{
+	// Label values of vast_mining_trucks, in EMiningTruckState order.
+	const char* const MiningTruckStateLabels[NumMiningTruckStates] = {
+		"idle",
+		"moving_to_mining_location",
+		"mining",
+		"moving_to_unloading_location",
+		"in_unloading_queue",
+		"transitioning_to_unload",
+		"unloading",
+	};
+
+	void AppendFormatted(std::string& outText, const char* format, ...)
+	{
+		char line[256];
+		va_list arguments;
+		va_start(arguments, format);
+		int length = vsnprintf(line, sizeof(line), format, arguments);
+		va_end(arguments);
+		if (length > 0)
+		{
+			outText.append(line, static_cast<size_t>(length) < sizeof(line) ? static_cast<size_t>(length) : sizeof(line) - 1);
+		}
+	}
+}
+
+void SimulationMetrics::Reset(unsigned int numUnloadingLocations)
+{
+	NumTicks.store(0, std::memory_order_relaxed);
+	ElapsedTime.store(0, std::memory_order_relaxed);
+	RemainingTime.store(0, std::memory_order_relaxed);
+	GlobalEfficiency.store(0.0f, std::memory_order_relaxed);
+	for (std::atomic<int64_t>& numMiningTrucks : NumMiningTrucksInState)
+	{
+		numMiningTrucks.store(0, std::memory_order_relaxed);
+	}
+
+	std::unique_ptr<std::atomic<uint32_t>[]> queueLengths(new std::atomic<uint32_t>[numUnloadingLocations]);
+	for (unsigned int i = 0; i < numUnloadingLocations; ++i)
+	{
+		queueLengths[i].store(0, std::memory_order_relaxed);
+	}
+
+	std::lock_guard<std::mutex> lock(UnloadingLocationsMutex);
+	UnloadingLocationQueueLengths.swap(queueLengths);
+	NumUnloadingLocations = numUnloadingLocations;
+}
+
+void SimulationMetrics::AddMiningTrucks(EMiningTruckState state, int64_t numMiningTrucks)
+{
+	NumMiningTrucksInState[static_cast<size_t>(state)].fetch_add(numMiningTrucks, std::memory_order_relaxed);
+}
+
+void SimulationMetrics::OnMiningTruckStateChanged(EMiningTruckState previousState, EMiningTruckState newState)
+{
+	NumMiningTrucksInState[static_cast<size_t>(previousState)].fetch_sub(1, std::memory_order_relaxed);
+	NumMiningTrucksInState[static_cast<size_t>(newState)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void SimulationMetrics::OnTick(SimulationTime elapsedTime, SimulationTime remainingTime, float globalEfficiency)
+{
+	NumTicks.fetch_add(1, std::memory_order_relaxed);
+	ElapsedTime.store(elapsedTime, std::memory_order_relaxed);
+	RemainingTime.store(remainingTime, std::memory_order_relaxed);
+	GlobalEfficiency.store(globalEfficiency, std::memory_order_relaxed);
+}
+
+/*
+* Stations spawned after Reset() (past the slots it was sized for) aren't reported.
+*/
+void SimulationMetrics::SetUnloadingLocationQueueLength(unsigned int unloadingLocationIndex, unsigned int queueLength)
+{
+	if (unloadingLocationIndex < NumUnloadingLocations)
+	{
+		UnloadingLocationQueueLengths[unloadingLocationIndex].store(queueLength, std::memory_order_relaxed);
+	}
+}
+
+uint64_t SimulationMetrics::GetNumTicks() const
+{
+	return NumTicks.load(std::memory_order_relaxed);
+}
+
+double SimulationMetrics::GetSimulatedSeconds() const
+{
+	return SimulationTimeToSeconds(ElapsedTime.load(std::memory_order_relaxed));
+}
+
+void SimulationMetrics::WritePrometheusText(std::string& outText) const
+{
+	outText += "# HELP vast_ticks_total Simulation ticks run.\n# TYPE vast_ticks_total counter\n";
+	AppendFormatted(outText, "vast_ticks_total %llu\n", static_cast<unsigned long long>(GetNumTicks()));
+
+	outText += "# HELP vast_simulated_seconds_total Simulation time elapsed.\n# TYPE vast_simulated_seconds_total counter\n";
+	AppendFormatted(outText, "vast_simulated_seconds_total %.3f\n", GetSimulatedSeconds());
+
+	outText += "# HELP vast_remaining_seconds Simulation time left to run.\n# TYPE vast_remaining_seconds gauge\n";
+	AppendFormatted(outText, "vast_remaining_seconds %.3f\n", SimulationTimeToSeconds(RemainingTime.load(std::memory_order_relaxed)));
+
+	outText += "# HELP vast_global_efficiency Time spent unloading over time elapsed, summed over every station.\n# TYPE vast_global_efficiency gauge\n";
+	AppendFormatted(outText, "vast_global_efficiency %.6f\n", GlobalEfficiency.load(std::memory_order_relaxed));
+
+	outText += "# HELP vast_mining_trucks Mining trucks in each state.\n# TYPE vast_mining_trucks gauge\n";
+	for (size_t state = 0; state < NumMiningTruckStates; ++state)
+	{
+		AppendFormatted(outText, "vast_mining_trucks{state=\"%s\"} %lld\n", MiningTruckStateLabels[state],
+						static_cast<long long>(NumMiningTrucksInState[state].load(std::memory_order_relaxed)));
+	}
+
+	outText += "# HELP vast_unloading_station_queue_length Mining trucks waiting in each unloading station's queue.\n"
+			   "# TYPE vast_unloading_station_queue_length gauge\n";
+	std::lock_guard<std::mutex> lock(UnloadingLocationsMutex);
+	for (unsigned int i = 0; i < NumUnloadingLocations; ++i)
+	{
+		AppendFormatted(outText, "vast_unloading_station_queue_length{station=\"%u\"} %u\n", i, UnloadingLocationQueueLengths[i].load(std::memory_order_relaxed));
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "Global.h"
+#include "MiningTruck.h"
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/*
+* Live counters and gauges of one running simulation, kept up to date by the controller as the simulation runs.
+*
+* The simulation thread only ever stores into atomics (per state change, and once per tick), so reading the metrics from another thread never
+* touches an entity and never blocks the simulation. Truck state counts are kept incrementally rather than counted: nothing here scales with
+* the size of the fleet.
+*
+* Attach an instance with MiningTruckController::SetMetrics(). A controller without one doesn't update anything.
+*/
+class SimulationMetrics
+{
+public:
+	SimulationMetrics() = default;
+
+	SimulationMetrics(const SimulationMetrics&) = delete;
+	SimulationMetrics& operator=(const SimulationMetrics&) = delete;
+
+	// Simulation thread. Clears every gauge and sizes the per station gauges for the stations about to be spawned (slot indices below numStations).
+	void Reset(unsigned int numUnloadingLocations);
+	void AddMiningTrucks(EMiningTruckState state, int64_t numMiningTrucks);
+	void OnMiningTruckStateChanged(EMiningTruckState previousState, EMiningTruckState newState);
+	void OnTick(SimulationTime elapsedTime, SimulationTime remainingTime, float globalEfficiency);
+	void SetUnloadingLocationQueueLength(unsigned int unloadingLocationIndex, unsigned int queueLength);
+
+	// Any thread.
+	uint64_t GetNumTicks() const;
+	double GetSimulatedSeconds() const;
+
+	// Appends every metric in the Prometheus text exposition format.
+	void WritePrometheusText(std::string& outText) const;
+
+private:
+	std::atomic<uint64_t> NumTicks{ 0 };
+	std::atomic<int64_t> ElapsedTime{ 0 };
+	std::atomic<int64_t> RemainingTime{ 0 };
+	std::atomic<float> GlobalEfficiency{ 0.0f };
+	std::array<std::atomic<int64_t>, NumMiningTruckStates> NumMiningTrucksInState{};
+
+	// Only replaced by Reset(). Readers lock so the array can't be swapped out from under them; the per tick stores don't need to, as they
+	// run on the same thread as Reset().
+	mutable std::mutex UnloadingLocationsMutex;
+	std::unique_ptr<std::atomic<uint32_t>[]> UnloadingLocationQueueLengths;
+	unsigned int NumUnloadingLocations = 0;
+};
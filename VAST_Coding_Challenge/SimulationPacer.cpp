@@ -0,0 +1,90 @@
+#include "SimulationPacer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+constexpr double SimulationPacer::MaxCatchUpWallSeconds;
+constexpr double SimulationPacer::MinCatchUpTicks;
+
+/*
+* Starts a new schedule. The first tick is due one tick length (at playback speed) from now.
+*/
+void SimulationPacer::Start(float playbackSpeed, float tickSeconds /* = 1.0f */)
+{
+	TickSeconds = tickSeconds > 0.0f ? tickSeconds : 1.0f;
+	NumCoalescedSteps = 0;
+	SlippedSeconds = 0.0;
+	PlaybackSpeed = std::min(std::max(playbackSpeed, MinPlaybackSpeed), MaxPlaybackSpeed);
+	Anchor(Clock::now());
+}
+
+/*
+* Changing speed re-anchors the schedule, otherwise the new speed would apply retroactively to the time since the last anchor.
+*/
+void SimulationPacer::SetPlaybackSpeed(float playbackSpeed)
+{
+	playbackSpeed = std::min(std::max(playbackSpeed, MinPlaybackSpeed), MaxPlaybackSpeed);
+	if (playbackSpeed == PlaybackSpeed)
+	{
+		return;
+	}
+
+	PlaybackSpeed = playbackSpeed;
+	Anchor(Clock::now());
+}
+
+float SimulationPacer::GetPlaybackSpeed() const
+{
+	return PlaybackSpeed;
+}
+
+/*
+* The deadline of the next tick is worked out from the anchor, not from the previous tick, so lateness never carries over.
+* After waking, every whole tick that is owed at the current wall time is handed out in a single step.
+*/
+float SimulationPacer::WaitForNextTick()
+{
+	double nextTickWallSeconds = (SimulatedSinceAnchor + TickSeconds) / PlaybackSpeed;
+	Clock::time_point deadline = AnchorTime + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(nextTickWallSeconds));
+	std::this_thread::sleep_until(deadline);
+
+	Clock::time_point now = Clock::now();
+	double owedSeconds = std::chrono::duration<double>(now - AnchorTime).count() * PlaybackSpeed - SimulatedSinceAnchor;
+
+	// sleep_until can return a hair early on coarse clocks, a tick is always at least one tick long.
+	double numTicks = std::max(std::floor(owedSeconds / TickSeconds), 1.0);
+	double maxTicks = std::max(std::floor(PlaybackSpeed * MaxCatchUpWallSeconds / TickSeconds), MinCatchUpTicks);
+
+	if (numTicks > 1.0)
+	{
+		++NumCoalescedSteps;
+	}
+
+	if (numTicks > maxTicks)
+	{
+		// Too far behind to catch up smoothly. Give up the excess and schedule from now.
+		SlippedSeconds += (numTicks - maxTicks) * TickSeconds;
+		Anchor(now);
+		return static_cast<float>(maxTicks * TickSeconds);
+	}
+
+	SimulatedSinceAnchor += numTicks * TickSeconds;
+	return static_cast<float>(numTicks * TickSeconds);
+}
+
+uint64_t SimulationPacer::GetNumCoalescedSteps() const
+{
+	return NumCoalescedSteps;
+}
+
+double SimulationPacer::GetSlippedSeconds() const
+{
+	return SlippedSeconds;
+}
+
+void SimulationPacer::Anchor(Clock::time_point anchorTime)
+{
+	AnchorTime = anchorTime;
+	SimulatedSinceAnchor = 0.0;
+}
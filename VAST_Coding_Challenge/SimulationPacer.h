@@ -0,0 +1,54 @@
+#pragma once
+#include "Global.h"
+
+#include <chrono>
+#include <cstdint>
+
+/*
+* Paces an interactive simulation against the wall clock.
+*
+* Ticks are scheduled against absolute steady_clock deadlines measured from an anchor point, rather than sleeping a fixed amount after each tick,
+* so the time spent ticking never accumulates as drift: at N times playback speed, N simulated seconds pass per wall second.
+* When ticks can't keep up, the simulated time owed is coalesced into one larger delta instead of being dropped (the controller still simulates
+* it in fixed steps, so the result doesn't depend on playback speed). Only a backlog bigger than MaxCatchUpWallSeconds worth of simulation,
+* and never less than MinCatchUpTicks ticks, is given up (e.g. after the process was suspended), so one stall can't snowball into huge steps.
+*/
+class SimulationPacer
+{
+public:
+	SimulationPacer() = default;
+
+	// Anchors the pacer to the current wall time.
+	void Start(float playbackSpeed, float tickSeconds = 1.0f);
+
+	// Clamped to [MinPlaybackSpeed, MaxPlaybackSpeed]. Re-anchors, so the new speed applies from now on.
+	void SetPlaybackSpeed(float playbackSpeed);
+	float GetPlaybackSpeed() const;
+
+	// Sleeps until the next tick is due and returns the simulated seconds to advance: one tick, or several coalesced when running behind.
+	float WaitForNextTick();
+
+	// Number of steps that had to cover more than one tick, and simulated seconds given up after stalls.
+	uint64_t GetNumCoalescedSteps() const;
+	double GetSlippedSeconds() const;
+
+	// The largest backlog, in wall seconds, that is caught up on rather than given up.
+	static constexpr double MaxCatchUpWallSeconds = 0.25;
+	// At low playback speeds MaxCatchUpWallSeconds is less than a tick, so at least this many ticks are always caught up on.
+	static constexpr double MinCatchUpTicks = 8.0;
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	void Anchor(Clock::time_point anchorTime);
+
+	float PlaybackSpeed = MinPlaybackSpeed;
+	double TickSeconds = 1.0;
+
+	// Wall time the current schedule started at, and simulated seconds handed out since.
+	Clock::time_point AnchorTime;
+	double SimulatedSinceAnchor = 0.0;
+
+	uint64_t NumCoalescedSteps = 0;
+	double SlippedSeconds = 0.0;
+};
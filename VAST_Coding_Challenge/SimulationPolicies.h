@@ -0,0 +1,116 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <random>
+
+/*
+* Compile time policies of the simulation engine.
+* The policy set is picked once per build (define VAST_SIMULATION_POLICIES to one of the presets below), so features a build doesn't use
+* are compiled out instead of being checked every tick, and every policy call is a static, inlinable function.
+*/
+
+// Random number policies. NextUnitFloat() returns a value in [0, 1]. Seed() restarts the sequence, so a run can be repeated exactly.
+
+// One Mersenne Twister per thread, seeded from the OS. Threads and processes running simulations side by side get independent streams.
+struct Mt19937RandomPolicy
+{
+	static float NextUnitFloat()
+	{
+		return std::uniform_real_distribution<float>(0.0f, 1.0f)(GetGenerator());
+	}
+
+	static void Seed(unsigned int seed)
+	{
+		GetGenerator().seed(seed);
+	}
+
+	static std::mt19937& GetGenerator()
+	{
+		thread_local std::mt19937 generator{ std::random_device{}() };
+		return generator;
+	}
+};
+
+// Instrumentation policies. Called from the controller's hot loops, so the default does nothing and compiles away entirely.
+
+struct NullInstrumentationPolicy
+{
+	static void OnTick(size_t, size_t) {}
+	static void OnEntitySpawned() {}
+	static void Print() {}
+};
+
+// Counts ticks, completion events and spawned entities across every controller in the process.
+struct CountingInstrumentationPolicy
+{
+	struct Counters
+	{
+		std::atomic<uint64_t> NumTicks{ 0 };
+		std::atomic<uint64_t> NumMiningCompleted{ 0 };
+		std::atomic<uint64_t> NumUnloadingCompleted{ 0 };
+		std::atomic<uint64_t> NumEntitiesSpawned{ 0 };
+	};
+
+	static Counters& GetCounters()
+	{
+		static Counters counters;
+		return counters;
+	}
+
+	static void OnTick(size_t numMiningCompleted, size_t numUnloadingCompleted)
+	{
+		Counters& counters = GetCounters();
+		counters.NumTicks.fetch_add(1, std::memory_order_relaxed);
+		counters.NumMiningCompleted.fetch_add(numMiningCompleted, std::memory_order_relaxed);
+		counters.NumUnloadingCompleted.fetch_add(numUnloadingCompleted, std::memory_order_relaxed);
+	}
+
+	static void OnEntitySpawned()
+	{
+		GetCounters().NumEntitiesSpawned.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	static void Print()
+	{
+		Counters& counters = GetCounters();
+		std::cout << "Ticks: " << counters.NumTicks << " Mining completed: " << counters.NumMiningCompleted
+				  << " Unloading completed: " << counters.NumUnloadingCompleted << " Entities spawned: " << counters.NumEntitiesSpawned << std::endl;
+	}
+};
+
+// Presets.
+
+// Default, for interactive and bulk runs (batches, the simulation service, multi-site shards) alike. Every optional feature available
+// (and still switchable per run in SimulationConfiguration).
+struct InteractiveSimulationPolicies
+{
+	using Random = Mt19937RandomPolicy;
+	using Instrumentation = NullInstrumentationPolicy;
+	static constexpr bool EnableSteadyStateExtrapolation = true;
+	static constexpr bool EnableConvergenceStopping = true;
+};
+
+// Every run is simulated tick by tick to the end. Used to check extrapolated and early stopped results against.
+struct ReferenceSimulationPolicies
+{
+	using Random = Mt19937RandomPolicy;
+	using Instrumentation = NullInstrumentationPolicy;
+	static constexpr bool EnableSteadyStateExtrapolation = false;
+	static constexpr bool EnableConvergenceStopping = false;
+};
+
+// Interactive, with event counters.
+struct ProfilingSimulationPolicies
+{
+	using Random = Mt19937RandomPolicy;
+	using Instrumentation = CountingInstrumentationPolicy;
+	static constexpr bool EnableSteadyStateExtrapolation = true;
+	static constexpr bool EnableConvergenceStopping = true;
+};
+
+#ifndef VAST_SIMULATION_POLICIES
+#define VAST_SIMULATION_POLICIES InteractiveSimulationPolicies
+#endif
+
+using SimulationPolicies = VAST_SIMULATION_POLICIES;
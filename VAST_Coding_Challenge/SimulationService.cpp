@@ -0,0 +1,635 @@
+#include "SimulationService.h"
+#include "MiningTruckController.h"
+#include "ScenarioFileReader.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+/*
+* Parses a scenario request made of "key=value" pairs separated by spaces.
+* Keys that are not present keep the defaults from SimulationConfiguration.
+*/
+bool SimulationService::ParseScenarioRequest(const std::string& request, SimulationConfiguration& outConfiguration, std::string& outError)
+{
+	std::istringstream tokens(request);
+	std::string token;
+	while (tokens >> token)
+	{
+		size_t separator = token.find('=');
+		if (separator == std::string::npos)
+		{
+			outError = "expected key=value, got '" + token + "'";
+			return false;
+		}
+
+		std::string key = token.substr(0, separator);
+		std::string valueText = token.substr(separator + 1);
+		char* valueEnd = nullptr;
+		double value = strtod(valueText.c_str(), &valueEnd);
+		// strtod also accepts "inf" and "nan", which no scenario value can be.
+		if (valueText.empty() || *valueEnd != '\0' || !std::isfinite(value))
+		{
+			outError = "invalid value for '" + key + "'";
+			return false;
+		}
+
+		if (!ApplyScenarioValue(outConfiguration, key.c_str(), key.size(), value, outError))
+		{
+			return false;
+		}
+	}
+
+	return ValidateScenario(outConfiguration, outError);
+}
+
+#ifdef _WIN32
+
+int SimulationService::Run(const SimulationServiceConfiguration& configuration)
+{
+	std::cout << "The simulation service requires Unix domain sockets and fork(), it is not available on this platform." << std::endl;
+	return 1;
+}
+
+#else
+
+namespace
+{
+	volatile sig_atomic_t StopRequested = 0;
+
+	void OnStopSignal(int)
+	{
+		StopRequested = 1;
+	}
+
+	void SetNonBlocking(int socket)
+	{
+		fcntl(socket, F_SETFL, fcntl(socket, F_GETFL, 0) | O_NONBLOCK);
+	}
+
+	// Blocking write of the whole buffer. Only used on blocking sockets, or for lines small enough to fit in the socket buffer.
+	bool WriteAll(int socket, const std::string& data)
+	{
+		size_t written = 0;
+		while (written < data.size())
+		{
+			ssize_t result = write(socket, data.data() + written, data.size() - written);
+			if (result < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+				return false;
+			}
+			written += static_cast<size_t>(result);
+		}
+		return true;
+	}
+
+	// Returns true if the response ends with its terminating "END" or "ERROR" line.
+	bool IsResponseComplete(const std::string& response)
+	{
+		if (response.empty() || response.back() != '\n')
+		{
+			return false;
+		}
+
+		size_t lineStart = response.rfind('\n', response.size() - 2);
+		lineStart = (lineStart == std::string::npos) ? 0 : lineStart + 1;
+		return response.compare(lineStart, 4, "END ") == 0 || response.compare(lineStart, 6, "ERROR ") == 0;
+	}
+
+	// Requests are buffered per client until a newline. Anything longer than this without one is not a scenario.
+	constexpr size_t MaxRequestLength = 64 * 1024;
+}
+
+/*
+* Sets up the listening socket and worker pool, then multiplexes clients and workers with poll() until asked to stop.
+*/
+int SimulationService::Run(const SimulationServiceConfiguration& configuration)
+{
+	StopRequested = 0;
+	signal(SIGPIPE, SIG_IGN);
+
+	// No SA_RESTART, so a stop signal interrupts poll().
+	struct sigaction stopAction;
+	memset(&stopAction, 0, sizeof(stopAction));
+	stopAction.sa_handler = OnStopSignal;
+	sigaction(SIGINT, &stopAction, nullptr);
+	sigaction(SIGTERM, &stopAction, nullptr);
+
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (configuration.SocketPath.size() >= sizeof(address.sun_path))
+	{
+		std::cout << "Socket path is too long: " << configuration.SocketPath << std::endl;
+		return 1;
+	}
+	strncpy(address.sun_path, configuration.SocketPath.c_str(), sizeof(address.sun_path) - 1);
+
+	ListenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	unlink(configuration.SocketPath.c_str());
+	if (ListenSocket < 0 ||
+		bind(ListenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+		listen(ListenSocket, 64) < 0)
+	{
+		std::cout << "Unable to listen on " << configuration.SocketPath << ": " << strerror(errno) << std::endl;
+		return 1;
+	}
+	SetNonBlocking(ListenSocket);
+
+	Workers.assign(std::max(1u, configuration.NumWorkers), Worker());
+	for (Worker& worker : Workers)
+	{
+		if (!SpawnWorker(worker))
+		{
+			std::cout << "Unable to start simulation workers: " << strerror(errno) << std::endl;
+			return 1;
+		}
+	}
+
+	std::cout << "Simulation service listening on " << configuration.SocketPath << " with " << Workers.size() << " workers." << std::endl;
+
+	std::vector<pollfd> pollSockets;
+	while (!StopRequested)
+	{
+		pollSockets.clear();
+		for (const Worker& worker : Workers)
+		{
+			pollSockets.push_back({ worker.Socket, POLLIN, 0 });
+		}
+		for (const Client& client : Clients)
+		{
+			pollSockets.push_back({ client.Socket, static_cast<short>((client.InputClosed ? 0 : POLLIN) | (client.Output.empty() ? 0 : POLLOUT)), 0 });
+		}
+		pollSockets.push_back({ ListenSocket, POLLIN, 0 });
+
+		if (poll(pollSockets.data(), pollSockets.size(), -1) < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			break;
+		}
+
+		// Workers first, so finished results are queued to clients before the client sockets are flushed.
+		for (size_t i = 0; i < Workers.size(); ++i)
+		{
+			if (pollSockets[i].revents & (POLLIN | POLLHUP | POLLERR))
+			{
+				OnWorkerReadable(Workers[i]);
+			}
+		}
+
+		size_t numClients = Clients.size();
+		for (size_t i = 0; i < numClients; ++i)
+		{
+			short events = pollSockets[Workers.size() + i].revents;
+			Client& client = Clients[i];
+			if (client.Socket >= 0 && (events & POLLIN))
+			{
+				OnClientReadable(client);
+			}
+			if (client.Socket >= 0 && !client.Output.empty())
+			{
+				FlushClient(client);
+			}
+			if (client.Socket >= 0 && (events & (POLLHUP | POLLERR)) && !(events & POLLIN))
+			{
+				CloseClient(client);
+			}
+			if (client.Socket >= 0 && client.InputClosed && client.Output.empty() && !HasOutstandingRequests(client))
+			{
+				CloseClient(client);
+			}
+		}
+
+		Clients.erase(std::remove_if(Clients.begin(), Clients.end(), [](const Client& client) {
+			return client.Socket < 0;
+		}), Clients.end());
+
+		// Accept last, adding clients invalidates references into Clients.
+		if (pollSockets.back().revents & POLLIN)
+		{
+			int clientSocket = -1;
+			while ((clientSocket = accept(ListenSocket, nullptr, nullptr)) >= 0)
+			{
+				SetNonBlocking(clientSocket);
+				Client client;
+				client.Id = NextClientId++;
+				client.Socket = clientSocket;
+				Clients.push_back(client);
+			}
+		}
+
+		DispatchJobs();
+	}
+
+	for (Client& client : Clients)
+	{
+		CloseClient(client);
+	}
+	Clients.clear();
+
+	for (Worker& worker : Workers)
+	{
+		close(worker.Socket);
+		kill(worker.ProcessId, SIGTERM);
+		waitpid(worker.ProcessId, nullptr, 0);
+	}
+	Workers.clear();
+
+	close(ListenSocket);
+	ListenSocket = -1;
+	unlink(configuration.SocketPath.c_str());
+	return 0;
+}
+
+/*
+* Forks a worker process connected to the service through a socket pair.
+* The child closes every socket that belongs to the service before it starts serving scenarios.
+*/
+bool SimulationService::SpawnWorker(Worker& worker)
+{
+	int sockets[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) < 0)
+	{
+		return false;
+	}
+
+	pid_t processId = fork();
+	if (processId < 0)
+	{
+		close(sockets[0]);
+		close(sockets[1]);
+		return false;
+	}
+
+	if (processId == 0)
+	{
+		signal(SIGINT, SIG_DFL);
+		signal(SIGTERM, SIG_DFL);
+
+		close(sockets[0]);
+		close(ListenSocket);
+		for (const Worker& otherWorker : Workers)
+		{
+			if (otherWorker.Socket >= 0)
+			{
+				close(otherWorker.Socket);
+			}
+		}
+		for (const Client& client : Clients)
+		{
+			if (client.Socket >= 0)
+			{
+				close(client.Socket);
+			}
+		}
+
+		RunWorker(sockets[1]);
+		_exit(0);
+	}
+
+	close(sockets[1]);
+	SetNonBlocking(sockets[0]);
+
+	worker.ProcessId = processId;
+	worker.Socket = sockets[0];
+	worker.Output.clear();
+	worker.ClientId = 0;
+	worker.RequestNumber = 0;
+	return true;
+}
+
+/*
+* Worker process main loop. Reads "<request number> <scenario>" lines, runs each scenario on the same warm controller, and writes back the response block.
+*/
+void SimulationService::RunWorker(int workerSocket)
+{
+	MiningTruckController miningTruckSim;
+	std::string input;
+	char buffer[4096];
+
+	while (true)
+	{
+		ssize_t numRead = read(workerSocket, buffer, sizeof(buffer));
+		if (numRead < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (numRead <= 0)
+		{
+			return;
+		}
+		input.append(buffer, static_cast<size_t>(numRead));
+
+		size_t lineEnd = std::string::npos;
+		while ((lineEnd = input.find('\n')) != std::string::npos)
+		{
+			std::string line = input.substr(0, lineEnd);
+			input.erase(0, lineEnd + 1);
+
+			size_t separator = line.find(' ');
+			std::string requestNumber = line.substr(0, separator);
+			std::string request = (separator == std::string::npos) ? std::string() : line.substr(separator + 1);
+
+			SimulationConfiguration config;
+			config.LogSimulationTime = false;
+
+			std::string error;
+			std::ostringstream response;
+			if (!ParseScenarioRequest(request, config, error))
+			{
+				response << "ERROR " << requestNumber << " " << error << "\n";
+			}
+			else
+			{
+				OperationEfficiency efficiency = miningTruckSim.RunSimulation(config);
+				response << "RESULT " << requestNumber << " global=" << efficiency.GlobalEfficiency
+						 << " trucks=" << efficiency.PerTruckEfficiency.size()
+						 << " stations=" << efficiency.PerUnloadingLocationEfficiency.size() << "\n";
+				for (size_t i = 0; i < efficiency.PerTruckEfficiency.size(); ++i)
+				{
+					response << "TRUCK " << requestNumber << " " << i << " " << efficiency.PerTruckEfficiency[i] << "\n";
+				}
+				for (size_t i = 0; i < efficiency.PerUnloadingLocationEfficiency.size(); ++i)
+				{
+					response << "STATION " << requestNumber << " " << i << " " << efficiency.PerUnloadingLocationEfficiency[i] << "\n";
+				}
+				response << "END " << requestNumber << "\n";
+			}
+
+			if (!WriteAll(workerSocket, response.str()))
+			{
+				return;
+			}
+		}
+	}
+}
+
+/*
+* Hands pending jobs to idle workers, oldest first.
+*/
+void SimulationService::DispatchJobs()
+{
+	for (Worker& worker : Workers)
+	{
+		if (PendingJobs.empty())
+		{
+			return;
+		}
+
+		if (worker.ClientId != 0)
+		{
+			continue;
+		}
+
+		Job job = PendingJobs.front();
+		PendingJobs.erase(PendingJobs.begin());
+
+		worker.ClientId = job.ClientId;
+		worker.RequestNumber = job.RequestNumber;
+		worker.Output.clear();
+
+		std::ostringstream line;
+		line << job.RequestNumber << " " << job.Request << "\n";
+		if (!WriteAll(worker.Socket, line.str()))
+		{
+			OnWorkerLost(worker);
+		}
+	}
+}
+
+/*
+* Reads a worker's response. Once the response block is complete it is queued to the client that asked for it.
+*/
+void SimulationService::OnWorkerReadable(Worker& worker)
+{
+	char buffer[4096];
+	while (true)
+	{
+		ssize_t numRead = read(worker.Socket, buffer, sizeof(buffer));
+		if (numRead > 0)
+		{
+			worker.Output.append(buffer, static_cast<size_t>(numRead));
+			continue;
+		}
+
+		if (numRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+		{
+			break;
+		}
+
+		// End of file or error, the worker process is gone.
+		OnWorkerLost(worker);
+		return;
+	}
+
+	if (worker.ClientId != 0 && IsResponseComplete(worker.Output))
+	{
+		Client* client = FindClient(worker.ClientId);
+		if (client)
+		{
+			client->Output += worker.Output;
+		}
+
+		worker.Output.clear();
+		worker.ClientId = 0;
+		worker.RequestNumber = 0;
+	}
+}
+
+/*
+* A worker crashed or was killed. Fails the request it was running (the client stays connected) and replaces the worker.
+*/
+void SimulationService::OnWorkerLost(Worker& worker)
+{
+	if (worker.ClientId != 0)
+	{
+		Client* client = FindClient(worker.ClientId);
+		if (client)
+		{
+			std::ostringstream error;
+			error << "ERROR " << worker.RequestNumber << " worker crashed\n";
+			client->Output += error.str();
+		}
+	}
+
+	close(worker.Socket);
+	kill(worker.ProcessId, SIGKILL);
+	waitpid(worker.ProcessId, nullptr, 0);
+
+	worker = Worker();
+	if (!SpawnWorker(worker))
+	{
+		std::cout << "Unable to replace simulation worker: " << strerror(errno) << std::endl;
+		StopRequested = 1;
+	}
+}
+
+/*
+* Reads scenario requests from a client and queues one job per complete line.
+*/
+void SimulationService::OnClientReadable(Client& client)
+{
+	char buffer[4096];
+	while (true)
+	{
+		ssize_t numRead = read(client.Socket, buffer, sizeof(buffer));
+		if (numRead > 0)
+		{
+			client.Input.append(buffer, static_cast<size_t>(numRead));
+			continue;
+		}
+
+		if (numRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+		{
+			break;
+		}
+
+		if (numRead < 0)
+		{
+			CloseClient(client);
+			return;
+		}
+
+		// The client shut down its write side (or disconnected). Requests it already sent are still answered, a last line included
+		// even without its newline, and the socket is closed once their responses have been written.
+		client.InputClosed = true;
+		if (!client.Input.empty() && client.Input.back() != '\n')
+		{
+			client.Input += '\n';
+		}
+		break;
+	}
+
+	size_t lineEnd = std::string::npos;
+	while ((lineEnd = client.Input.find('\n')) != std::string::npos)
+	{
+		std::string line = client.Input.substr(0, lineEnd);
+		client.Input.erase(0, lineEnd + 1);
+		if (!line.empty() && line.back() == '\r')
+		{
+			line.pop_back();
+		}
+
+		if (line.empty())
+		{
+			continue;
+		}
+
+		Job job;
+		job.ClientId = client.Id;
+		job.RequestNumber = ++client.NumRequests;
+		job.Request = line;
+		PendingJobs.push_back(job);
+	}
+
+	if (client.Input.size() > MaxRequestLength)
+	{
+		CloseClient(client);
+	}
+}
+
+/*
+* Writes as much queued output to a client as its socket accepts without blocking.
+*/
+bool SimulationService::FlushClient(Client& client)
+{
+	while (!client.Output.empty())
+	{
+		ssize_t numWritten = write(client.Socket, client.Output.data(), client.Output.size());
+		if (numWritten > 0)
+		{
+			client.Output.erase(0, static_cast<size_t>(numWritten));
+			continue;
+		}
+
+		if (numWritten < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+		{
+			return true;
+		}
+
+		CloseClient(client);
+		return false;
+	}
+
+	return true;
+}
+
+/*
+* Closes a client and drops its queued jobs. Results of jobs already running are discarded when they arrive.
+*/
+void SimulationService::CloseClient(Client& client)
+{
+	if (client.Socket < 0)
+	{
+		return;
+	}
+
+	close(client.Socket);
+	client.Socket = -1;
+
+	unsigned int clientId = client.Id;
+	PendingJobs.erase(std::remove_if(PendingJobs.begin(), PendingJobs.end(), [clientId](const Job& job) {
+		return job.ClientId == clientId;
+	}), PendingJobs.end());
+}
+
+/*
+* True while a request of the client is waiting for a worker or being run by one.
+*/
+bool SimulationService::HasOutstandingRequests(const Client& client) const
+{
+	for (const Job& job : PendingJobs)
+	{
+		if (job.ClientId == client.Id)
+		{
+			return true;
+		}
+	}
+
+	for (const Worker& worker : Workers)
+	{
+		if (worker.ClientId == client.Id)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+* Returns the connected client with the given Id, or nullptr if it has disconnected.
+*/
+SimulationService::Client* SimulationService::FindClient(unsigned int clientId)
+{
+	for (Client& client : Clients)
+	{
+		if (client.Id == clientId && client.Socket >= 0)
+		{
+			return &client;
+		}
+	}
+	return nullptr;
+}
+
+#endif
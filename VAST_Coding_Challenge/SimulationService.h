@@ -0,0 +1,92 @@
+#pragma once
+#include "Global.h"
+
+#include <string>
+#include <vector>
+
+struct SimulationServiceConfiguration
+{
+	std::string SocketPath = "/tmp/vast_simulation.sock";
+	unsigned int NumWorkers = 4;
+};
+
+/*
+* Long running local simulation service.
+*
+* Listens on a Unix domain socket for scenario requests, one per line:
+*     trucks=10 stations=3 min_mining_hours=1 max_mining_hours=5 min_unloading_minutes=5 max_unloading_minutes=5 max_time_seconds=259200
+* Any key left out keeps the SimulationConfiguration default. Requests can be pipelined on a connection; they are numbered from 1 per connection.
+*
+* Each request is answered with a block:
+*     RESULT <request> global=<efficiency> trucks=<count> stations=<count>
+*     TRUCK <request> <index> <efficiency>
+*     STATION <request> <index> <efficiency>
+*     END <request>
+* or a single "ERROR <request> <message>" line.
+*
+* Scenarios are run by a pool of pre-forked worker processes, each holding a warm MiningTruckController.
+* The service process only multiplexes sockets, so requests from many clients are served concurrently,
+* and a worker that crashes only fails the request it was running. The worker is then replaced.
+*
+* POSIX only. On Windows Run() reports that the service is unavailable.
+*/
+class SimulationService
+{
+public:
+	SimulationService() = default;
+	~SimulationService() = default;
+
+	// Blocks until the service is stopped with SIGINT / SIGTERM. Returns the process exit code.
+	int Run(const SimulationServiceConfiguration& configuration);
+
+	// Parses a "key=value key=value" scenario request. Returns false and fills outError if the request is malformed.
+	static bool ParseScenarioRequest(const std::string& request, SimulationConfiguration& outConfiguration, std::string& outError);
+
+private:
+	struct Worker
+	{
+		int ProcessId = -1;
+		int Socket = -1;
+		std::string Output;
+
+		// Client and request currently being run by the worker. ClientId 0 means the worker is idle.
+		unsigned int ClientId = 0;
+		unsigned int RequestNumber = 0;
+	};
+
+	struct Client
+	{
+		unsigned int Id = 0;
+		int Socket = -1;
+		std::string Input;
+		std::string Output;
+		unsigned int NumRequests = 0;
+
+		// The client shut down its side of the connection. It is closed once every request it sent has been answered.
+		bool InputClosed = false;
+	};
+
+	struct Job
+	{
+		unsigned int ClientId = 0;
+		unsigned int RequestNumber = 0;
+		std::string Request;
+	};
+
+	bool SpawnWorker(Worker& worker);
+	void RunWorker(int workerSocket);
+	void DispatchJobs();
+	void OnWorkerReadable(Worker& worker);
+	void OnWorkerLost(Worker& worker);
+	void OnClientReadable(Client& client);
+	bool FlushClient(Client& client);
+	void CloseClient(Client& client);
+	bool HasOutstandingRequests(const Client& client) const;
+	Client* FindClient(unsigned int clientId);
+
+	int ListenSocket = -1;
+	std::vector<Worker> Workers;
+	std::vector<Client> Clients;
+	std::vector<Job> PendingJobs;
+	unsigned int NextClientId = 1;
+};
@@ -0,0 +1,255 @@
+#include "SimulationTestSuite.h"
+
+#include "MiningTruckController.h"
+#include "QueueingModelEstimator.h"
+
+#include <cmath>
+
+#include <chrono>
+#include <sstream>
+
+constexpr float SimulationTestSuite::TrendTolerance;
+constexpr float SimulationTestSuite::BoundsTolerance;
+constexpr float SimulationTestSuite::ModelDeviationTolerance;
+
+namespace
+{
+	// Every test run uses the same seed.
+	constexpr unsigned int TestRandomSeed = 12345;
+
+	// The whole 72 hours, with the default 1 - 5 hour mining times.
+	constexpr float TestSimulationSeconds = 259200.0f;
+
+	// Memory budget. Station queues are sized for a share of the fleet, so nothing may grow with trucks times stations.
+	constexpr int64_t MemoryBudgetBytesPerTruck = 1024;
+	constexpr int64_t MemoryBudgetBytesPerStation = 4096;
+
+	struct ScaleTestSize
+	{
+		unsigned int NumMiningTrucks;
+		unsigned int NumUnloadingLocations;
+		double WallTimeBudgetSeconds;
+	};
+
+	// Wall time budgets leave several times the expected run time, so only a real regression (not a busy machine) fails them.
+	const ScaleTestSize ScaleTestSizes[] = {
+		{ 10, 3, 1.0 },
+		{ 100, 10, 2.0 },
+		{ 1000, 30, 10.0 },
+		{ 10000, 100, 60.0 },
+	};
+
+	// A truck mines for 3 hours on average and unloads for 5 minutes, so a station is only kept busy by around 37 trucks.
+	// Every fleet is more than the stations can serve, so trucks queue and their efficiency drops measurably as trucks are added.
+	// Below that, trucks barely wait and their efficiency only moves by noise.
+	const unsigned int MoreTrucksFleetSizes[] = { 128, 256, 512, 1024, 2048 };
+	constexpr unsigned int MoreTrucksNumUnloadingLocations = 3;
+
+	// Congested up to the last station count, which is where the stations start running out of trucks.
+	constexpr unsigned int MoreStationsNumMiningTrucks = 192;
+	const unsigned int MoreStationsStationCounts[] = { 1, 2, 3, 4, 6 };
+
+	std::string DescribeScenario(unsigned int numMiningTrucks, unsigned int numUnloadingLocations)
+	{
+		std::ostringstream description;
+		description << numMiningTrucks << " trucks, " << numUnloadingLocations << " stations";
+		return description.str();
+	}
+}
+
+/*
+* Runs the three strategies in order and prints a summary. Returns the number of failed checks.
+*/
+unsigned int SimulationTestSuite::Run()
+{
+	NumChecks = 0;
+	NumFailures = 0;
+
+	std::cout << "Strategy #1. Scale Test" << std::endl;
+	RunScaleTests();
+
+	std::cout << "Strategy #2. More Mining Trucks, same Unloading Stations" << std::endl;
+	RunMoreTrucksTests();
+
+	std::cout << "Strategy #3. Fewer Mining Trucks, more Unloading Stations" << std::endl;
+	RunMoreStationsTests();
+
+	std::cout << (NumChecks - NumFailures) << " of " << NumChecks << " checks passed." << std::endl;
+	return NumFailures;
+}
+
+/*
+* Runs one seeded scenario on a controller of its own, timing it and measuring the memory it holds at the end of the run.
+*/
+SimulationTestSuite::TestRun SimulationTestSuite::RunScenario(unsigned int numMiningTrucks, unsigned int numUnloadingLocations) const
+{
+	SimulationConfiguration config;
+	config.NumMiningTrucksToSpawn = static_cast<int>(numMiningTrucks);
+	config.NumUnloadingLocationsToSpawn = static_cast<int>(numUnloadingLocations);
+	config.SimulationMaxTimeSeconds = TestSimulationSeconds;
+	config.RandomSeed = TestRandomSeed;
+	config.LogSimulationTime = false;
+
+	TestRun run;
+	run.Configuration = config;
+	int64_t memoryBefore = MemoryAccounting::GetFootprint().TotalBytes;
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	{
+		MiningTruckController controller;
+		run.Efficiency = controller.RunSimulation(config);
+	}
+	run.WallTimeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	run.MemoryBytes = run.Efficiency.Memory.TotalBytes - memoryBefore;
+
+	for (float truckEfficiency : run.Efficiency.PerTruckEfficiency)
+	{
+		run.MeanTruckEfficiency += truckEfficiency / run.Efficiency.PerTruckEfficiency.size();
+	}
+
+	for (float unloadingLocationEfficiency : run.Efficiency.PerUnloadingLocationEfficiency)
+	{
+		run.MeanUnloadingLocationEfficiency += unloadingLocationEfficiency / run.Efficiency.PerUnloadingLocationEfficiency.size();
+	}
+
+	return run;
+}
+
+/*
+* Every fleet size must finish within its wall time budget and keep its footprint within the memory budget.
+* Its efficiency must also agree with the queueing model, which catches the simulation drifting away from the mine it models.
+*/
+void SimulationTestSuite::RunScaleTests()
+{
+	QueueingModelEstimator estimator;
+	for (const ScaleTestSize& size : ScaleTestSizes)
+	{
+		std::string name = DescribeScenario(size.NumMiningTrucks, size.NumUnloadingLocations);
+		TestRun run = RunScenario(size.NumMiningTrucks, size.NumUnloadingLocations);
+
+		Check(run.Efficiency.PerTruckEfficiency.size() == size.NumMiningTrucks &&
+			  run.Efficiency.PerUnloadingLocationEfficiency.size() == size.NumUnloadingLocations,
+			  name + ": every truck and station reported");
+		CheckEfficiencyBounds(name, run, size.NumUnloadingLocations);
+
+		std::ostringstream wallTime;
+		wallTime << name << ": ran in " << run.WallTimeSeconds << " s (budget " << size.WallTimeBudgetSeconds << " s)";
+		Check(run.WallTimeSeconds <= size.WallTimeBudgetSeconds, wallTime.str());
+
+		int64_t memoryBudget = MemoryBudgetBytesPerTruck * size.NumMiningTrucks + MemoryBudgetBytesPerStation * size.NumUnloadingLocations;
+		std::ostringstream memory;
+		memory << name << ": uses " << run.MemoryBytes << " bytes, " << run.Efficiency.Memory.BytesPerMiningTruck << " per truck (budget " << memoryBudget << " bytes)";
+		Check(run.MemoryBytes <= memoryBudget && run.Efficiency.Memory.BytesPerMiningTruck <= MemoryBudgetBytesPerTruck, memory.str());
+
+		QueueingModelEstimate estimate = estimator.Estimate(run.Configuration);
+		float deviation = estimate.GetDeviation(run.Efficiency.GlobalEfficiency);
+		std::ostringstream model;
+		model << name << ": global efficiency " << run.Efficiency.GlobalEfficiency << " vs queueing model " << estimate.GlobalEfficiency
+			  << " (" << deviation * 100.0f << "%, tolerance " << ModelDeviationTolerance * 100.0f << "%)";
+		Check(fabsf(deviation) <= ModelDeviationTolerance, model.str());
+	}
+}
+
+/*
+* Adding trucks to a fixed number of stations: more Helium-3 overall, but each truck waits longer in the queues.
+*/
+void SimulationTestSuite::RunMoreTrucksTests()
+{
+	TestRun previousRun;
+	bool hasPreviousRun = false;
+	for (unsigned int numMiningTrucks : MoreTrucksFleetSizes)
+	{
+		std::string name = DescribeScenario(numMiningTrucks, MoreTrucksNumUnloadingLocations);
+		TestRun run = RunScenario(numMiningTrucks, MoreTrucksNumUnloadingLocations);
+		CheckEfficiencyBounds(name, run, MoreTrucksNumUnloadingLocations);
+
+		if (hasPreviousRun)
+		{
+			CheckTrend(name + ": global efficiency", run.Efficiency.GlobalEfficiency, previousRun.Efficiency.GlobalEfficiency, true);
+			CheckTrend(name + ": truck efficiency", run.MeanTruckEfficiency, previousRun.MeanTruckEfficiency, false);
+		}
+
+		previousRun = run;
+		hasPreviousRun = true;
+	}
+
+	// With far more trucks than stations, the stations never run out of trucks to unload.
+	std::ostringstream stationEfficiency;
+	stationEfficiency << "Largest fleet: station efficiency " << previousRun.MeanUnloadingLocationEfficiency << " >= 0.95";
+	Check(previousRun.MeanUnloadingLocationEfficiency >= 0.95f, stationEfficiency.str());
+
+	CrowdedTruckEfficiency = previousRun.MeanTruckEfficiency;
+}
+
+/*
+* Adding stations for a fixed fleet: trucks queue less, and the stations share the same amount of work.
+*/
+void SimulationTestSuite::RunMoreStationsTests()
+{
+	TestRun previousRun;
+	bool hasPreviousRun = false;
+	for (unsigned int numUnloadingLocations : MoreStationsStationCounts)
+	{
+		std::string name = DescribeScenario(MoreStationsNumMiningTrucks, numUnloadingLocations);
+		TestRun run = RunScenario(MoreStationsNumMiningTrucks, numUnloadingLocations);
+		CheckEfficiencyBounds(name, run, numUnloadingLocations);
+
+		if (hasPreviousRun)
+		{
+			CheckTrend(name + ": truck efficiency", run.MeanTruckEfficiency, previousRun.MeanTruckEfficiency, true);
+			CheckTrend(name + ": station efficiency", run.MeanUnloadingLocationEfficiency, previousRun.MeanUnloadingLocationEfficiency, false);
+		}
+
+		previousRun = run;
+		hasPreviousRun = true;
+	}
+
+	std::ostringstream comparedToCrowded;
+	comparedToCrowded << "Most stations: truck efficiency " << previousRun.MeanTruckEfficiency << " > " << CrowdedTruckEfficiency << " (largest fleet of strategy #2)";
+	Check(previousRun.MeanTruckEfficiency > CrowdedTruckEfficiency, comparedToCrowded.str());
+}
+
+/*
+* A truck can't spend more than all of its time unloading, neither can a station, and the fleet can't unload at more stations than exist.
+*/
+void SimulationTestSuite::CheckEfficiencyBounds(const std::string& name, const TestRun& run, unsigned int numUnloadingLocations)
+{
+	bool withinBounds = run.Efficiency.GlobalEfficiency >= 0.0f && run.Efficiency.GlobalEfficiency <= numUnloadingLocations + BoundsTolerance;
+	for (float truckEfficiency : run.Efficiency.PerTruckEfficiency)
+	{
+		withinBounds = withinBounds && truckEfficiency >= 0.0f && truckEfficiency <= 1.0f + BoundsTolerance;
+	}
+
+	for (float unloadingLocationEfficiency : run.Efficiency.PerUnloadingLocationEfficiency)
+	{
+		withinBounds = withinBounds && unloadingLocationEfficiency >= 0.0f && unloadingLocationEfficiency <= 1.0f + BoundsTolerance;
+	}
+
+	std::ostringstream description;
+	description << name << ": efficiencies within bounds (global " << run.Efficiency.GlobalEfficiency << ")";
+	Check(withinBounds, description.str());
+}
+
+/*
+* The tolerance is relative, so it means the same for truck efficiencies of a few percent as for global efficiencies near the station count.
+*/
+void SimulationTestSuite::CheckTrend(const std::string& description, float value, float previousValue, bool expectIncrease)
+{
+	float tolerance = TrendTolerance * fabsf(previousValue);
+	bool passed = expectIncrease ? value >= previousValue - tolerance : value <= previousValue + tolerance;
+
+	std::ostringstream check;
+	check << description << " " << value << (expectIncrease ? " >= " : " <= ") << previousValue << " (tolerance " << tolerance << ")";
+	Check(passed, check.str());
+}
+
+bool SimulationTestSuite::Check(bool passed, const std::string& description)
+{
+	++NumChecks;
+	if (!passed)
+	{
+		++NumFailures;
+	}
+
+	std::cout << (passed ? "  [PASS] " : "  [FAIL] ") << description << std::endl;
+	return passed;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "Global.h"
+
+#include <string>
+#include <vector>
+
+/*
+* Automated version of the README testing strategies.
+*
+* Strategy #1 (scale): runs the full 72 hours at increasing fleet sizes, each within a wall time and memory budget, and each close to the
+* efficiency the queueing model expects.
+* Strategy #2 (more trucks, same stations): global efficiency must rise and per truck efficiency fall as trucks are added,
+* and the stations must end up at full capacity.
+* Strategy #3 (fewer trucks, more stations): per truck efficiency must rise and station efficiency fall as stations are added,
+* with trucks doing better than they did in strategy #2.
+*
+* Every run uses a fixed random seed, so results are repeatable. Each check is printed as it runs, and Run() returns the number that failed.
+*/
+class SimulationTestSuite
+{
+public:
+	SimulationTestSuite() = default;
+
+	unsigned int Run();
+
+	// Efficiency trends are allowed to go against the expected direction by this fraction of the previous value before a check fails.
+	static constexpr float TrendTolerance = 0.02f;
+
+	// Efficiencies may exceed their possible range by this much (rounding of extrapolated time) before a check fails.
+	static constexpr float BoundsTolerance = 0.01f;
+
+	// Scale test runs must be within this relative difference of the queueing model's global efficiency estimate.
+	static constexpr float ModelDeviationTolerance = 0.1f;
+
+private:
+	struct TestRun
+	{
+		SimulationConfiguration Configuration;
+		OperationEfficiency Efficiency;
+		double WallTimeSeconds = 0.0;
+		int64_t MemoryBytes = 0;
+		float MeanTruckEfficiency = 0.0f;
+		float MeanUnloadingLocationEfficiency = 0.0f;
+	};
+
+	TestRun RunScenario(unsigned int numMiningTrucks, unsigned int numUnloadingLocations) const;
+
+	void RunScaleTests();
+	void RunMoreTrucksTests();
+	void RunMoreStationsTests();
+
+	// Checks that hold for any run: efficiencies within their possible range.
+	void CheckEfficiencyBounds(const std::string& name, const TestRun& run, unsigned int numUnloadingLocations);
+
+	// Checks that an efficiency moved the expected way from the previous run, within TrendTolerance of the previous value.
+	void CheckTrend(const std::string& description, float value, float previousValue, bool expectIncrease);
+
+	bool Check(bool passed, const std::string& description);
+
+	unsigned int NumChecks = 0;
+	unsigned int NumFailures = 0;
+
+	// Per truck efficiency at the largest fleet of strategy #2, compared against in strategy #3.
+	float CrowdedTruckEfficiency = 0.0f;
+};
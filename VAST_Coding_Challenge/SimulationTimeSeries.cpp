@@ -0,0 +1,250 @@
+#include "SimulationTimeSeries.h"
+#include "BufferedFileWriter.h"
+
+#include <algorithm>
+
+namespace
+{
+	// Column names of the truck state counts, in EMiningTruckState order.
+	const char* const MiningTruckStateColumns[NumMiningTruckStates] = {
+		"trucks_idle",
+		"trucks_moving_to_mining_location",
+		"trucks_mining",
+		"trucks_moving_to_unloading_location",
+		"trucks_in_unloading_queue",
+		"trucks_transitioning_to_unload",
+		"trucks_unloading",
+	};
+}
+
+/*
+* Every buffer is allocated here, for the whole run. Recording never allocates.
+*/
+void SimulationTimeSeries::Reset(float sampleIntervalSeconds, unsigned int maxPoints, unsigned int numUnloadingLocations)
+{
+	SampleInterval = sampleIntervalSeconds > 0.0f ? std::max<SimulationTime>(SecondsToSimulationTime(sampleIntervalSeconds), 1) : 0;
+	NextSampleTime = SampleInterval;
+
+	// Points are merged in pairs, so keep an even number of them.
+	MaxPoints = SampleInterval > 0 ? std::max(2u, maxPoints + (maxPoints & 1u)) : 0;
+	NumUnloadingLocations = SampleInterval > 0 ? numUnloadingLocations : 0;
+
+	NumPoints = 0;
+	SamplesPerPoint = 1;
+	Times.assign(MaxPoints, 0);
+	GlobalEfficiencies.assign(MaxPoints, 0.0f);
+	IntervalEfficiencies.assign(MaxPoints, 0.0f);
+	NumMiningTrucksInState.assign(static_cast<size_t>(MaxPoints) * NumMiningTruckStates, 0.0f);
+	UnloadingLocationQueueTimes.assign(static_cast<size_t>(MaxPoints) * NumUnloadingLocations, 0.0f);
+
+	NumPendingSamples = 0;
+	PendingTime = 0;
+	PendingNumMiningTrucksInState.fill(0.0);
+	PendingQueueTimes.assign(NumUnloadingLocations, 0.0);
+	PointStartTime = 0;
+	PointStartUnloadingTime = 0;
+}
+
+bool SimulationTimeSeries::IsEnabled() const
+{
+	return SampleInterval > 0;
+}
+
+bool SimulationTimeSeries::IsSampleDue(SimulationTime elapsedTime) const
+{
+	return SampleInterval > 0 && elapsedTime >= NextSampleTime;
+}
+
+void SimulationTimeSeries::BeginSample(SimulationTime elapsedTime, float globalEfficiency, SimulationTime totalUnloadingTime,
+									   const std::array<unsigned int, NumMiningTruckStates>& numMiningTrucksInState)
+{
+	PendingTime = elapsedTime;
+	PendingGlobalEfficiency = globalEfficiency;
+	PendingUnloadingTime = totalUnloadingTime;
+	for (size_t state = 0; state < NumMiningTruckStates; ++state)
+	{
+		PendingNumMiningTrucksInState[state] += numMiningTrucksInState[state];
+	}
+
+	// Steady state extrapolation can skip a long way ahead. Carry on sampling at the interval from here, rather than catching up.
+	NextSampleTime += SampleInterval;
+	if (NextSampleTime <= elapsedTime)
+	{
+		NextSampleTime = elapsedTime + SampleInterval;
+	}
+}
+
+void SimulationTimeSeries::AddUnloadingLocationQueueTime(unsigned int unloadingLocationIndex, SimulationTime queueTime)
+{
+	if (unloadingLocationIndex < NumUnloadingLocations)
+	{
+		PendingQueueTimes[unloadingLocationIndex] += SimulationTimeToSeconds(queueTime);
+	}
+}
+
+void SimulationTimeSeries::EndSample()
+{
+	if (++NumPendingSamples == SamplesPerPoint)
+	{
+		StorePendingPoint();
+	}
+}
+
+void SimulationTimeSeries::Finish()
+{
+	if (NumPendingSamples > 0)
+	{
+		StorePendingPoint();
+	}
+}
+
+SimulationTime SimulationTimeSeries::GetLastSampleTime() const
+{
+	return PendingTime;
+}
+
+unsigned int SimulationTimeSeries::GetNumPoints() const
+{
+	return NumPoints;
+}
+
+unsigned int SimulationTimeSeries::GetNumUnloadingLocations() const
+{
+	return NumUnloadingLocations;
+}
+
+unsigned int SimulationTimeSeries::GetSamplesPerPoint() const
+{
+	return SamplesPerPoint;
+}
+
+double SimulationTimeSeries::GetTimeSeconds(unsigned int point) const
+{
+	return SimulationTimeToSeconds(Times[point]);
+}
+
+float SimulationTimeSeries::GetGlobalEfficiency(unsigned int point) const
+{
+	return GlobalEfficiencies[point];
+}
+
+float SimulationTimeSeries::GetIntervalEfficiency(unsigned int point) const
+{
+	return IntervalEfficiencies[point];
+}
+
+float SimulationTimeSeries::GetNumMiningTrucksInState(unsigned int point, EMiningTruckState state) const
+{
+	return NumMiningTrucksInState[static_cast<size_t>(point) * NumMiningTruckStates + static_cast<size_t>(state)];
+}
+
+float SimulationTimeSeries::GetUnloadingLocationQueueTimeSeconds(unsigned int point, unsigned int unloadingLocationIndex) const
+{
+	return UnloadingLocationQueueTimes[static_cast<size_t>(point) * NumUnloadingLocations + unloadingLocationIndex];
+}
+
+bool SimulationTimeSeries::WriteCsv(const std::string& path, std::string& outError) const
+{
+	BufferedFileWriter writer;
+	if (!writer.Open(path))
+	{
+		outError = "unable to open " + path;
+		return false;
+	}
+
+	writer.Write(std::string("time_seconds,global_efficiency,interval_efficiency"));
+	for (const char* column : MiningTruckStateColumns)
+	{
+		writer.WriteFormatted(",%s", column);
+	}
+	for (unsigned int i = 0; i < NumUnloadingLocations; ++i)
+	{
+		writer.WriteFormatted(",queue_time_seconds_station_%u", i);
+	}
+	writer.Write(std::string("\n"));
+
+	for (unsigned int point = 0; point < NumPoints; ++point)
+	{
+		writer.WriteFormatted("%.3f,%.6f,%.6f", GetTimeSeconds(point), GlobalEfficiencies[point], IntervalEfficiencies[point]);
+		for (size_t state = 0; state < NumMiningTruckStates; ++state)
+		{
+			writer.WriteFormatted(",%.3f", GetNumMiningTrucksInState(point, static_cast<EMiningTruckState>(state)));
+		}
+		for (unsigned int i = 0; i < NumUnloadingLocations; ++i)
+		{
+			writer.WriteFormatted(",%.3f", GetUnloadingLocationQueueTimeSeconds(point, i));
+		}
+		writer.Write(std::string("\n"));
+	}
+
+	if (!writer.Close())
+	{
+		outError = "unable to write " + path;
+		return false;
+	}
+	return true;
+}
+
+void SimulationTimeSeries::StorePendingPoint()
+{
+	if (NumPoints == MaxPoints)
+	{
+		MergePointPairs();
+	}
+
+	unsigned int point = NumPoints++;
+	Times[point] = PendingTime;
+	GlobalEfficiencies[point] = PendingGlobalEfficiency;
+	SimulationTime span = PendingTime - PointStartTime;
+	IntervalEfficiencies[point] = span > 0 ? static_cast<float>(static_cast<double>(PendingUnloadingTime - PointStartUnloadingTime) / static_cast<double>(span)) : 0.0f;
+
+	for (size_t state = 0; state < NumMiningTruckStates; ++state)
+	{
+		NumMiningTrucksInState[static_cast<size_t>(point) * NumMiningTruckStates + state] = static_cast<float>(PendingNumMiningTrucksInState[state] / NumPendingSamples);
+		PendingNumMiningTrucksInState[state] = 0.0;
+	}
+	for (unsigned int i = 0; i < NumUnloadingLocations; ++i)
+	{
+		UnloadingLocationQueueTimes[static_cast<size_t>(point) * NumUnloadingLocations + i] = static_cast<float>(PendingQueueTimes[i] / NumPendingSamples);
+		PendingQueueTimes[i] = 0.0;
+	}
+
+	NumPendingSamples = 0;
+	PointStartTime = PendingTime;
+	PointStartUnloadingTime = PendingUnloadingTime;
+}
+
+/*
+* Halves the number of points. Both points of a pair hold the mean of the same number of samples, so averaging the two keeps the means exact.
+* Their spans can differ though (extrapolation skips time), so interval efficiency is weighted by span instead.
+*/
+void SimulationTimeSeries::MergePointPairs()
+{
+	for (unsigned int point = 0; point < NumPoints / 2; ++point)
+	{
+		unsigned int first = point * 2;
+		unsigned int second = first + 1;
+		// Read before writing, the previous pair can end in the slot this point is stored to.
+		SimulationTime firstStart = first > 0 ? Times[first - 1] : 0;
+		SimulationTime span = Times[second] - firstStart;
+		double unloadingTime = static_cast<double>(IntervalEfficiencies[first]) * (Times[first] - firstStart) + static_cast<double>(IntervalEfficiencies[second]) * (Times[second] - Times[first]);
+
+		Times[point] = Times[second];
+		GlobalEfficiencies[point] = GlobalEfficiencies[second];
+		IntervalEfficiencies[point] = span > 0 ? static_cast<float>(unloadingTime / static_cast<double>(span)) : 0.0f;
+
+		for (size_t state = 0; state < NumMiningTruckStates; ++state)
+		{
+			NumMiningTrucksInState[static_cast<size_t>(point) * NumMiningTruckStates + state] =
+				0.5f * (NumMiningTrucksInState[static_cast<size_t>(first) * NumMiningTruckStates + state] + NumMiningTrucksInState[static_cast<size_t>(second) * NumMiningTruckStates + state]);
+		}
+		for (unsigned int i = 0; i < NumUnloadingLocations; ++i)
+		{
+			UnloadingLocationQueueTimes[static_cast<size_t>(point) * NumUnloadingLocations + i] =
+				0.5f * (UnloadingLocationQueueTimes[static_cast<size_t>(first) * NumUnloadingLocations + i] + UnloadingLocationQueueTimes[static_cast<size_t>(second) * NumUnloadingLocations + i]);
+		}
+	}
+
+	NumPoints /= 2;
+	SamplesPerPoint *= 2;
+}
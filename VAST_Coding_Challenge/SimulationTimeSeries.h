@@ -0,0 +1,83 @@
+#pragma once
+#include "Global.h"
+#include "MiningTruck.h"
+
+#include <array>
+#include <string>
+
+/*
+* How global efficiency, truck states and station queues evolve over a run, in memory that doesn't grow with the run's length.
+*
+* The simulation is sampled every SampleIntervalSeconds of simulation time. Samples are averaged into points, and points are stored in
+* buffers allocated once per run for MaxPoints points. When the buffers fill up, neighbouring points are merged in pairs and each point
+* covers twice as many samples from then on, so a short run keeps full resolution and a long one is spread evenly over the same MaxPoints.
+*
+* Each point covers the span of simulation time ending at its Time:
+* - GlobalEfficiency is the running value at Time, as the end of run report computes it.
+* - IntervalEfficiency is the unloading done during the span over the span's length (summed over every station).
+* - Truck state counts and station queue times are the mean of the samples in the span.
+*/
+class SimulationTimeSeries
+{
+public:
+	SimulationTimeSeries() = default;
+
+	// Clears the series and sizes it for a run. A sample interval of 0 turns recording off.
+	void Reset(float sampleIntervalSeconds, unsigned int maxPoints, unsigned int numUnloadingLocations);
+	bool IsEnabled() const;
+	bool IsSampleDue(SimulationTime elapsedTime) const;
+
+	// One sample: BeginSample(), the queue time of every station, then EndSample().
+	void BeginSample(SimulationTime elapsedTime, float globalEfficiency, SimulationTime totalUnloadingTime,
+					 const std::array<unsigned int, NumMiningTruckStates>& numMiningTrucksInState);
+	void AddUnloadingLocationQueueTime(unsigned int unloadingLocationIndex, SimulationTime queueTime);
+	void EndSample();
+	SimulationTime GetLastSampleTime() const;
+
+	// Stores the samples taken since the last point as a (shorter) final point. Called once the run is over.
+	void Finish();
+
+	unsigned int GetNumPoints() const;
+	unsigned int GetNumUnloadingLocations() const;
+	unsigned int GetSamplesPerPoint() const;
+	double GetTimeSeconds(unsigned int point) const;
+	float GetGlobalEfficiency(unsigned int point) const;
+	float GetIntervalEfficiency(unsigned int point) const;
+	float GetNumMiningTrucksInState(unsigned int point, EMiningTruckState state) const;
+	float GetUnloadingLocationQueueTimeSeconds(unsigned int point, unsigned int unloadingLocationIndex) const;
+
+	// One row per point: time, both efficiencies, trucks in each state, then each station's queue time. Returns false if the file can't be opened.
+	bool WriteCsv(const std::string& path, std::string& outError) const;
+
+private:
+	void StorePendingPoint();
+	void MergePointPairs();
+
+	using FloatSeries = TrackedVector<float, EMemorySubsystem::TimeSeries>;
+
+	SimulationTime SampleInterval = 0;
+	SimulationTime NextSampleTime = 0;
+	unsigned int MaxPoints = 0;
+	unsigned int NumUnloadingLocations = 0;
+
+	// Points stored so far, each covering SamplesPerPoint samples. Per station values are stored point by point, NumUnloadingLocations at a time.
+	unsigned int NumPoints = 0;
+	unsigned int SamplesPerPoint = 1;
+	TrackedVector<SimulationTime, EMemorySubsystem::TimeSeries> Times;
+	FloatSeries GlobalEfficiencies;
+	FloatSeries IntervalEfficiencies;
+	FloatSeries NumMiningTrucksInState;
+	FloatSeries UnloadingLocationQueueTimes;
+
+	// Sums of the samples taken towards the next point. PendingTime is the time of the latest sample.
+	unsigned int NumPendingSamples = 0;
+	SimulationTime PendingTime = 0;
+	float PendingGlobalEfficiency = 0.0f;
+	SimulationTime PendingUnloadingTime = 0;
+	std::array<double, NumMiningTruckStates> PendingNumMiningTrucksInState{};
+	TrackedVector<double, EMemorySubsystem::TimeSeries> PendingQueueTimes;
+
+	// Where the span of the next point starts.
+	SimulationTime PointStartTime = 0;
+	SimulationTime PointStartUnloadingTime = 0;
+};
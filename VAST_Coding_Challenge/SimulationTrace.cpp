@@ -0,0 +1,176 @@
+#include "SimulationTrace.h"
+#include "BufferedFileWriter.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+	// Reserved the first time a thread records, so short traces never reallocate.
+	constexpr size_t InitialEventsPerThread = 1 << 12;
+
+	struct TraceEvent
+	{
+		const char* Name = nullptr;
+		int64_t StartNanoseconds = 0;
+		int64_t DurationNanoseconds = 0;
+	};
+
+	// Only its own thread appends to a buffer. The mutex is uncontended unless the trace is being written or cleared at the same time.
+	struct ThreadBuffer
+	{
+		uint32_t ThreadId = 0;
+		const char* ThreadName = nullptr;
+		std::mutex Mutex;
+		std::vector<TraceEvent> Events;
+		uint64_t NumDropped = 0;
+	};
+
+	// Buffers outlive their threads, so events recorded by a thread that has since exited are still written.
+	struct TraceRegistry
+	{
+		std::mutex Mutex;
+		std::vector<std::unique_ptr<ThreadBuffer>> Buffers;
+		uint32_t NextThreadId = 1;
+		int64_t StartNanoseconds = 0;
+
+		// Read by every recording thread, under its own buffer's mutex rather than the registry's.
+		std::atomic<size_t> MaxEventsPerThread{ SimulationTrace::DefaultMaxEventsPerThread };
+	};
+
+	TraceRegistry& GetRegistry()
+	{
+		static TraceRegistry registry;
+		return registry;
+	}
+
+	ThreadBuffer& GetThreadBuffer()
+	{
+		thread_local ThreadBuffer* threadBuffer = nullptr;
+		if (!threadBuffer)
+		{
+			TraceRegistry& registry = GetRegistry();
+			std::lock_guard<std::mutex> lock(registry.Mutex);
+			std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer());
+			buffer->ThreadId = registry.NextThreadId++;
+			buffer->Events.reserve(InitialEventsPerThread);
+			threadBuffer = buffer.get();
+			registry.Buffers.push_back(std::move(buffer));
+		}
+
+		return *threadBuffer;
+	}
+}
+
+void SimulationTrace::Start(size_t maxEventsPerThread /* = DefaultMaxEventsPerThread */)
+{
+	TraceRegistry& registry = GetRegistry();
+	registry.MaxEventsPerThread.store(maxEventsPerThread, std::memory_order_relaxed);
+	{
+		std::lock_guard<std::mutex> lock(registry.Mutex);
+		for (std::unique_ptr<ThreadBuffer>& buffer : registry.Buffers)
+		{
+			std::lock_guard<std::mutex> bufferLock(buffer->Mutex);
+			buffer->Events.clear();
+			buffer->NumDropped = 0;
+		}
+		registry.StartNanoseconds = GetNowNanoseconds();
+	}
+
+	GetRecordingFlag().store(true, std::memory_order_relaxed);
+}
+
+void SimulationTrace::Stop()
+{
+	GetRecordingFlag().store(false, std::memory_order_relaxed);
+}
+
+/*
+* Every marker is a complete ("X") event, so a scope is one record however deeply scopes nest. Thread names are metadata ("M") events.
+*/
+bool SimulationTrace::WriteChromeJson(const std::string& path, std::string& outError)
+{
+	BufferedFileWriter writer;
+	if (!writer.Open(path))
+	{
+		outError = "unable to open " + path;
+		return false;
+	}
+
+	TraceRegistry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.Mutex);
+
+	writer.Write(std::string("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"));
+	bool firstEvent = true;
+	for (std::unique_ptr<ThreadBuffer>& buffer : registry.Buffers)
+	{
+		std::lock_guard<std::mutex> bufferLock(buffer->Mutex);
+		if (buffer->Events.empty())
+		{
+			continue;
+		}
+
+		if (buffer->ThreadName)
+		{
+			writer.WriteFormatted("%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", firstEvent ? "" : ",\n",
+								  buffer->ThreadId, buffer->ThreadName);
+			firstEvent = false;
+		}
+
+		for (const TraceEvent& event : buffer->Events)
+		{
+			// Timestamps are in microseconds, kept to the nanosecond.
+			writer.WriteFormatted("%s{\"name\":\"%s\",\"cat\":\"simulation\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", firstEvent ? "" : ",\n",
+								  event.Name, buffer->ThreadId, (event.StartNanoseconds - registry.StartNanoseconds) / 1000.0, event.DurationNanoseconds / 1000.0);
+			firstEvent = false;
+		}
+	}
+	writer.Write(std::string("\n]}\n"));
+
+	if (!writer.Close())
+	{
+		outError = "unable to write " + path;
+		return false;
+	}
+	return true;
+}
+
+uint64_t SimulationTrace::GetNumDropped()
+{
+	TraceRegistry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.Mutex);
+
+	uint64_t numDropped = 0;
+	for (std::unique_ptr<ThreadBuffer>& buffer : registry.Buffers)
+	{
+		std::lock_guard<std::mutex> bufferLock(buffer->Mutex);
+		numDropped += buffer->NumDropped;
+	}
+
+	return numDropped;
+}
+
+void SimulationTrace::SetThreadName(const char* name)
+{
+	ThreadBuffer& buffer = GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(buffer.Mutex);
+	buffer.ThreadName = name;
+}
+
+void SimulationTrace::RecordEvent(const char* name, int64_t startNanoseconds, int64_t endNanoseconds)
+{
+	ThreadBuffer& buffer = GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(buffer.Mutex);
+	if (buffer.Events.size() >= GetRegistry().MaxEventsPerThread.load(std::memory_order_relaxed))
+	{
+		++buffer.NumDropped;
+		return;
+	}
+
+	TraceEvent event;
+	event.Name = name;
+	event.StartNanoseconds = startNanoseconds;
+	event.DurationNanoseconds = endNanoseconds - startNanoseconds;
+	buffer.Events.push_back(event);
+}
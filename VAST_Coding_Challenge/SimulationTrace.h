@@ -0,0 +1,97 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+* Timeline tracing: scoped markers around the phases of a tick, station processing, dispatch, spawning and teardown, written out as a Chrome
+* trace (JSON) to open in chrome://tracing or ui.perfetto.dev.
+*
+* Markers are only compiled in when VAST_ENABLE_TRACING is defined to 1. Otherwise TRACE_SCOPE and TRACE_THREAD_NAME expand to nothing, so
+* a normal build pays nothing for them. When compiled in, a marker outside Start() / Stop() costs one relaxed load.
+*
+* Each thread records into a buffer of its own, so threads never contend, and shards and spawn workers show up as separate tracks.
+* Marker and thread names must be string literals: only the pointer is kept.
+*/
+#ifndef VAST_ENABLE_TRACING
+#define VAST_ENABLE_TRACING 0
+#endif
+
+namespace SimulationTrace
+{
+	// Events a thread records before it starts dropping them, unless Start() is given a limit sized for the run.
+	constexpr size_t DefaultMaxEventsPerThread = 1 << 20;
+
+	// Clears anything recorded before and starts recording. Times in the trace are relative to this call.
+	// A thread stops recording (and counts what it drops) once its buffer holds maxEventsPerThread events. Buffers grow as events are
+	// recorded, so a generous limit costs nothing until it's used.
+	void Start(size_t maxEventsPerThread = DefaultMaxEventsPerThread);
+	void Stop();
+
+	// Call once the traced threads are done (or idle). Returns false if the file can't be opened.
+	bool WriteChromeJson(const std::string& path, std::string& outError);
+
+	// Events dropped because a thread's buffer was full, since Start().
+	uint64_t GetNumDropped();
+
+	void SetThreadName(const char* name);
+	void RecordEvent(const char* name, int64_t startNanoseconds, int64_t endNanoseconds);
+
+	inline std::atomic<bool>& GetRecordingFlag()
+	{
+		static std::atomic<bool> recording{ false };
+		return recording;
+	}
+
+	inline bool IsRecording()
+	{
+		return GetRecordingFlag().load(std::memory_order_relaxed);
+	}
+
+	inline int64_t GetNowNanoseconds()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+}
+
+#if VAST_ENABLE_TRACING
+
+// Records the time from its construction to the end of its scope.
+class TraceScope
+{
+public:
+	explicit TraceScope(const char* name)
+		: Name(SimulationTrace::IsRecording() ? name : nullptr)
+		, StartNanoseconds(Name ? SimulationTrace::GetNowNanoseconds() : 0)
+	{
+	}
+
+	~TraceScope()
+	{
+		if (Name)
+		{
+			SimulationTrace::RecordEvent(Name, StartNanoseconds, SimulationTrace::GetNowNanoseconds());
+		}
+	}
+
+	TraceScope(const TraceScope&) = delete;
+	TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+	const char* Name;
+	int64_t StartNanoseconds;
+};
+
+#define VAST_TRACE_CONCAT_INNER(a, b) a##b
+#define VAST_TRACE_CONCAT(a, b) VAST_TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope VAST_TRACE_CONCAT(traceScope, __LINE__)(name)
+#define TRACE_THREAD_NAME(name) SimulationTrace::SetThreadName(name)
+
+#else
+
+#define TRACE_SCOPE(name) do {} while (0)
+#define TRACE_THREAD_NAME(name) do {} while (0)
+
+#endif
@@ -0,0 +1,331 @@
+#include "StationCountOptimizer.h"
+#include "MiningTruckController.h"
+
+#include <algorithm>
+
+namespace
+{
+	// Room left for the simulation's one second ticks when comparing against the model's upper bound, so rounding never prunes a candidate
+	// that could reach the target.
+	constexpr float UpperBoundSlack = 0.01f;
+}
+
+/*
+* Runs the search selected by settings.Goal.
+*/
+StationOptimizerResult StationCountOptimizer::Optimize(const SimulationConfiguration& baseConfiguration, const StationOptimizerSettings& settings)
+{
+	if (settings.Goal == EStationOptimizerGoal::TargetEfficiency)
+	{
+		return FindTargetEfficiency(baseConfiguration, settings);
+	}
+
+	return FindMarginalGain(baseConfiguration, settings);
+}
+
+/*
+* For each fleet size, bisects the station range for the fewest stations that reach the target.
+* The best answer is the fewest stations overall, then the smallest fleet.
+*/
+StationOptimizerResult StationCountOptimizer::FindTargetEfficiency(const SimulationConfiguration& baseConfiguration, const StationOptimizerSettings& settings)
+{
+	StationOptimizerResult result;
+	std::vector<unsigned int> fleetSizes = GetFleetSizes(baseConfiguration, settings);
+	unsigned int minStations = std::max(1u, settings.MinUnloadingLocations);
+	unsigned int maxStations = std::max(minStations, settings.MaxUnloadingLocations);
+
+	result.FullGridSimulatedSeconds = static_cast<double>(baseConfiguration.SimulationMaxTimeSeconds) * fleetSizes.size() * (maxStations - minStations + 1);
+
+	for (unsigned int fleetSize : fleetSizes)
+	{
+		SimulationConfiguration configuration = baseConfiguration;
+		configuration.NumMiningTrucksToSpawn = static_cast<int>(fleetSize);
+		configuration.LogSimulationTime = false;
+
+		// Station counts that can't reach the target even in the best case are skipped without a trial.
+		unsigned int low = minStations;
+		unsigned int guess = maxStations;
+		if (settings.PruneWithQueueingModel)
+		{
+			low = FindFewestStations(configuration, minStations, maxStations, settings.TargetEfficiency, true);
+			guess = FindFewestStations(configuration, low, maxStations, settings.TargetEfficiency, false);
+			result.NumCandidatesPruned += low - minStations;
+			if (low > maxStations)
+			{
+				continue;
+			}
+		}
+
+		// If the most stations can't reach the target, no station count in the range can.
+		float efficiency = 0.0f;
+		configuration.NumUnloadingLocationsToSpawn = static_cast<int>(maxStations);
+		if (!RunTargetTrial(configuration, settings, efficiency, result))
+		{
+			continue;
+		}
+
+		// The first two probes are the model's answer and its neighbour, which settles the search straight away when the model is right.
+		// After that (or without the model) it is plain bisection.
+		unsigned int high = maxStations;
+		unsigned int numGuidedProbes = settings.PruneWithQueueingModel ? 2 : 0;
+		float highEfficiency = efficiency;
+		while (low < high)
+		{
+			unsigned int middle = low + (high - low) / 2;
+			if (numGuidedProbes > 0 && guess >= low && guess < high)
+			{
+				middle = guess;
+				--numGuidedProbes;
+			}
+
+			configuration.NumUnloadingLocationsToSpawn = static_cast<int>(middle);
+			if (RunTargetTrial(configuration, settings, efficiency, result))
+			{
+				high = middle;
+				highEfficiency = efficiency;
+				guess = middle - 1;
+			}
+			else
+			{
+				low = middle + 1;
+				guess = middle + 1;
+			}
+		}
+
+		if (!result.Found || high < result.NumUnloadingLocations)
+		{
+			result.Found = true;
+			result.NumUnloadingLocations = high;
+			result.NumMiningTrucks = fleetSize;
+			result.GlobalEfficiency = highEfficiency;
+		}
+	}
+
+	return result;
+}
+
+/*
+* Successive halving over every (fleet size, station count) candidate.
+*/
+StationOptimizerResult StationCountOptimizer::FindMarginalGain(const SimulationConfiguration& baseConfiguration, const StationOptimizerSettings& settings)
+{
+	StationOptimizerResult result;
+	std::vector<unsigned int> fleetSizes = GetFleetSizes(baseConfiguration, settings);
+	unsigned int minStations = std::max(1u, settings.MinUnloadingLocations);
+	unsigned int maxStations = std::max(minStations, settings.MaxUnloadingLocations);
+	double maxTime = baseConfiguration.SimulationMaxTimeSeconds;
+
+	std::vector<Trial> trials;
+	for (unsigned int fleetSize : fleetSizes)
+	{
+		for (unsigned int numStations = minStations; numStations <= maxStations; ++numStations)
+		{
+			Trial trial;
+			trial.Configuration = baseConfiguration;
+			trial.Configuration.NumMiningTrucksToSpawn = static_cast<int>(fleetSize);
+			trial.Configuration.NumUnloadingLocationsToSpawn = static_cast<int>(numStations);
+			trial.Configuration.LogSimulationTime = false;
+			trial.Score = GetScore(trial.Configuration, Estimator.Estimate(trial.Configuration).GlobalEfficiency, settings);
+			trials.push_back(std::move(trial));
+		}
+	}
+
+	result.FullGridSimulatedSeconds = maxTime * trials.size();
+
+	// Candidates the model already scores well behind the best are dropped before any of them is simulated.
+	if (settings.PruneWithQueueingModel && !trials.empty())
+	{
+		double bestEstimatedScore = std::max_element(trials.begin(), trials.end(), [](const Trial& lhs, const Trial& rhs) {
+			return lhs.Score < rhs.Score;
+		})->Score;
+
+		size_t numTrials = trials.size();
+		trials.erase(std::remove_if(trials.begin(), trials.end(), [&](const Trial& trial) {
+			return trial.Score < bestEstimatedScore - settings.QueueingModelPruningMargin;
+		}), trials.end());
+		result.NumCandidatesPruned += static_cast<unsigned int>(numTrials - trials.size());
+	}
+
+	for (Trial& trial : trials)
+	{
+		trial.Controller.reset(new MiningTruckController());
+		trial.Controller->StartSimulation(trial.Configuration);
+	}
+
+	result.NumTrials = static_cast<unsigned int>(trials.size());
+
+	// The first round's simulation time saved by pruning is spent running the survivors for longer, where short runs are least reliable.
+	double trialTime = maxTime * std::min(1.0f, std::max(settings.InitialTrialFraction, 0.0f));
+	if (!trials.empty())
+	{
+		trialTime *= static_cast<double>(result.FullGridSimulatedSeconds / maxTime) / trials.size();
+	}
+	while (!trials.empty())
+	{
+		trialTime = std::min(std::max(trialTime, 1.0), maxTime);
+		for (Trial& trial : trials)
+		{
+			result.SimulatedSeconds += AdvanceTrial(trial, trialTime);
+			trial.GlobalEfficiency = trial.Controller->GetMiningEfficiency();
+			trial.Score = GetScore(trial.Configuration, trial.GlobalEfficiency, settings);
+		}
+
+		std::stable_sort(trials.begin(), trials.end(), [](const Trial& lhs, const Trial& rhs) {
+			return lhs.Score > rhs.Score;
+		});
+
+		if (trials.size() == 1 || trialTime >= maxTime)
+		{
+			break;
+		}
+
+		// Drop the worse half. Those trials never run to the full simulation time.
+		size_t numSurvivors = (trials.size() + 1) / 2;
+		for (size_t i = numSurvivors; i < trials.size(); ++i)
+		{
+			trials[i].Controller->Teardown();
+			++result.NumTrialsStoppedEarly;
+		}
+		trials.resize(numSurvivors);
+		trialTime *= 2.0;
+	}
+
+	if (!trials.empty())
+	{
+		// The last candidate standing is only known to be best, it doesn't need to finish its run.
+		result.Found = true;
+		result.NumUnloadingLocations = trials.front().Configuration.NumUnloadingLocationsToSpawn;
+		result.NumMiningTrucks = trials.front().Configuration.NumMiningTrucksToSpawn;
+		result.GlobalEfficiency = trials.front().GlobalEfficiency;
+		for (Trial& trial : trials)
+		{
+			if (!trial.Finished)
+			{
+				++result.NumTrialsStoppedEarly;
+			}
+			trial.Controller->Teardown();
+		}
+	}
+
+	return result;
+}
+
+/*
+* Simulates one configuration, checking every TrialCheckIntervalSeconds whether the target is already guaranteed or already out of reach.
+* Final efficiency = total unloaded / total time, so with U unloaded after t of T seconds and at most one truck per station unloading at a time:
+*     U / T <= final efficiency <= (U + (T - t) * min(stations, trucks)) / T
+*/
+bool StationCountOptimizer::RunTargetTrial(const SimulationConfiguration& configuration, const StationOptimizerSettings& settings, float& outEfficiency, StationOptimizerResult& result)
+{
+	Trial trial;
+	trial.Configuration = configuration;
+	trial.Controller.reset(new MiningTruckController());
+	trial.Controller->StartSimulation(configuration);
+	++result.NumTrials;
+
+	double maxTime = configuration.SimulationMaxTimeSeconds;
+	double maxUnloadRate = std::min(configuration.NumUnloadingLocationsToSpawn, configuration.NumMiningTrucksToSpawn);
+	double checkInterval = std::max(settings.TrialCheckIntervalSeconds, 1.0f);
+	double elapsedTime = 0.0;
+	bool reachesTarget = false;
+
+	while (true)
+	{
+		result.SimulatedSeconds += AdvanceTrial(trial, std::min(elapsedTime + checkInterval, maxTime));
+		elapsedTime = maxTime - trial.Controller->GetGlobalRemainingTime();
+
+		double unloaded = trial.Controller->GetMiningEfficiency() * elapsedTime;
+		outEfficiency = static_cast<float>(unloaded / maxTime);
+
+		if (trial.Finished)
+		{
+			reachesTarget = outEfficiency >= settings.TargetEfficiency;
+			break;
+		}
+
+		if (unloaded / maxTime >= settings.TargetEfficiency)
+		{
+			reachesTarget = true;
+			++result.NumTrialsStoppedEarly;
+			break;
+		}
+
+		if ((unloaded + (maxTime - elapsedTime) * maxUnloadRate) / maxTime < settings.TargetEfficiency)
+		{
+			reachesTarget = false;
+			++result.NumTrialsStoppedEarly;
+			break;
+		}
+	}
+
+	trial.Controller->Teardown();
+	return reachesTarget;
+}
+
+/*
+* Ticks a trial's simulation until elapsedSeconds of simulation time have passed, or its simulation time runs out.
+*/
+double StationCountOptimizer::AdvanceTrial(Trial& trial, double elapsedSeconds)
+{
+	double maxTime = trial.Configuration.SimulationMaxTimeSeconds;
+	double startTime = maxTime - trial.Controller->GetGlobalRemainingTime();
+	double elapsedTime = startTime;
+	while (!trial.Finished && elapsedTime < elapsedSeconds)
+	{
+		trial.Finished = trial.Controller->Tick(1.0f);
+		elapsedTime = maxTime - trial.Controller->GetGlobalRemainingTime();
+	}
+
+	return elapsedTime - startTime;
+}
+
+/*
+* Fleet sizes to search, or just the base configuration's fleet size.
+*/
+std::vector<unsigned int> StationCountOptimizer::GetFleetSizes(const SimulationConfiguration& baseConfiguration, const StationOptimizerSettings& settings) const
+{
+	if (settings.FleetSizes.empty())
+	{
+		return std::vector<unsigned int>(1, static_cast<unsigned int>(std::max(1, baseConfiguration.NumMiningTrucksToSpawn)));
+	}
+
+	return settings.FleetSizes;
+}
+
+/*
+* MarginalGain score: efficiency minus the marginal gain each of the candidate's stations and trucks must pay for.
+*/
+double StationCountOptimizer::GetScore(const SimulationConfiguration& configuration, float globalEfficiency, const StationOptimizerSettings& settings) const
+{
+	return globalEfficiency -
+		   settings.MinMarginalGainPerStation * configuration.NumUnloadingLocationsToSpawn -
+		   settings.MinMarginalGainPerTruck * configuration.NumMiningTrucksToSpawn;
+}
+
+/*
+* Fewest stations in [minStations, maxStations] whose efficiency upper bound (or estimate) reaches the target, or maxStations + 1 if none does.
+* Both only go up as stations are added, so this is a bisection too, over the model instead of over trials.
+*/
+unsigned int StationCountOptimizer::FindFewestStations(SimulationConfiguration configuration, unsigned int minStations, unsigned int maxStations,
+													   float targetEfficiency, bool upperBound)
+{
+	unsigned int low = minStations;
+	unsigned int high = maxStations + 1;
+	while (low < high)
+	{
+		unsigned int middle = low + (high - low) / 2;
+		configuration.NumUnloadingLocationsToSpawn = static_cast<int>(middle);
+		float efficiency = upperBound ? QueueingModelEstimator::GetEfficiencyUpperBound(configuration) * (1.0f + UpperBoundSlack)
+									  : Estimator.Estimate(configuration).GlobalEfficiency;
+		if (efficiency >= targetEfficiency)
+		{
+			high = middle;
+		}
+		else
+		{
+			low = middle + 1;
+		}
+	}
+
+	return low;
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include "Global.h"
+#include "QueueingModelEstimator.h"
+
+#include <memory>
+#include <vector>
+
+class MiningTruckController;
+
+enum class EStationOptimizerGoal : size_t
+{
+	TargetEfficiency,	// Find the fewest Unloading Stations that reach a target global efficiency.
+	MarginalGain		// Keep adding Unloading Stations (or trucks) while each one still improves global efficiency by enough.
+};
+
+struct StationOptimizerSettings
+{
+	EStationOptimizerGoal Goal = EStationOptimizerGoal::MarginalGain;
+
+	// TargetEfficiency goal.
+	float TargetEfficiency = 1.0f;
+
+	// MarginalGain goal. A station (or truck) is only worth adding if it raises global efficiency by more than this.
+	float MinMarginalGainPerStation = 0.05f;
+	float MinMarginalGainPerTruck = 0.0f;
+
+	unsigned int MinUnloadingLocations = 1;
+	unsigned int MaxUnloadingLocations = 16;
+
+	// Fleet sizes to search as well. Empty searches only the fleet size of the base configuration.
+	std::vector<unsigned int> FleetSizes;
+
+	// MarginalGain goal: the first round of trials runs for this fraction of SimulationMaxTimeSeconds, each later round for twice as long.
+	float InitialTrialFraction = 0.125f;
+
+	// How often (in simulation seconds) a running TargetEfficiency trial checks whether its outcome is already decided.
+	float TrialCheckIntervalSeconds = 600.0f;
+
+	// Uses the queueing model (see QueueingModelEstimator) to skip candidates before simulating them.
+	// TargetEfficiency: candidates whose efficiency upper bound misses the target are never run, and bisection first tries the station count
+	// the model predicts. That only changes which trials run, not the answer.
+	// MarginalGain: candidates whose estimated score is more than QueueingModelPruningMargin below the best estimated score are never run,
+	// and the survivors' first round runs for longer in proportion.
+	bool PruneWithQueueingModel = true;
+	float QueueingModelPruningMargin = 0.1f;
+};
+
+struct StationOptimizerResult
+{
+	bool Found = false;
+	unsigned int NumUnloadingLocations = 0;
+	unsigned int NumMiningTrucks = 0;
+
+	// If the chosen configuration's trial was stopped early, this is the efficiency it had already guaranteed (or reached so far) at that point.
+	float GlobalEfficiency = 0.0f;
+
+	// Cost of the search, compared to simulating every candidate for the full simulation time.
+	unsigned int NumTrials = 0;
+	unsigned int NumTrialsStoppedEarly = 0;
+	unsigned int NumCandidatesPruned = 0;
+	double SimulatedSeconds = 0.0;
+	double FullGridSimulatedSeconds = 0.0;
+
+	void Print()
+	{
+		if (!Found)
+		{
+			std::cout << "No configuration met the goal." << std::endl;
+		}
+		else
+		{
+			std::cout << "Unloading Stations: " << NumUnloadingLocations << " Mining Trucks: " << NumMiningTrucks << " efficiency: " << GlobalEfficiency << std::endl;
+		}
+
+		std::cout << "Trials: " << NumTrials << " (" << NumTrialsStoppedEarly << " stopped early, " << NumCandidatesPruned
+				  << " candidates pruned by the queueing model), simulated " << SimulatedSeconds
+				  << " seconds vs " << FullGridSimulatedSeconds << " seconds for the full grid." << std::endl;
+	}
+};
+
+/*
+* Searches NumUnloadingLocationsToSpawn (and optionally the fleet size) instead of finding the point of diminishing returns by manual trial.
+*
+* TargetEfficiency: bisection over the station count (efficiency only goes up as stations are added).
+* A trial stops as soon as its outcome is certain: once the Helium-3 already unloaded guarantees the target, or once even every station unloading
+* non-stop for the rest of the run couldn't reach it.
+*
+* MarginalGain: successive halving. Every candidate is simulated for a short time, the worse half is dropped, and the survivors continue
+* (from where they stopped, not from the start) for twice as long, until one candidate is left or the full simulation time is reached.
+* Candidates are scored by efficiency minus the marginal gain each of their stations and trucks must pay for.
+*
+* Both searches first ask the queueing model (which costs microseconds per candidate) which candidates are worth simulating at all.
+*/
+class StationCountOptimizer
+{
+public:
+	StationCountOptimizer() = default;
+	~StationCountOptimizer() = default;
+
+	StationOptimizerResult Optimize(const SimulationConfiguration& baseConfiguration, const StationOptimizerSettings& settings);
+
+private:
+	struct Trial
+	{
+		SimulationConfiguration Configuration;
+		std::unique_ptr<MiningTruckController> Controller;
+		float GlobalEfficiency = 0.0f;
+		double Score = 0.0;
+		bool Finished = false;
+	};
+
+	StationOptimizerResult FindTargetEfficiency(const SimulationConfiguration& baseConfiguration, const StationOptimizerSettings& settings);
+	StationOptimizerResult FindMarginalGain(const SimulationConfiguration& baseConfiguration, const StationOptimizerSettings& settings);
+
+	// Runs one TargetEfficiency trial. Returns true if the configuration reaches the target.
+	bool RunTargetTrial(const SimulationConfiguration& configuration, const StationOptimizerSettings& settings, float& outEfficiency, StationOptimizerResult& result);
+
+	// Advances a trial until elapsedSeconds of simulation time have passed (or the trial finishes), returning the simulated seconds used.
+	double AdvanceTrial(Trial& trial, double elapsedSeconds);
+
+	std::vector<unsigned int> GetFleetSizes(const SimulationConfiguration& baseConfiguration, const StationOptimizerSettings& settings) const;
+
+	double GetScore(const SimulationConfiguration& configuration, float globalEfficiency, const StationOptimizerSettings& settings) const;
+
+	// Fewest stations in the range whose queueing model upper bound (or estimate) reaches the target. maxStations + 1 if none does.
+	unsigned int FindFewestStations(SimulationConfiguration configuration, unsigned int minStations, unsigned int maxStations, float targetEfficiency, bool upperBound);
+
+	QueueingModelEstimator Estimator;
+};
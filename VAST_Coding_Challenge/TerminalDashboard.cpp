@@ -0,0 +1,204 @@
+#include "TerminalDashboard.h"
+
+#include <cstdarg>
+#include <cstdio>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
+#define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004
+#endif
+#endif
+
+constexpr unsigned int TerminalDashboard::MaxUnloadingLocationRows;
+
+// Width every row is padded to, so a shorter value always overwrites a longer one.
+constexpr size_t FrameWidth = 64;
+
+TerminalDashboard::~TerminalDashboard()
+{
+	Stop();
+}
+
+void TerminalDashboard::Start(float framesPerSecond /* = 10.0f */)
+{
+#ifdef _WIN32
+	// Windows consoles only interpret escape sequences once asked to.
+	HANDLE outputHandle = GetStdHandle(STD_OUTPUT_HANDLE);
+	DWORD consoleMode = 0;
+	if (outputHandle != INVALID_HANDLE_VALUE && GetConsoleMode(outputHandle, &consoleMode))
+	{
+		SetConsoleMode(outputHandle, consoleMode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+	}
+#endif
+
+	if (framesPerSecond <= 0.0f)
+	{
+		framesPerSecond = 10.0f;
+	}
+	FrameInterval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / framesPerSecond));
+	NextFrameTime = Clock::now();
+
+	Rows.clear();
+	DisplayedRows.clear();
+	Started = true;
+
+	// Clear the screen once and hide the cursor. From here on only changed cells are written.
+	fputs("\x1b[2J\x1b[?25l", stdout);
+	fflush(stdout);
+}
+
+/*
+* Only reads the clock unless a frame is due, so calling this after every tick costs next to nothing.
+*/
+void TerminalDashboard::Update(const MiningTruckController& controller)
+{
+	if (!Started)
+	{
+		return;
+	}
+
+	Clock::time_point now = Clock::now();
+	if (now < NextFrameTime)
+	{
+		return;
+	}
+
+	// Schedule from now rather than the missed deadline, so a slow frame doesn't cause a burst of catch up frames.
+	NextFrameTime = now + FrameInterval;
+	Draw(controller);
+}
+
+void TerminalDashboard::Draw(const MiningTruckController& controller)
+{
+	if (!Started)
+	{
+		return;
+	}
+
+	controller.GetSimulationStatus(Status);
+	BuildFrame(Status);
+	WriteChangedCells();
+}
+
+void TerminalDashboard::Stop()
+{
+	if (!Started)
+	{
+		return;
+	}
+
+	Started = false;
+	fprintf(stdout, "\x1b[%u;1H\x1b[?25h\n", static_cast<unsigned int>(DisplayedRows.size() + 1));
+	fflush(stdout);
+}
+
+/*
+* Lays out the frame: simulation time, fleet states, and one row per Unloading Location.
+*/
+void TerminalDashboard::BuildFrame(const SimulationStatus& status)
+{
+	Rows.clear();
+
+	AddRow("Helium-3 Mining Simulation");
+	AddRow("Elapsed %9.0f s   Remaining %9.0f s   Speed %6.0fx", status.ElapsedSeconds, status.RemainingSeconds, status.PlaybackSpeed);
+	AddRow("Global Efficiency %.4f", status.GlobalEfficiency);
+	AddRow("");
+
+	auto trucksIn = [&status](EMiningTruckState state) {
+		return status.NumMiningTrucksInState[static_cast<size_t>(state)];
+	};
+
+	AddRow("Mining Trucks: %u", status.NumMiningTrucks);
+	AddRow("  Idle %6u   To Mine %6u   Mining %6u   To Unload %6u",
+		   trucksIn(EMiningTruckState::Idle), trucksIn(EMiningTruckState::MovingToMiningLocation),
+		   trucksIn(EMiningTruckState::Mining), trucksIn(EMiningTruckState::MovingToUnloadingLocation));
+	AddRow("  Queued %6u   Docking %6u   Unloading %6u",
+		   trucksIn(EMiningTruckState::InUnloadingQueue), trucksIn(EMiningTruckState::TransitioningToUnload),
+		   trucksIn(EMiningTruckState::Unloading));
+	AddRow("");
+
+	AddRow("Station  State       Queue   Queue Time   Efficiency");
+	unsigned int numUnloadingLocations = static_cast<unsigned int>(status.UnloadingLocations.size());
+	for (unsigned int i = 0; i < numUnloadingLocations && i < MaxUnloadingLocationRows; ++i)
+	{
+		const UnloadingLocationStatus& unloadingLocation = status.UnloadingLocations[i];
+		AddRow("%7u  %-10s %6u %10.0f s %12.4f", i,
+			   unloadingLocation.State == EUnloadingLocationState::Unloading ? "Unloading" : "Idle",
+			   unloadingLocation.QueueLength, unloadingLocation.QueueTimeSeconds, unloadingLocation.Efficiency);
+	}
+
+	if (numUnloadingLocations > MaxUnloadingLocationRows)
+	{
+		AddRow("  ... and %u more stations", numUnloadingLocations - MaxUnloadingLocationRows);
+	}
+}
+
+/*
+* Formats one row, cut or padded with spaces to FrameWidth.
+*/
+void TerminalDashboard::AddRow(const char* format, ...)
+{
+	char row[FrameWidth + 1];
+
+	va_list arguments;
+	va_start(arguments, format);
+	int length = vsnprintf(row, sizeof(row), format, arguments);
+	va_end(arguments);
+
+	size_t rowLength = length < 0 ? 0 : (static_cast<size_t>(length) < FrameWidth ? static_cast<size_t>(length) : FrameWidth);
+	Rows.emplace_back(row, rowLength);
+	Rows.back().resize(FrameWidth, ' ');
+}
+
+/*
+* Compares the new frame with the one on screen. For each row that changed, the cursor is moved to the first changed column and only the span
+* up to the last changed column is written. Rows that no longer exist are blanked. Everything goes out in a single write.
+*/
+void TerminalDashboard::WriteChangedCells()
+{
+	static const std::string blankRow(FrameWidth, ' ');
+
+	Output.clear();
+	size_t numRows = Rows.size() > DisplayedRows.size() ? Rows.size() : DisplayedRows.size();
+	for (size_t rowIndex = 0; rowIndex < numRows; ++rowIndex)
+	{
+		const std::string& row = rowIndex < Rows.size() ? Rows[rowIndex] : blankRow;
+
+		size_t firstChanged = 0;
+		size_t lastChanged = FrameWidth - 1;
+		if (rowIndex < DisplayedRows.size())
+		{
+			const std::string& displayedRow = DisplayedRows[rowIndex];
+			while (firstChanged < FrameWidth && row[firstChanged] == displayedRow[firstChanged])
+			{
+				++firstChanged;
+			}
+
+			if (firstChanged == FrameWidth)
+			{
+				// Row unchanged.
+				continue;
+			}
+
+			while (row[lastChanged] == displayedRow[lastChanged])
+			{
+				--lastChanged;
+			}
+		}
+
+		char cursorMove[32];
+		snprintf(cursorMove, sizeof(cursorMove), "\x1b[%u;%uH", static_cast<unsigned int>(rowIndex + 1), static_cast<unsigned int>(firstChanged + 1));
+		Output += cursorMove;
+		Output.append(row, firstChanged, lastChanged - firstChanged + 1);
+	}
+
+	DisplayedRows.swap(Rows);
+
+	if (!Output.empty())
+	{
+		fwrite(Output.data(), 1, Output.size(), stdout);
+		fflush(stdout);
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "MiningTruckController.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+/*
+* Live view of an interactive simulation, drawn with ANSI escape sequences.
+*
+* The dashboard keeps the last frame it drew. Each new frame is compared with it row by row, and only the changed span of each row is rewritten,
+* all in one buffered write, so the terminal is never cleared and nothing flickers. Frames are rate limited independently of the tick rate,
+* so Update() can be called after every tick at any playback speed.
+*/
+class TerminalDashboard
+{
+public:
+	TerminalDashboard() = default;
+	~TerminalDashboard();
+
+	// Prepares the terminal (enables escape sequences on Windows consoles, clears the screen once, and hides the cursor).
+	void Start(float framesPerSecond = 10.0f);
+
+	// Draws a frame if one is due.
+	void Update(const MiningTruckController& controller);
+
+	// Draws a frame now.
+	void Draw(const MiningTruckController& controller);
+
+	// Restores the cursor below the last frame, so normal output can follow.
+	void Stop();
+
+	// Station rows shown before the rest are summarized in one line.
+	static constexpr unsigned int MaxUnloadingLocationRows = 16;
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	void BuildFrame(const SimulationStatus& status);
+	void AddRow(const char* format, ...);
+	void WriteChangedCells();
+
+	bool Started = false;
+	Clock::duration FrameInterval = std::chrono::milliseconds(100);
+	Clock::time_point NextFrameTime;
+
+	SimulationStatus Status;
+
+	// Rows of the frame being built, and of the frame currently on screen. Every row is padded to FrameWidth.
+	std::vector<std::string> Rows;
+	std::vector<std::string> DisplayedRows;
+	std::string Output;
+};
@@ -0,0 +1,224 @@
+#include "UnloadingDispatcher.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+	// Coordinate given to empty station slots. Distances to it overflow to infinity, so any real station is nearer.
+	constexpr float UnreachablePosition = std::numeric_limits<float>::max();
+}
+
+/*
+* Forgets every station and every cached nearest station, and sets the strategy used to pick stations from now on.
+*/
+void UnloadingDispatcher::Reset(EUnloadingDispatchStrategy strategy, float travelSpeed)
+{
+	Strategy = strategy;
+	TravelSpeed = travelSpeed > 0.0f ? travelSpeed : 0.0f;
+	Stations.clear();
+	StationPositions.clear();
+	StationsByAvailableAt.clear();
+	NearestStations.clear();
+}
+
+/*
+* Adds a station to the index. Stations start idle.
+*/
+void UnloadingDispatcher::AddUnloadingLocation(UnloadingLocation* unloadingLocation)
+{
+	if (!unloadingLocation)
+	{
+		return;
+	}
+
+	uint32_t stationIndex = unloadingLocation->GetHandle().Index;
+	if (stationIndex >= Stations.size())
+	{
+		Stations.resize(stationIndex + 1);
+		StationPositions.resize(stationIndex + 1, Vector4(UnreachablePosition, UnreachablePosition, UnreachablePosition));
+	}
+
+	Stations[stationIndex].Location = unloadingLocation;
+	Stations[stationIndex].AvailableAt = 0;
+	StationPositions[stationIndex] = Vector4(unloadingLocation->GetLocation());
+	StationsByAvailableAt.emplace(0, stationIndex);
+
+	// A new station can be nearer than the cached ones.
+	NearestStations.clear();
+}
+
+/*
+* Picks a station with the configured strategy, then books the truck onto it: the truck starts unloading once it has arrived and the station is free.
+*/
+UnloadingLocation* UnloadingDispatcher::Dispatch(MiningLocation* miningLocation, SimulationTime now, SimulationTime unloadingTime)
+{
+	if (!miningLocation || StationsByAvailableAt.empty())
+	{
+		return nullptr;
+	}
+
+	uint32_t selectedIndex = 0;
+	switch (Strategy)
+	{
+	case EUnloadingDispatchStrategy::Nearest:
+		selectedIndex = FindNearestStation(miningLocation).StationIndex;
+		break;
+	case EUnloadingDispatchStrategy::EarliestUnloadStart:
+		selectedIndex = FindEarliestUnloadStart(miningLocation, now);
+		break;
+	case EUnloadingDispatchStrategy::ShortestQueue:
+	default:
+		// The station that is free soonest is the one with the least unloading work queued.
+		selectedIndex = StationsByAvailableAt.begin()->second;
+		break;
+	}
+
+	DispatchStation& selectedStation = Stations[selectedIndex];
+	SimulationTime unloadStart = std::max(selectedStation.AvailableAt, now + EstimateTravelTime(miningLocation, selectedStation));
+	SetAvailableAt(selectedIndex, unloadStart + unloadingTime);
+
+	return selectedStation.Location;
+}
+
+/*
+* The station's actual queue is the ground truth, bookings only estimate it. An empty queue makes the station idle again.
+*/
+void UnloadingDispatcher::OnUnloadingFinished(UnloadingLocation* unloadingLocation, SimulationTime now)
+{
+	if (!unloadingLocation)
+	{
+		return;
+	}
+
+	uint32_t stationIndex = unloadingLocation->GetHandle().Index;
+	if (stationIndex >= Stations.size() || Stations[stationIndex].Location != unloadingLocation)
+	{
+		return;
+	}
+
+	SimulationTime queueTime = unloadingLocation->GetQueueTime();
+	SetAvailableAt(stationIndex, queueTime > 0 ? now + queueTime : 0);
+}
+
+/*
+* Shifting every busy station by the same amount keeps their order, so the index is rebuilt once rather than re-sorted.
+*/
+void UnloadingDispatcher::AdvanceTime(SimulationTime time)
+{
+	StationsByAvailableAt.clear();
+	for (uint32_t stationIndex = 0; stationIndex < Stations.size(); ++stationIndex)
+	{
+		DispatchStation& station = Stations[stationIndex];
+		if (!station.Location)
+		{
+			continue;
+		}
+
+		if (station.AvailableAt != 0)
+		{
+			station.AvailableAt += time;
+		}
+		StationsByAvailableAt.emplace_hint(StationsByAvailableAt.end(), station.AvailableAt, stationIndex);
+	}
+}
+
+/*
+* Projections are appended relative to now, so the same fleet state at two different times gives the same signature.
+*/
+void UnloadingDispatcher::AppendStateSignature(StateSignature& signature, SimulationTime now) const
+{
+	for (const DispatchStation& station : Stations)
+	{
+		if (station.Location)
+		{
+			signature.push_back(station.AvailableAt == 0 ? 0 : static_cast<uint64_t>(station.AvailableAt - now));
+		}
+	}
+}
+
+EUnloadingDispatchStrategy UnloadingDispatcher::GetStrategy() const
+{
+	return Strategy;
+}
+
+/*
+* Straight line travel time from a mining location to a station at the configured travel speed.
+*/
+SimulationTime UnloadingDispatcher::EstimateTravelTime(MiningLocation* miningLocation, const DispatchStation& station) const
+{
+	if (TravelSpeed <= 0.0f)
+	{
+		return 0;
+	}
+
+	float distance = Vector::Distance(miningLocation->GetLocation(), station.Location->GetLocation());
+	return SecondsToSimulationTime(distance / TravelSpeed);
+}
+
+/*
+* Returns the station closest to a mining location, working it out on the first request from that location.
+* Distances to every station are computed as one batch.
+*/
+const UnloadingDispatcher::NearestStation& UnloadingDispatcher::FindNearestStation(MiningLocation* miningLocation)
+{
+	MiningLocationHandle miningLocationHandle = miningLocation->GetHandle();
+	if (miningLocationHandle.Index >= NearestStations.size())
+	{
+		NearestStations.resize(miningLocationHandle.Index + 1);
+	}
+
+	NearestStation& nearestStation = NearestStations[miningLocationHandle.Index];
+	if (nearestStation.MiningLocation == miningLocationHandle)
+	{
+		return nearestStation;
+	}
+
+	nearestStation.StationIndex = static_cast<uint32_t>(VectorMath::FindNearest(StationPositions.data(), StationPositions.size(), Vector4(miningLocation->GetLocation())));
+
+	nearestStation.MiningLocation = miningLocationHandle;
+	nearestStation.TravelTime = EstimateTravelTime(miningLocation, Stations[nearestStation.StationIndex]);
+	return nearestStation;
+}
+
+/*
+* Finds the station where the truck can start unloading soonest: the later of its arrival (travel ETA) and the station becoming free.
+* Stations are visited in the order they become free. A station can't start the truck before it is free, and no station can start it before
+* it could reach the nearest one, so the walk stops as soon as either bound shows the rest of the index can't do better.
+*/
+uint32_t UnloadingDispatcher::FindEarliestUnloadStart(MiningLocation* miningLocation, SimulationTime now)
+{
+	const NearestStation& nearestStation = FindNearestStation(miningLocation);
+	SimulationTime earliestPossibleStart = now + nearestStation.TravelTime;
+
+	uint32_t selectedIndex = nearestStation.StationIndex;
+	SimulationTime selectedStart = std::max(Stations[selectedIndex].AvailableAt, earliestPossibleStart);
+
+	for (const std::pair<SimulationTime, uint32_t>& entry : StationsByAvailableAt)
+	{
+		if (selectedStart <= earliestPossibleStart || entry.first >= selectedStart)
+		{
+			break;
+		}
+
+		SimulationTime unloadStart = std::max(entry.first, now + EstimateTravelTime(miningLocation, Stations[entry.second]));
+		if (unloadStart < selectedStart)
+		{
+			selectedStart = unloadStart;
+			selectedIndex = entry.second;
+		}
+	}
+
+	return selectedIndex;
+}
+
+/*
+* Moves a station to its new position in the index.
+*/
+void UnloadingDispatcher::SetAvailableAt(uint32_t stationIndex, SimulationTime availableAt)
+{
+	DispatchStation& station = Stations[stationIndex];
+	StationsByAvailableAt.erase(std::make_pair(station.AvailableAt, stationIndex));
+	station.AvailableAt = availableAt;
+	StationsByAvailableAt.emplace(availableAt, stationIndex);
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "Global.h"
+#include "MiningLocation.h"
+#include "UnloadingLocation.h"
+#include "VectorMath.h"
+
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <utility>
+#include <vector>
+
+/*
+* Picks the Unloading Location a truck heads to once it has finished mining.
+*
+* Every station is kept in an ordered index keyed by the absolute simulation time it is projected to become free (AvailableAt).
+* Unlike the remaining queue time, an absolute time doesn't change as the simulation ticks, so the index only needs updating when a truck
+* is booked onto a station or a station finishes unloading a truck, and picking a station never scans the whole station list.
+* An AvailableAt of 0 means the station is idle; idle stations all share that key, so ties are broken by station slot, as a scan would.
+*/
+class UnloadingDispatcher
+{
+public:
+	UnloadingDispatcher() = default;
+
+	// Forgets every station and sets how stations are picked from now on.
+	void Reset(EUnloadingDispatchStrategy strategy, float travelSpeed);
+	void AddUnloadingLocation(UnloadingLocation* unloadingLocation);
+
+	// Picks a station for a truck leaving miningLocation at time now, and books the truck's unloading time onto it.
+	UnloadingLocation* Dispatch(MiningLocation* miningLocation, SimulationTime now, SimulationTime unloadingTime);
+
+	// Re-projects a station from its actual queue once it has finished unloading a truck. Keeps bookings from drifting away from the simulation.
+	void OnUnloadingFinished(UnloadingLocation* unloadingLocation, SimulationTime now);
+
+	// Moves every projection forward after simulation time was skipped by steady state extrapolation.
+	void AdvanceTime(SimulationTime time);
+
+	// Appends each station's projection, relative to now, to a steady state signature.
+	void AppendStateSignature(StateSignature& signature, SimulationTime now) const;
+
+	EUnloadingDispatchStrategy GetStrategy() const;
+
+private:
+	struct DispatchStation
+	{
+		UnloadingLocation* Location = nullptr;
+		SimulationTime AvailableAt = 0;
+	};
+
+	// Nearest station to a mining location. Locations never move, so this is worked out once per mining location.
+	struct NearestStation
+	{
+		MiningLocationHandle MiningLocation;
+		uint32_t StationIndex = 0;
+		SimulationTime TravelTime = 0;
+	};
+
+	SimulationTime EstimateTravelTime(MiningLocation* miningLocation, const DispatchStation& station) const;
+	const NearestStation& FindNearestStation(MiningLocation* miningLocation);
+	uint32_t FindEarliestUnloadStart(MiningLocation* miningLocation, SimulationTime now);
+	void SetAvailableAt(uint32_t stationIndex, SimulationTime availableAt);
+
+	EUnloadingDispatchStrategy Strategy = EUnloadingDispatchStrategy::ShortestQueue;
+
+	// World units per second. 0 treats travel as instant, as MiningTruck::MoveToLocation does.
+	float TravelSpeed = 0.0f;
+
+	// Indexed by the station's slot in its registry.
+	TrackedVector<DispatchStation, EMemorySubsystem::Dispatch> Stations;
+
+	// Station positions, by slot, packed for the batch distance kernel. Empty slots are placed out of reach, so they are never the nearest.
+	TrackedVector<Vector4, EMemorySubsystem::Dispatch> StationPositions;
+	std::set<std::pair<SimulationTime, uint32_t>, std::less<std::pair<SimulationTime, uint32_t>>,
+			 TrackingAllocator<std::pair<SimulationTime, uint32_t>, EMemorySubsystem::Dispatch>> StationsByAvailableAt;
+
+	// Indexed by the mining location's slot in its registry. Entries of destroyed locations are recognized by their stale handle.
+	TrackedVector<NearestStation, EMemorySubsystem::Dispatch> NearestStations;
+};
@@ -1,35 +1,35 @@
 #include "UnloadingLocation.h"
 
 /*
-* Mining Trucks are added to a Queue (std::queue) when they are done mining.
-* If the current state of the Unloading location is idle (no truck is unloading there), pop a truck Id out of the top of the queue and store the Id.
-* This store truck id will be used to request the Mining Controller to request the truck to start unloading at this unloading location.
+* Mining Trucks are added to a Queue (RingBufferQueue) when they are done mining.
+* If the current state of the Unloading location is idle (no truck is unloading there), pop a truck handle out of the top of the queue and store the handle.
+* This stored truck handle will be used to request the Mining Controller to request the truck to start unloading at this unloading location.
 */
-void UnloadingLocation::ProcessQueue(float deltaTime)
+void UnloadingLocation::ProcessQueue(SimulationTime deltaTime)
 {
 	// Ensure no truck is currently unloading.
-	if (State == EUnloadingLocationState::Idle && miningTruckUnloadingId == 0)
+	if (State == EUnloadingLocationState::Idle && !miningTruckUnloadingHandle.IsValid())
 	{
-		if (miningTruckQueue.size() == 0)
+		if (miningTruckQueue.Empty())
 		{
 			return;
 		}
 
 		// Access the next truck ready to unload.
-		miningTruckUnloadingId = miningTruckQueue.front();
-		if (miningTruckUnloadingId)
+		miningTruckUnloadingHandle = miningTruckQueue.Front();
+		if (miningTruckUnloadingHandle.IsValid())
 		{
-			miningTruckQueue.pop();
-			OnRequestMiningTruckStartUnloading.ExecuteIfBound(miningTruckUnloadingId);
+			miningTruckQueue.Pop();
+			OnRequestMiningTruckStartUnloading.ExecuteIfBound(miningTruckUnloadingHandle);
 		}
 	}
 }
 
 /*
 * Update function to process the Unloading Truck Queue.
-* The Unloading truck queue is a list of numbers that are Id's to the trucks waiting in queue (in-order).
+* The Unloading truck queue is a list of handles to the trucks waiting in queue (in-order).
 */
-void UnloadingLocation::Tick(float DeltaTime)
+void UnloadingLocation::Tick(SimulationTime DeltaTime)
 {
 	ProcessQueue(DeltaTime);
 }
@@ -37,53 +37,97 @@ void UnloadingLocation::Tick(float DeltaTime)
 /*
 * Return the total Queue Time. It's calculated as the time remaining to unload the currently active Mining truck, plus the calculated unload times of all the trucks in the queue.
 */
-float UnloadingLocation::GetQueueTime() const
+SimulationTime UnloadingLocation::GetQueueTime() const
 {
 	return totalQueueTime;
 }
 
+/*
+* Returns the number of trucks waiting in the queue. The truck currently unloading isn't counted.
+*/
+unsigned int UnloadingLocation::GetQueueLength() const
+{
+	return miningTruckQueue.Size();
+}
+
+/*
+* Returns the truck taken from the queue to unload here. Invalid while the station waits for the next truck.
+*/
+MiningTruckHandle UnloadingLocation::GetUnloadingMiningTruck() const
+{
+	return miningTruckUnloadingHandle;
+}
+
 /*
 * Unloads some Helium. The amount is determined by deltaUnloadingTime. This simulation is assuming Time = Helium. Therefore 1 second = 1 Helium.
 */
-void UnloadingLocation::UnloadHelium(float deltaUnloadingTime)
+void UnloadingLocation::UnloadHelium(SimulationTime deltaUnloadingTime)
 {
 	// Update how much time has been spend unloading.
 	totalTimeUnloading += deltaUnloadingTime;
 
 	totalQueueTime -= deltaUnloadingTime;
-	if (totalQueueTime <= 0.0f)
+	if (totalQueueTime <= 0)
 	{
-		totalQueueTime = 0.0f;
+		totalQueueTime = 0;
 	}
 }
 
 /*
 * Adds a truck to the Unloading Queue.
-* Trucks are added to a std::queue after being checked against a std::unordered_set to prevent re-adding the same truck to the queue more than once.
+* Trucks are added to a RingBufferQueue after checking the station they are tracked at, to prevent re-adding the same truck to the queue more than once.
 * This allows us to check errors and add logging since a truck can only be in a single queue, and only once at a time.
 */
-void UnloadingLocation::AddMiningTruckToQueue(BaseEntity* miningTruckPtr)
+void UnloadingLocation::AddMiningTruckToQueue(MiningTruck* miningTruck)
 {
 	// Cannot add invalid truck.
-	MiningTruck* miningTruck = reinterpret_cast<MiningTruck*>(miningTruckPtr);
 	if (!miningTruck)
 	{
 		return;
 	}
 
-	unsigned int miningTruckID = miningTruck->GetUniqueId();
-
-	// Check if Truck is already in queue.
-	if (trackedMiningTruckIds.find(miningTruckID) != trackedMiningTruckIds.end())
+	// Check if Truck is already in a queue.
+	if (miningTruck->GetQueuedUnloadingLocation().IsValid())
 	{
 		return;
 	}
 
-	miningTruckQueue.emplace(miningTruckID);
-	trackedMiningTruckIds.emplace(miningTruckID);
+	miningTruckQueue.Push(miningTruck->GetHandle());
+	SetMiningTruckTracked(miningTruck, true);
 	totalQueueTime += miningTruck->GetRemainingUnloadingTime();
 }
 
+/*
+* Pre-allocates the Unloading Queue. Called once when the station is spawned with the station's share of the fleet, so storage across every
+* station stays proportional to the fleet. A queue that grows past it doubles, so it only allocates a handful of times over a run.
+*/
+void UnloadingLocation::ReserveQueueCapacity(unsigned int capacity)
+{
+	miningTruckQueue.Reserve(capacity);
+}
+
+/*
+* Returns true if the truck is queued or unloading at this station.
+*/
+bool UnloadingLocation::IsMiningTruckTracked(const MiningTruck* miningTruck) const
+{
+	return miningTruck->GetQueuedUnloadingLocation() == GetHandle();
+}
+
+/*
+* Marks the truck as tracked here or clears it, keeping a count of tracked trucks so "is anyone waiting" doesn't need to look at the queue.
+*/
+void UnloadingLocation::SetMiningTruckTracked(MiningTruck* miningTruck, bool tracked)
+{
+	if (tracked == IsMiningTruckTracked(miningTruck))
+	{
+		return;
+	}
+
+	miningTruck->SetQueuedUnloadingLocation(tracked ? GetHandle() : UnloadingLocationHandle());
+	numTrackedMiningTrucks += tracked ? 1 : -1;
+}
+
 /*
 * Return the current state of the Unloading station.
 */
@@ -96,7 +140,7 @@ EUnloadingLocationState UnloadingLocation::GetState() const
 * Get the amount of time the station has spend unloading since the start of the simulation.
 * This value is used in calculating the efficiency of the Unloading Station.
 */
-double UnloadingLocation::GetTotalUnloadingTime() const
+SimulationTime UnloadingLocation::GetTotalUnloadingTime() const
 {
 	return totalTimeUnloading;
 }
@@ -113,24 +157,46 @@ void UnloadingLocation::SetState(EUnloadingLocationState newState)
 	}
 }
 
+/*
+* Appends the station state, the truck currently unloading, the queue time, and the order of the trucks waiting in the queue to a state signature.
+*/
+void UnloadingLocation::AppendStateSignature(StateSignature& signature) const
+{
+	signature.push_back(static_cast<uint64_t>(State));
+	signature.push_back(miningTruckUnloadingHandle.Pack());
+	signature.push_back(static_cast<uint64_t>(totalQueueTime));
+	for (unsigned int i = 0; i < miningTruckQueue.Size(); ++i)
+	{
+		signature.push_back(miningTruckQueue[i].Pack());
+	}
+}
+
+/*
+* Adds unloading time from extrapolated simulation time to the station's total.
+*/
+void UnloadingLocation::AddExtrapolatedUnloadingTime(SimulationTime unloadingTime)
+{
+	totalTimeUnloading += unloadingTime;
+}
+
 /*
 * As Mining trucks complete their unloading cylce, this function is called.
-* A check is made to ensure that the truck completing it's unloading is the same as the expected truck Id.
-* The Id is reset to 0 so a new truck can be processed from the queue, and the old Id is removed from the unordered_set to allow the finishing truck to re-visit this unloading station.
+* A check is made to ensure that the truck completing it's unloading is the same as the expected truck handle.
+* The handle is reset so a new truck can be processed from the queue, and the truck is no longer tracked here, allowing the finishing truck to re-visit this unloading station.
 */
-void UnloadingLocation::MiningTruckUnloadingFinished(unsigned int truckUniqueId)
+void UnloadingLocation::MiningTruckUnloadingFinished(MiningTruck* miningTruck)
 {
-	if (truckUniqueId != miningTruckUnloadingId)
+	if (!miningTruck || miningTruck->GetHandle() != miningTruckUnloadingHandle)
 	{
 		return;
 	}
 	
 	// Unloading has finished. Clear the active unloading truck so the next one can start unloading.
-	miningTruckUnloadingId = 0;
-	trackedMiningTruckIds.erase(truckUniqueId);
-	if (trackedMiningTruckIds.empty())
+	miningTruckUnloadingHandle = MiningTruckHandle();
+	SetMiningTruckTracked(miningTruck, false);
+	if (numTrackedMiningTrucks == 0)
 	{
 		// If we are not waiting for any trucks to unload, then we can set the queue time back to 0.
-		totalQueueTime = 0.0f;
+		totalQueueTime = 0;
 	}
 }
\ No newline at end of file
@@ -2,9 +2,10 @@
 
 #include "BaseEntity.h"
 #include "MiningTruck.h"
+#include "RingBufferQueue.h"
 
-#include <queue>
-#include <unordered_set>
+#include <cstdint>
+#include <vector>
 
 enum class EUnloadingLocationState : size_t
 {
@@ -12,38 +13,54 @@ enum class EUnloadingLocationState : size_t
 	Unloading  // The unloading location is actively unloading Helium-3 from a mining truck.
 };
 
-class UnloadingLocation : public BaseEntity
+class UnloadingLocation;
+using UnloadingLocationHandle = EntityHandle<UnloadingLocation>;
+
+class UnloadingLocation final : public TypedEntity<UnloadingLocation>
 {
 public:	
-	
+	// Memory accounting bucket the entity is counted in while it is owned by an EntityPool.
+	static constexpr EMemorySubsystem MemorySubsystem = EMemorySubsystem::UnloadingLocations;
+
 	UnloadingLocation() = default;
 	~UnloadingLocation() override = default;
 
-	virtual void Tick(float deltaTime);
-	float GetQueueTime() const;
-	void UnloadHelium(float deltaUnloadingTime);
-	void AddMiningTruckToQueue(BaseEntity* miningTruck);
+	void Tick(SimulationTime deltaTime);
+	SimulationTime GetQueueTime() const;
+	unsigned int GetQueueLength() const;
+	MiningTruckHandle GetUnloadingMiningTruck() const;
+	void UnloadHelium(SimulationTime deltaUnloadingTime);
+	void AddMiningTruckToQueue(MiningTruck* miningTruck);
+	void ReserveQueueCapacity(unsigned int capacity);
 	EUnloadingLocationState GetState() const;
-	double GetTotalUnloadingTime() const;
+	SimulationTime GetTotalUnloadingTime() const;
 
 	void SetState(EUnloadingLocationState newState);
-	void MiningTruckUnloadingFinished(unsigned int truckUniqueId);
+	void MiningTruckUnloadingFinished(MiningTruck* miningTruck);
+
+	// Appends the values that determine how this station will behave from now on. Used to detect when the simulation becomes periodic.
+	void AppendStateSignature(StateSignature& signature) const;
+
+	// Credits time spent unloading during simulation time that was extrapolated rather than simulated.
+	void AddExtrapolatedUnloadingTime(SimulationTime unloadingTime);
 
-	Delegate<unsigned int> OnRequestMiningTruckStartUnloading;
+	Delegate<MiningTruckHandle> OnRequestMiningTruckStartUnloading;
 
 private:
-	void ProcessQueue(float deltaTime);
+	void ProcessQueue(SimulationTime deltaTime);
+	bool IsMiningTruckTracked(const MiningTruck* miningTruck) const;
+	void SetMiningTruckTracked(MiningTruck* miningTruck, bool tracked);
 
 	EUnloadingLocationState State = EUnloadingLocationState::Idle;
 
-	// Queue of Trucks ready / waiting to unload.
-	std::queue<unsigned int> miningTruckQueue;
+	// Queue of Trucks ready / waiting to unload. Reserved for the station's share of the fleet, and doubles if a longer queue ever forms.
+	RingBufferQueue<MiningTruckHandle, TrackingAllocator<MiningTruckHandle, EMemorySubsystem::UnloadingQueues>> miningTruckQueue;
 
-	// Set of IDs of trucks in the queue to disallow duplicate trucks being added to the queue.
-	std::unordered_set<unsigned int> trackedMiningTruckIds;
-	unsigned int miningTruckUnloadingId = 0;
-	float totalQueueTime = 0.0f;
+	// Trucks queued or unloading here. Each truck records the station it is tracked at, to disallow duplicate trucks being added to the queue.
+	unsigned int numTrackedMiningTrucks = 0;
+	MiningTruckHandle miningTruckUnloadingHandle;
+	SimulationTime totalQueueTime = 0;
 
 	// Will accumulate the amount of time spent unloading for each mining truck that visits the station.
-	double totalTimeUnloading = 0.0;
+	SimulationTime totalTimeUnloading = 0;
 };
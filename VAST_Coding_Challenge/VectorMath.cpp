@@ -0,0 +1,181 @@
+#include "VectorMath.h"
+
+#include <cmath>
+#include <limits>
+
+#if VAST_VECTOR_MATH_SSE
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	float ScalarDistance(const Vector4& lhs, const Vector4& rhs)
+	{
+		float x = lhs.X - rhs.X;
+		float y = lhs.Y - rhs.Y;
+		float z = lhs.Z - rhs.Z;
+		return sqrtf(x * x + y * y + z * z);
+	}
+
+	void ScalarNormalize(Vector4& vector)
+	{
+		float lengthSquared = vector.X * vector.X + vector.Y * vector.Y + vector.Z * vector.Z;
+		if (lengthSquared > 0.0f)
+		{
+			float inverseLength = 1.0f / sqrtf(lengthSquared);
+			vector.X *= inverseLength;
+			vector.Y *= inverseLength;
+			vector.Z *= inverseLength;
+		}
+	}
+}
+
+void VectorMath::Distances(const Vector4* points, size_t numPoints, const Vector4& origin, float* outDistances)
+{
+	size_t i = 0;
+
+#if VAST_VECTOR_MATH_SSE
+	__m128 originX = _mm_set1_ps(origin.X);
+	__m128 originY = _mm_set1_ps(origin.Y);
+	__m128 originZ = _mm_set1_ps(origin.Z);
+	for (; i + 4 <= numPoints; i += 4)
+	{
+		__m128 x = _mm_load_ps(&points[i].X);
+		__m128 y = _mm_load_ps(&points[i + 1].X);
+		__m128 z = _mm_load_ps(&points[i + 2].X);
+		__m128 w = _mm_load_ps(&points[i + 3].X);
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+
+		x = _mm_sub_ps(x, originX);
+		y = _mm_sub_ps(y, originY);
+		z = _mm_sub_ps(z, originZ);
+		__m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+		_mm_storeu_ps(outDistances + i, _mm_sqrt_ps(lengthSquared));
+	}
+#endif
+
+	for (; i < numPoints; ++i)
+	{
+		outDistances[i] = ScalarDistance(points[i], origin);
+	}
+}
+
+size_t VectorMath::FindNearest(const Vector4* points, size_t numPoints, const Vector4& origin, float* outDistance /* = nullptr */)
+{
+	size_t nearestIndex = 0;
+	float nearestDistance = std::numeric_limits<float>::max();
+
+	// Distances are worked out a block at a time, so the vectorized kernel can be used without a heap allocated buffer.
+	constexpr size_t BlockSize = 64;
+	float distances[BlockSize];
+	for (size_t blockStart = 0; blockStart < numPoints; blockStart += BlockSize)
+	{
+		size_t blockSize = numPoints - blockStart < BlockSize ? numPoints - blockStart : BlockSize;
+		Distances(points + blockStart, blockSize, origin, distances);
+		for (size_t i = 0; i < blockSize; ++i)
+		{
+			if (distances[i] < nearestDistance)
+			{
+				nearestDistance = distances[i];
+				nearestIndex = blockStart + i;
+			}
+		}
+	}
+
+	if (outDistance)
+	{
+		*outDistance = nearestDistance;
+	}
+	return nearestIndex;
+}
+
+void VectorMath::Normalize(Vector4* vectors, size_t numVectors)
+{
+	size_t i = 0;
+
+#if VAST_VECTOR_MATH_SSE
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 threeHalves = _mm_set1_ps(1.5f);
+	const __m128 zero = _mm_setzero_ps();
+	for (; i + 4 <= numVectors; i += 4)
+	{
+		__m128 x = _mm_load_ps(&vectors[i].X);
+		__m128 y = _mm_load_ps(&vectors[i + 1].X);
+		__m128 z = _mm_load_ps(&vectors[i + 2].X);
+		__m128 w = _mm_load_ps(&vectors[i + 3].X);
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+
+		__m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+
+		// rsqrt estimate (12 bits), then one Newton-Raphson step: r = r * (1.5 - 0.5 * lengthSquared * r * r).
+		__m128 inverseLength = _mm_rsqrt_ps(lengthSquared);
+		__m128 halfLengthSquared = _mm_mul_ps(half, lengthSquared);
+		inverseLength = _mm_mul_ps(inverseLength, _mm_sub_ps(threeHalves, _mm_mul_ps(halfLengthSquared, _mm_mul_ps(inverseLength, inverseLength))));
+
+		// rsqrt(0) is infinity, keep zero length vectors at zero instead.
+		inverseLength = _mm_and_ps(inverseLength, _mm_cmpgt_ps(lengthSquared, zero));
+
+		x = _mm_mul_ps(x, inverseLength);
+		y = _mm_mul_ps(y, inverseLength);
+		z = _mm_mul_ps(z, inverseLength);
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		_mm_store_ps(&vectors[i].X, x);
+		_mm_store_ps(&vectors[i + 1].X, y);
+		_mm_store_ps(&vectors[i + 2].X, z);
+		_mm_store_ps(&vectors[i + 3].X, w);
+	}
+#endif
+
+	for (; i < numVectors; ++i)
+	{
+		ScalarNormalize(vectors[i]);
+	}
+}
+
+float VectorMath::PolylineLength(const Vector4* points, size_t numPoints)
+{
+	if (numPoints < 2)
+	{
+		return 0.0f;
+	}
+
+	size_t numSegments = numPoints - 1;
+	size_t i = 0;
+	float length = 0.0f;
+
+#if VAST_VECTOR_MATH_SSE
+	// Segment i runs from points[i] to points[i + 1]. Four segments at a time: the start points are aligned loads, the end points are the
+	// same array one element on.
+	__m128 lengths = _mm_setzero_ps();
+	for (; i + 4 <= numSegments; i += 4)
+	{
+		__m128 startX = _mm_load_ps(&points[i].X);
+		__m128 startY = _mm_load_ps(&points[i + 1].X);
+		__m128 startZ = _mm_load_ps(&points[i + 2].X);
+		__m128 startW = _mm_load_ps(&points[i + 3].X);
+		_MM_TRANSPOSE4_PS(startX, startY, startZ, startW);
+
+		__m128 endX = _mm_load_ps(&points[i + 1].X);
+		__m128 endY = _mm_load_ps(&points[i + 2].X);
+		__m128 endZ = _mm_load_ps(&points[i + 3].X);
+		__m128 endW = _mm_load_ps(&points[i + 4].X);
+		_MM_TRANSPOSE4_PS(endX, endY, endZ, endW);
+
+		__m128 x = _mm_sub_ps(endX, startX);
+		__m128 y = _mm_sub_ps(endY, startY);
+		__m128 z = _mm_sub_ps(endZ, startZ);
+		__m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+		lengths = _mm_add_ps(lengths, _mm_sqrt_ps(lengthSquared));
+	}
+
+	alignas(16) float laneLengths[4];
+	_mm_store_ps(laneLengths, lengths);
+	length = (laneLengths[0] + laneLengths[1]) + (laneLengths[2] + laneLengths[3]);
+#endif
+
+	for (; i < numSegments; ++i)
+	{
+		length += ScalarDistance(points[i + 1], points[i]);
+	}
+	return length;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "Global.h"
+
+#include <cstddef>
+
+// SSE is part of every x64 target. Other targets use the scalar versions of the kernels below.
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#define VAST_VECTOR_MATH_SSE 1
+#else
+#define VAST_VECTOR_MATH_SSE 0
+#endif
+
+/*
+* 16 byte aligned, 4 lane version of Vector, for arrays of positions the batch kernels below work on.
+* W is padding: the kernels ignore it and leave it as it is.
+*/
+struct alignas(16) Vector4
+{
+	Vector4() = default;
+	Vector4(float in_X, float in_Y, float in_Z, float in_W = 0.0f) : X(in_X), Y(in_Y), Z(in_Z), W(in_W) {};
+	explicit Vector4(const Vector& vector) : X(vector.X), Y(vector.Y), Z(vector.Z), W(0.0f) {};
+
+	Vector ToVector() const
+	{
+		return Vector(X, Y, Z);
+	}
+
+	float X = 0.0f;
+	float Y = 0.0f;
+	float Z = 0.0f;
+	float W = 0.0f;
+};
+
+/*
+* Geometry kernels over arrays of Vector4. With SSE, four vectors are processed at a time: they are loaded and transposed so each register
+* holds the same component of four vectors, and every length is computed in parallel.
+*/
+namespace VectorMath
+{
+	// outDistances[i] = distance from points[i] to origin.
+	void Distances(const Vector4* points, size_t numPoints, const Vector4& origin, float* outDistances);
+
+	// Index of the point closest to origin (0 if there are no points).
+	size_t FindNearest(const Vector4* points, size_t numPoints, const Vector4& origin, float* outDistance = nullptr);
+
+	// Normalizes every vector in place. Only a direction is needed, so this uses the reciprocal square root estimate refined by one
+	// Newton-Raphson step (relative error around 1e-6) instead of a square root and three divides. Zero length vectors stay zero.
+	void Normalize(Vector4* vectors, size_t numVectors);
+
+	// Length of the path through every point in order. Uses an exact square root, as lengths feed travel times.
+	float PolylineLength(const Vector4* points, size_t numPoints);
+}
@@ -1,13 +1,131 @@
 #include "Global.h"
 #include "MiningTruckController.h"
+#include "BufferedFileWriter.h"
+#include "EfficiencyResultsWriter.h"
+#include "MetricsExporter.h"
+#include "MultiSiteSimulationCoordinator.h"
+#include "QueueingModelEstimator.h"
+#include "ScenarioFileReader.h"
+#include "SimulationPacer.h"
+#include "SimulationService.h"
+#include "SimulationTestSuite.h"
+#include "SimulationTrace.h"
+#include "StationCountOptimizer.h"
+#include "TerminalDashboard.h"
 
-#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
-#include <thread>
 
-void RunTestSuite()
+/*
+* Runs the testing strategies described in the README. Returns the number of failed checks.
+*/
+unsigned int RunTestSuite()
+{
+	SimulationTestSuite testSuite;
+	return testSuite.Run();
+}
+
+/*
+* Runs several mining sites in parallel (one per core), with trucks being transferred between sites during the run.
+* Adjust the sites and transfers below, the same way the single site simulation is configured in main().
+*/
+void RunMultiSiteSimulation()
 {
-	// Run Through a Suite of Unit tests here.
+	MultiSiteConfiguration multiSiteConfig;
+
+	SimulationConfiguration siteConfig;
+	siteConfig.NumMiningTrucksToSpawn = 10;
+	siteConfig.NumUnloadingLocationsToSpawn = 3;
+	siteConfig.MiningAndUnloadingTimes.MinMiningTimeHours = 1.0f;
+	siteConfig.MiningAndUnloadingTimes.MaxMiningTimeHours = 5.0f;
+	siteConfig.SimulationMaxTimeSeconds = 259200.0f;
+
+	// Four sites, the last one with twice the fleet.
+	multiSiteConfig.Sites.assign(4, siteConfig);
+	multiSiteConfig.Sites[3].NumMiningTrucksToSpawn = 20;
+
+	// After 24 hours, move 5 trucks from the big site to the first site.
+	SiteTruckTransfer transfer;
+	transfer.FromSite = 3;
+	transfer.ToSite = 0;
+	transfer.TimeSeconds = 86400.0f;
+	transfer.NumMiningTrucks = 5;
+	multiSiteConfig.Transfers.push_back(transfer);
+
+	MultiSiteSimulationCoordinator coordinator;
+	MultiSiteOperationEfficiency multiSiteEfficiency = coordinator.Run(multiSiteConfig);
+	multiSiteEfficiency.Print();
+}
+
+/*
+* Runs every scenario in a CSV or JSON-lines file, writing one result line per scenario.
+* Scenarios are streamed out of the file one at a time and run back to back on the same controller.
+*/
+int RunScenarioBatch(const std::string& scenarioPath, const std::string& resultsPath)
+{
+	std::string error;
+	ScenarioFileReader scenarioReader;
+	if (!scenarioReader.Open(scenarioPath, error))
+	{
+		std::cout << error << std::endl;
+		return 1;
+	}
+
+	BufferedFileWriter resultsWriter;
+	if (!resultsWriter.Open(resultsPath))
+	{
+		std::cout << "unable to open " << resultsPath << std::endl;
+		return 1;
+	}
+
+	MiningTruckController miningTruckSim;
+	SimulationConfiguration config;
+	unsigned int scenarioIndex = 0;
+
+	resultsWriter.Write(std::string("scenario,line,trucks,stations,global_efficiency,error\n"));
+	while (scenarioReader.Next(config, error))
+	{
+		if (!error.empty())
+		{
+			resultsWriter.WriteFormatted("%u,%u,,,,%s\n", scenarioIndex++, scenarioReader.GetLineNumber(), error.c_str());
+			continue;
+		}
+
+		config.LogSimulationTime = false;
+		OperationEfficiency operationEfficiency = miningTruckSim.RunSimulation(config);
+		resultsWriter.WriteFormatted("%u,%u,%d,%d,%.6f,\n", scenarioIndex++, scenarioReader.GetLineNumber(),
+									 config.NumMiningTrucksToSpawn, config.NumUnloadingLocationsToSpawn, operationEfficiency.GlobalEfficiency);
+	}
+
+	if (!resultsWriter.Close())
+	{
+		std::cout << "unable to write " << resultsPath << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+/*
+* Searches for the number of Unloading Stations (and fleet size) worth building, instead of trying station counts by hand.
+* Adjust the base configuration and the settings below the same way the single site simulation is configured in main().
+*/
+void RunStationOptimizer()
+{
+	SimulationConfiguration baseConfig;
+	baseConfig.NumMiningTrucksToSpawn = 10;
+	baseConfig.SimulationMaxTimeSeconds = 259200.0f;
+
+	StationOptimizerSettings settings;
+	settings.Goal = EStationOptimizerGoal::MarginalGain;
+	settings.MinMarginalGainPerStation = 0.05f;
+	settings.MaxUnloadingLocations = 10;
+	settings.FleetSizes = { 5, 10, 20 };
+
+	StationCountOptimizer optimizer;
+	StationOptimizerResult result = optimizer.Optimize(baseConfig, settings);
+	result.Print();
 }
 
 /*
@@ -15,8 +133,49 @@ void RunTestSuite()
 * Adjust the values below for Num Truck and Unloading Stations etc + Mining Time and Unloading times and see the various outputs with the Simulation Runtime set to different values.
 * When the simulation is done running, it will print out the efficiency of each truck, unload station, and a global overall efficiency.
 */
-int main()
+int main(int argc, char* argv[])
 {
+	// Exits with a non zero code if any check fails.
+	if (argc > 1 && strcmp(argv[1], "--test") == 0)
+	{
+		return RunTestSuite() == 0 ? 0 : 1;
+	}
+
+	if (argc > 1 && strcmp(argv[1], "--multi-site") == 0)
+	{
+		RunMultiSiteSimulation();
+		return 0;
+	}
+
+	if (argc > 1 && strcmp(argv[1], "--optimize-stations") == 0)
+	{
+		RunStationOptimizer();
+		return 0;
+	}
+
+	// Run a batch of scenarios from a file: --batch <scenarios.csv | scenarios.jsonl> <results.csv | ->
+	if (argc > 3 && strcmp(argv[1], "--batch") == 0)
+	{
+		return RunScenarioBatch(argv[2], argv[3]);
+	}
+
+	// Run as a local simulation service: --service [socket path] [number of workers]
+	if (argc > 1 && strcmp(argv[1], "--service") == 0)
+	{
+		SimulationServiceConfiguration serviceConfig;
+		if (argc > 2)
+		{
+			serviceConfig.SocketPath = argv[2];
+		}
+		if (argc > 3)
+		{
+			serviceConfig.NumWorkers = static_cast<unsigned int>(atoi(argv[3]));
+		}
+
+		SimulationService service;
+		return service.Run(serviceConfig);
+	}
+
 	// MiningTruckController holds all the logic required to run the simulation as defined in the Coding Challenge.
 	MiningTruckController miningTruckSim;
 
@@ -36,20 +195,150 @@ int main()
 	// 72 - Hours. Change this to see the differences in efficiency outputs.
 	config.SimulationMaxTimeSeconds = 259200.0f;
 
+	// Set above 0 to end the simulation as soon as global efficiency is known to within +/- this value (95% confidence).
+	config.ConvergenceTolerance = 0.0f;
+
+	// Playback speed: simulated seconds per real second. Run faster than real time with: --speed <1 to 10000>
+	if (argc > 2 && strcmp(argv[1], "--speed") == 0)
+	{
+		miningTruckSim.SetPlaybackSpeed(static_cast<float>(atof(argv[2])));
+	}
+
+	if (argc > 2 && strcmp(argv[1], "--timeseries") == 0)
+	{
+		config.TimeSeriesIntervalSeconds = 60.0f;
+	}
+
+	// The dashboard shows the remaining time, don't print it every tick as well.
+	config.LogSimulationTime = false;
+
+	// Log every state change to a CSV file, written on a thread of its own so the simulation never waits on the disk: --events <file>
+	BufferedFileWriter eventLog;
+	if (argc > 2 && strcmp(argv[1], "--events") == 0 && eventLog.Open(argv[2]))
+	{
+		static const char* const EventTypeNames[] = { "truck", "station", "site" };
+		eventLog.Write(std::string("sequence,time_seconds,type,index,generation,previous_state,new_state\n"));
+		miningTruckSim.GetEventBus().Subscribe([&eventLog](const SimulationEvent& event) {
+			eventLog.WriteFormatted("%llu,%.3f,%s,%u,%u,%u,%u\n", static_cast<unsigned long long>(event.Sequence), SimulationTimeToSeconds(event.Time),
+									EventTypeNames[static_cast<size_t>(event.Type)], event.EntityIndex, event.EntityGeneration, event.PreviousState, event.NewState);
+		});
+	}
+
+	// Serve live metrics in the Prometheus text format to anything connecting to a Unix socket: --metrics <socket path> [textfile]
+	SimulationMetrics metrics;
+	MetricsExporter metricsExporter;
+	if (argc > 2 && strcmp(argv[1], "--metrics") == 0)
+	{
+		MetricsExporterConfiguration exporterConfig;
+		exporterConfig.SocketPath = argv[2];
+		if (argc > 3)
+		{
+			exporterConfig.FilePath = argv[3];
+		}
+
+		std::string error;
+		if (metricsExporter.Start(metrics, exporterConfig, error))
+		{
+			miningTruckSim.SetMetrics(&metrics);
+		}
+		else
+		{
+			std::cerr << "Metrics disabled, " << error << "\n";
+		}
+	}
+
+	// Record a timeline of the run, to open in chrome://tracing or ui.perfetto.dev: --trace <file.json>
+	// Needs a build with VAST_ENABLE_TRACING defined to 1, the markers are compiled out otherwise.
+	bool tracing = argc > 2 && strcmp(argv[1], "--trace") == 0;
+	if (tracing)
+	{
+		if (!VAST_ENABLE_TRACING)
+		{
+			std::cout << "Tracing is compiled out of this build, define VAST_ENABLE_TRACING=1 to record a trace." << std::endl;
+		}
+		TRACE_THREAD_NAME("Main");
+
+		// A one second step records about ten markers. Size the buffers for the whole run so a long trace isn't cut off part way.
+		constexpr size_t TraceEventsPerSimulatedSecond = 16;
+		SimulationTrace::Start(std::max(static_cast<size_t>(config.SimulationMaxTimeSeconds) * TraceEventsPerSimulatedSecond,
+										SimulationTrace::DefaultMaxEventsPerThread));
+	}
+
 	miningTruckSim.StartSimulation(config);
 
+	// Ticks are paced against the wall clock. If a tick takes too long, the next one covers the time that was missed.
+	SimulationPacer pacer;
+	pacer.Start(miningTruckSim.GetPlaybackSpeed());
+
+	// Redrawn a few times a second however fast the simulation is playing back.
+	TerminalDashboard dashboard;
+	dashboard.Start();
+
 	bool exit = false;
 	while (!exit)
 	{
-		exit = miningTruckSim.Tick(1.0f);
-		std::this_thread::sleep_for(std::chrono::seconds(1));
+		pacer.SetPlaybackSpeed(miningTruckSim.GetPlaybackSpeed());
+		exit = miningTruckSim.Tick(pacer.WaitForNextTick());
 
-		system("cls");
+		dashboard.Update(miningTruckSim);
 	}
 
-	// Clean up the simulation.
+	dashboard.Draw(miningTruckSim);
+	dashboard.Stop();
+
+	// Clean up the simulation. The event log is closed once its consumer has written every event.
 	OperationEfficiency operationEfficiency = miningTruckSim.Teardown();
+	miningTruckSim.GetEventBus().UnsubscribeAll();
+	if (!eventLog.Close())
+	{
+		std::cout << "unable to write " << argv[2] << '\n';
+	}
+	metricsExporter.Stop();
+	miningTruckSim.SetMetrics(nullptr);
+
+	if (tracing)
+	{
+		SimulationTrace::Stop();
+		std::string error;
+		if (!SimulationTrace::WriteChromeJson(argv[2], error))
+		{
+			std::cout << error << '\n';
+		}
+
+		uint64_t numDropped = SimulationTrace::GetNumDropped();
+		if (numDropped > 0)
+		{
+			std::cout << "Trace buffers filled up, " << numDropped << " events were dropped from the end of the trace." << '\n';
+		}
+	}
 	operationEfficiency.Print();
+	SimulationPolicies::Instrumentation::Print();
+
+	// How efficiency, truck states and station queues evolved over the run, sampled every simulated minute: --timeseries <file.csv>
+	if (argc > 2 && strcmp(argv[1], "--timeseries") == 0)
+	{
+		std::string error;
+		if (!miningTruckSim.GetTimeSeries().WriteCsv(argv[2], error))
+		{
+			std::cout << error << '\n';
+		}
+	}
+
+	// Every truck's and station's efficiency, for fleets too large to read on the console: --results <file.csv | file.bin>
+	if (argc > 2 && strcmp(argv[1], "--results") == 0)
+	{
+		std::string error;
+		if (!WriteEfficiencyResults(operationEfficiency, argv[2], GetEfficiencyResultsFormat(argv[2]), error))
+		{
+			std::cout << error << '\n';
+		}
+	}
+
+	// What queueing theory expected of this configuration, for comparison.
+	QueueingModelEstimator estimator;
+	QueueingModelEstimate estimate = estimator.Estimate(config);
+	estimate.Print();
+	estimate.PrintDeviation(operationEfficiency);
 	return 0;
 }
 